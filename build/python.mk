@@ -8,6 +8,7 @@ PYTHON_SOURCES = \
 	$(DEBUG_REPLAY_SOURCES) \
 	$(SRC)/IGC/IGCFix.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
 	$(SRC)/Computer/CirclingComputer.cpp \
         $(SRC)/Computer/Wind/Settings.cpp \
@@ -50,7 +51,7 @@ PYTHON_SOURCES = \
 	$(ENGINE_SRC_DIR)/Airspace/AirspaceAircraftPerformance.cpp \
 	$(ENGINE_SRC_DIR)/Airspace/Predicate/AirspacePredicate.cpp \
 	$(SRC)/NMEA/Aircraft.cpp
-PYTHON_LDADD = $(DEBUG_REPLAY_LDADD)
+PYTHON_LDADD = $(CONTEST_LIBS) $(DEBUG_REPLAY_LDADD)
 PYTHON_LDLIBS = $(shell python-config --ldflags)
 PYTHON_DEPENDS = CONTEST WAYPOINT UTIL ZZIP GEO MATH TIME
 PYTHON_CPPFLAGS = $(shell python-config --includes) \
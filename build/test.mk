@@ -64,6 +64,7 @@ TEST1_LDLIBS = \
 define link-harness-program
 $(1)_SOURCES = \
 	$(SRC)/Engine/Trace/Point.cpp \
+	$(SRC)/Engine/Trace/Snapshot.cpp \
 	$(SRC)/Engine/Trace/Trace.cpp \
 	$(SRC)/Engine/Trace/Vector.cpp \
 	$(SRC)/Engine/Navigation/Aircraft.cpp \
@@ -95,7 +96,11 @@ TEST_NAMES = \
 	TestUnits TestEarth TestSunEphemeris \
 	TestValidity TestUTM TestProfile \
 	TestAllocatedGrid \
-	TestRadixTree TestGeoBounds TestGeoClip \
+	TestHeightInterpolation \
+	TestRadixTree TestCandidateQueue TestFlatHashMap TestIndexedHeap \
+	TestRcuDomain \
+	TestEdgeBandIndex \
+	TestGeoBounds TestGeoClip \
 	TestLogger TestGRecord TestDriver TestClimbAvCalc \
 	TestWaypointReader TestThermalBase \
 	TestFlarmNet \
@@ -111,6 +116,8 @@ TEST_NAMES = \
 	TestAirspaceParser \
 	TestMETARParser \
 	TestIGCParser \
+	TestContestDijkstra \
+	TestTriangleContest \
 	TestByteOrder \
 	TestByteOrder2 \
 	TestStrings TestUTF8 \
@@ -162,6 +169,32 @@ TEST_OVERWRITING_RING_BUFFER_SOURCES = \
 TEST_OVERWRITING_RING_BUFFER_DEPENDS = MATH
 $(eval $(call link-program,TestOverwritingRingBuffer,TEST_OVERWRITING_RING_BUFFER))
 
+TEST_CANDIDATE_QUEUE_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestCandidateQueue.cpp
+$(eval $(call link-program,TestCandidateQueue,TEST_CANDIDATE_QUEUE))
+
+TEST_FLAT_HASH_MAP_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestFlatHashMap.cpp
+$(eval $(call link-program,TestFlatHashMap,TEST_FLAT_HASH_MAP))
+
+TEST_INDEXED_HEAP_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestIndexedHeap.cpp
+$(eval $(call link-program,TestIndexedHeap,TEST_INDEXED_HEAP))
+
+TEST_RCU_DOMAIN_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestRcuDomain.cpp
+$(eval $(call link-program,TestRcuDomain,TEST_RCU_DOMAIN))
+
+TEST_EDGE_BAND_INDEX_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestEdgeBandIndex.cpp
+TEST_EDGE_BAND_INDEX_DEPENDS = GEO MATH
+$(eval $(call link-program,TestEdgeBandIndex,TEST_EDGE_BAND_INDEX))
+
 TEST_IGC_PARSER_SOURCES = \
 	$(SRC)/IGC/IGCParser.cpp \
 	$(TEST_SRC_DIR)/tap.c \
@@ -191,6 +224,7 @@ $(eval $(call link-program,TestMETARParser,TEST_METAR_PARSER))
 
 TEST_AIRSPACE_PARSER_SOURCES = \
 	$(SRC)/Airspace/AirspaceParser.cpp \
+	$(SRC)/Airspace/AirspaceCache.cpp \
 	$(SRC)/Units/Descriptor.cpp \
 	$(SRC)/Units/System.cpp \
 	$(SRC)/Operation/Operation.cpp \
@@ -201,7 +235,7 @@ TEST_AIRSPACE_PARSER_SOURCES = \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/TestAirspaceParser.cpp
 TEST_AIRSPACE_PARSER_LDADD = $(FAKE_LIBS)
-TEST_AIRSPACE_PARSER_DEPENDS = IO OS AIRSPACE ZZIP GEO MATH UTIL
+TEST_AIRSPACE_PARSER_DEPENDS = IO OS THREAD AIRSPACE ZZIP GEO MATH UTIL
 $(eval $(call link-program,TestAirspaceParser,TEST_AIRSPACE_PARSER))
 
 TEST_DATE_TIME_SOURCES = \
@@ -300,7 +334,7 @@ TEST_TROUTE_SOURCES = \
 	$(TEST_SRC_DIR)/Printing.cpp \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/test_troute.cpp
-TEST_TROUTE_DEPENDS = TERRAIN IO ZZIP OS ROUTE GLIDE GEO MATH UTIL
+TEST_TROUTE_DEPENDS = TERRAIN THREAD IO ZZIP OS ROUTE GLIDE GEO MATH UTIL
 $(eval $(call link-program,test_troute,TEST_TROUTE))
 
 TEST_REACH_SOURCES = \
@@ -309,7 +343,7 @@ TEST_REACH_SOURCES = \
 	$(TEST_SRC_DIR)/Printing.cpp \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/test_reach.cpp
-TEST_REACH_DEPENDS = TERRAIN IO ZZIP OS ROUTE GLIDE GEO MATH UTIL
+TEST_REACH_DEPENDS = TERRAIN THREAD IO ZZIP OS ROUTE GLIDE GEO MATH UTIL
 $(eval $(call link-program,test_reach,TEST_REACH))
 
 TEST_ROUTE_SOURCES = \
@@ -325,9 +359,30 @@ TEST_ROUTE_SOURCES = \
 	$(TEST_SRC_DIR)/harness_airspace.cpp \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/test_route.cpp
-TEST_ROUTE_DEPENDS = TERRAIN IO ZZIP OS ROUTE AIRSPACE GLIDE GEO MATH UTIL
+TEST_ROUTE_DEPENDS = TERRAIN THREAD IO ZZIP OS ROUTE AIRSPACE GLIDE GEO MATH UTIL
 $(eval $(call link-program,test_route,TEST_ROUTE))
 
+TEST_HEIGHT_MATRIX_SOURCES = \
+	$(SRC)/Projection/Projection.cpp \
+	$(SRC)/Projection/WindowProjection.cpp \
+	$(SRC)/Operation/Operation.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestHeightMatrix.cpp
+TEST_HEIGHT_MATRIX_CPPFLAGS = $(SCREEN_CPPFLAGS)
+TEST_HEIGHT_MATRIX_DEPENDS = TERRAIN THREAD GEO MATH IO OS ZZIP UTIL
+$(eval $(call link-program,TestHeightMatrix,TEST_HEIGHT_MATRIX))
+
+TEST_RASTER_IMAGE_GENERATOR_SOURCES = \
+	$(SRC)/Projection/Projection.cpp \
+	$(SRC)/Projection/WindowProjection.cpp \
+	$(SRC)/Operation/Operation.cpp \
+	$(SRC)/Screen/Ramp.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestRasterImageGenerator.cpp
+TEST_RASTER_IMAGE_GENERATOR_CPPFLAGS = $(SCREEN_CPPFLAGS)
+TEST_RASTER_IMAGE_GENERATOR_DEPENDS = TERRAIN THREAD GEO MATH IO OS ZZIP UTIL
+$(eval $(call link-program,TestRasterImageGenerator,TEST_RASTER_IMAGE_GENERATOR))
+
 TEST_REPLAY_TASK_SOURCES = \
 	$(SRC)/NMEA/Info.cpp \
 	$(SRC)/NMEA/GPSState.cpp \
@@ -612,6 +667,12 @@ TEST_ALLOCATED_GRID_SOURCES = \
 TEST_ALLOCATED_GRID_DEPENDS = UTIL
 $(eval $(call link-program,TestAllocatedGrid,TEST_ALLOCATED_GRID))
 
+TEST_HEIGHT_INTERPOLATION_SOURCES = \
+	$(SRC)/Terrain/RasterBuffer.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestHeightInterpolation.cpp
+$(eval $(call link-program,TestHeightInterpolation,TEST_HEIGHT_INTERPOLATION))
+
 TEST_RADIX_TREE_SOURCES = \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/TestRadixTree.cpp
@@ -708,6 +769,7 @@ $(eval $(call link-program,TestWaypointReader,TEST_WAY_POINT_FILE))
 TEST_TRACE_SOURCES = \
 	$(TEST_SRC_DIR)/tap.c \
 	$(SRC)/Engine/Trace/Point.cpp \
+	$(SRC)/Engine/Trace/Snapshot.cpp \
 	$(SRC)/Engine/Trace/Trace.cpp \
 	$(SRC)/IGC/IGCParser.cpp \
 	$(TEST_SRC_DIR)/FakeTerrain.cpp \
@@ -716,6 +778,28 @@ TEST_TRACE_SOURCES = \
 TEST_TRACE_DEPENDS = IO OS GEO MATH UTIL
 $(eval $(call link-program,TestTrace,TEST_TRACE))
 
+TEST_CONTEST_DIJKSTRA_SOURCES = \
+	$(SRC)/IGC/IGCParser.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestContestDijkstra.cpp
+TEST_CONTEST_DIJKSTRA_LDADD = $(CONTEST_LIBS)
+TEST_CONTEST_DIJKSTRA_DEPENDS = CONTEST IO OS GEO MATH TIME UTIL
+$(eval $(call link-program,TestContestDijkstra,TEST_CONTEST_DIJKSTRA))
+
+TEST_TRIANGLE_CONTEST_SOURCES = \
+	$(SRC)/IGC/IGCParser.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestTriangleContest.cpp
+TEST_TRIANGLE_CONTEST_LDADD = $(CONTEST_LIBS)
+TEST_TRIANGLE_CONTEST_DEPENDS = CONTEST IO OS THREAD GEO MATH TIME UTIL
+$(eval $(call link-program,TestTriangleContest,TEST_TRIANGLE_CONTEST))
+
 FLIGHT_TABLE_SOURCES = \
 	$(SRC)/IGC/IGCParser.cpp \
 	$(TEST_SRC_DIR)/FlightTable.cpp
@@ -732,10 +816,13 @@ DEBUG_PROGRAM_NAMES = \
 	test_reach \
 	test_route \
 	test_troute \
+	TestHeightMatrix \
+	TestRasterImageGenerator \
 	TestTrace \
 	FlightTable \
 	RunTrace \
 	RunOLCAnalysis \
+	RunOLCBatch \
 	RunWaveComputer \
 	FlightPath \
 	BenchmarkProjection \
@@ -750,7 +837,8 @@ DEBUG_PROGRAM_NAMES = \
 	AddChecksum \
 	KeyCodeDumper \
 	LoadTopography LoadTerrain \
-	RunHeightMatrix \
+	RunHeightMatrix BenchmarkTerrain \
+	BenchmarkTaskDijkstra \
 	RunInputParser \
 	RunWaypointParser RunAirspaceParser \
 	RunFlightParser \
@@ -1150,7 +1238,7 @@ LOAD_TERRAIN_SOURCES = \
 	$(SRC)/Operation/Operation.cpp \
 	$(TEST_SRC_DIR)/LoadTerrain.cpp
 LOAD_TERRAIN_CPPFLAGS = $(SCREEN_CPPFLAGS)
-LOAD_TERRAIN_DEPENDS = TERRAIN GEO MATH IO OS ZZIP UTIL
+LOAD_TERRAIN_DEPENDS = TERRAIN THREAD GEO MATH IO OS ZZIP UTIL
 $(eval $(call link-program,LoadTerrain,LOAD_TERRAIN))
 
 RUN_HEIGHT_MATRIX_SOURCES = \
@@ -1159,9 +1247,38 @@ RUN_HEIGHT_MATRIX_SOURCES = \
 	$(SRC)/Operation/Operation.cpp \
 	$(TEST_SRC_DIR)/RunHeightMatrix.cpp
 RUN_HEIGHT_MATRIX_CPPFLAGS = $(SCREEN_CPPFLAGS)
-RUN_HEIGHT_MATRIX_DEPENDS = TERRAIN GEO MATH IO OS ZZIP UTIL
+RUN_HEIGHT_MATRIX_DEPENDS = TERRAIN THREAD GEO MATH IO OS ZZIP UTIL
 $(eval $(call link-program,RunHeightMatrix,RUN_HEIGHT_MATRIX))
 
+BENCHMARK_TERRAIN_SOURCES = \
+	$(SRC)/Projection/Projection.cpp \
+	$(SRC)/Projection/WindowProjection.cpp \
+	$(SRC)/Operation/Operation.cpp \
+	$(SRC)/JSON/Writer.cpp \
+	$(TEST_SRC_DIR)/BenchmarkTerrain.cpp
+BENCHMARK_TERRAIN_CPPFLAGS = $(SCREEN_CPPFLAGS)
+BENCHMARK_TERRAIN_DEPENDS = TERRAIN THREAD GEO MATH IO OS ZZIP UTIL
+$(eval $(call link-program,BenchmarkTerrain,BENCHMARK_TERRAIN))
+
+BENCHMARK_TASK_DIJKSTRA_SOURCES = \
+	$(SRC)/Engine/Trace/Point.cpp \
+	$(SRC)/Engine/Trace/Snapshot.cpp \
+	$(SRC)/Engine/Trace/Trace.cpp \
+	$(SRC)/Engine/Trace/Vector.cpp \
+	$(SRC)/Engine/Navigation/Aircraft.cpp \
+	$(SRC)/Engine/Util/Gradient.cpp \
+	$(SRC)/NMEA/GPSState.cpp \
+	$(SRC)/NMEA/FlyingState.cpp \
+	$(SRC)/Atmosphere/AirDensity.cpp \
+	$(SRC)/Atmosphere/Pressure.cpp \
+	$(SRC)/Formatter/AirspaceFormatter.cpp \
+	$(SRC)/JSON/Writer.cpp \
+	$(TEST_SRC_DIR)/FakeTerrain.cpp \
+	$(TEST_SRC_DIR)/BenchmarkTaskDijkstra.cpp
+BENCHMARK_TASK_DIJKSTRA_LDADD = $(TEST1_LDADD)
+BENCHMARK_TASK_DIJKSTRA_LDLIBS = $(TEST1_LDLIBS)
+$(eval $(call link-program,BenchmarkTaskDijkstra,BENCHMARK_TASK_DIJKSTRA))
+
 RUN_INPUT_PARSER_SOURCES = \
 	$(SRC)/Input/InputKeys.cpp \
 	$(SRC)/Input/InputConfig.cpp \
@@ -1234,7 +1351,7 @@ RUN_AIRSPACE_PARSER_SOURCES = \
 	$(TEST_SRC_DIR)/FakeLanguage.cpp \
 	$(TEST_SRC_DIR)/RunAirspaceParser.cpp
 RUN_AIRSPACE_PARSER_LDADD = $(FAKE_LIBS)
-RUN_AIRSPACE_PARSER_DEPENDS = IO OS AIRSPACE ZZIP GEO MATH UTIL
+RUN_AIRSPACE_PARSER_DEPENDS = IO OS THREAD AIRSPACE ZZIP GEO MATH UTIL
 $(eval $(call link-program,RunAirspaceParser,RUN_AIRSPACE_PARSER))
 
 ENUMERATE_PORTS_SOURCES = \
@@ -1670,6 +1787,7 @@ RUN_TRACE_SOURCES = \
 	$(SRC)/NMEA/Aircraft.cpp \
 	$(ENGINE_SRC_DIR)/GlideSolvers/GlideSettings.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
 	$(TEST_SRC_DIR)/Printing.cpp \
 	$(TEST_SRC_DIR)/RunTrace.cpp
@@ -1682,21 +1800,38 @@ RUN_OLC_SOURCES = \
 	$(SRC)/IGC/IGCParser.cpp \
 	$(SRC)/NMEA/Aircraft.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
 	$(TEST_SRC_DIR)/FakeTerrain.cpp \
 	$(TEST_SRC_DIR)/Printing.cpp \
 	$(TEST_SRC_DIR)/ContestPrinting.cpp \
 	$(TEST_SRC_DIR)/RunOLCAnalysis.cpp
-RUN_OLC_LDADD = $(DEBUG_REPLAY_LDADD)
+RUN_OLC_LDADD = $(CONTEST_LIBS) $(DEBUG_REPLAY_LDADD)
 RUN_OLC_DEPENDS = CONTEST UTIL GEO MATH TIME
 $(eval $(call link-program,RunOLCAnalysis,RUN_OLC))
 
+RUN_OLC_BATCH_SOURCES = \
+	$(DEBUG_REPLAY_SOURCES) \
+	$(SRC)/IGC/IGCParser.cpp \
+	$(SRC)/NMEA/Aircraft.cpp \
+	$(SRC)/JSON/Writer.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
+	$(TEST_SRC_DIR)/FakeTerrain.cpp \
+	$(TEST_SRC_DIR)/ContestJSON.cpp \
+	$(TEST_SRC_DIR)/RunOLCBatch.cpp
+RUN_OLC_BATCH_LDADD = $(CONTEST_LIBS) $(DEBUG_REPLAY_LDADD)
+RUN_OLC_BATCH_DEPENDS = CONTEST UTIL GEO MATH TIME
+$(eval $(call link-program,RunOLCBatch,RUN_OLC_BATCH))
+
 RUN_WAVE_COMPUTER_SOURCES = \
 	$(DEBUG_REPLAY_SOURCES) \
 	$(SRC)/Computer/WaveComputer.cpp \
 	$(SRC)/Formatter/TimeFormatter.cpp \
 	$(SRC)/Formatter/GeoPointFormatter.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
 	$(TEST_SRC_DIR)/RunWaveComputer.cpp
 RUN_WAVE_COMPUTER_LDADD = $(DEBUG_REPLAY_LDADD)
@@ -1710,6 +1845,7 @@ ANALYSE_FLIGHT_SOURCES = \
 	$(SRC)/Formatter/TimeFormatter.cpp \
 	$(SRC)/Computer/CirclingComputer.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
 	$(ENGINE_SRC_DIR)/ThermalBand/ThermalBand.cpp \
     $(ENGINE_SRC_DIR)/ThermalBand/ThermalSlice.cpp \
@@ -1719,9 +1855,10 @@ ANALYSE_FLIGHT_SOURCES = \
 	$(TEST_SRC_DIR)/Printing.cpp \
 	$(TEST_SRC_DIR)/ContestPrinting.cpp \
 	$(TEST_SRC_DIR)/FlightPhaseJSON.cpp \
+	$(TEST_SRC_DIR)/ContestJSON.cpp \
 	$(TEST_SRC_DIR)/FlightPhaseDetector.cpp \
 	$(TEST_SRC_DIR)/AnalyseFlight.cpp
-ANALYSE_FLIGHT_LDADD = $(DEBUG_REPLAY_LDADD)
+ANALYSE_FLIGHT_LDADD = $(CONTEST_LIBS) $(DEBUG_REPLAY_LDADD)
 ANALYSE_FLIGHT_DEPENDS = CONTEST UTIL GEO MATH TIME
 $(eval $(call link-program,AnalyseFlight,ANALYSE_FLIGHT))
 
@@ -1731,6 +1868,7 @@ FLIGHT_PATH_SOURCES = \
 	$(SRC)/NMEA/Aircraft.cpp \
 	$(ENGINE_SRC_DIR)/GlideSolvers/GlideSettings.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Point.cpp \
+	$(ENGINE_SRC_DIR)/Trace/Snapshot.cpp \
 	$(ENGINE_SRC_DIR)/Trace/Trace.cpp \
 	$(TEST_SRC_DIR)/Printing.cpp \
 	$(TEST_SRC_DIR)/FlightPath.cpp
@@ -1773,6 +1911,7 @@ RUN_MAP_WINDOW_SOURCES = \
 	$(CONTEST_SRC_DIR)/Settings.cpp \
 	$(SRC)/Engine/Util/Gradient.cpp \
 	$(SRC)/Engine/Trace/Point.cpp \
+	$(SRC)/Engine/Trace/Snapshot.cpp \
 	$(SRC)/Engine/Trace/Trace.cpp \
 	$(SRC)/Engine/Trace/Vector.cpp \
 	$(SRC)/Engine/Navigation/Aircraft.cpp \
@@ -1840,6 +1979,7 @@ RUN_MAP_WINDOW_SOURCES = \
 	$(SRC)/Renderer/AircraftRenderer.cpp \
 	$(SRC)/Renderer/AirspaceRenderer.cpp \
 	$(SRC)/Renderer/AirspaceRendererGL.cpp \
+	$(SRC)/Renderer/AirspaceVertexCache.cpp \
 	$(SRC)/Renderer/AirspaceRendererOther.cpp \
 	$(SRC)/Renderer/AirspaceLabelList.cpp \
 	$(SRC)/Renderer/AirspaceLabelRenderer.cpp \
@@ -2240,6 +2380,7 @@ RUN_ANALYSIS_SOURCES = \
 	$(DEBUG_REPLAY_SOURCES) \
 	$(SRC)/Engine/Util/Gradient.cpp \
 	$(SRC)/Engine/Trace/Point.cpp \
+	$(SRC)/Engine/Trace/Snapshot.cpp \
 	$(SRC)/Engine/Trace/Trace.cpp \
 	$(SRC)/Engine/Trace/Vector.cpp \
 	$(SRC)/NMEA/Aircraft.cpp \
@@ -2360,6 +2501,7 @@ RUN_ANALYSIS_SOURCES = \
 	$(SRC)/Airspace/ActivePredicate.cpp \
 	$(SRC)/Airspace/ProtectedAirspaceWarningManager.cpp \
 	$(SRC)/Airspace/AirspaceParser.cpp \
+	$(SRC)/Airspace/AirspaceCache.cpp \
 	$(SRC)/Airspace/AirspaceGlue.cpp \
 	$(SRC)/Airspace/AirspaceVisibility.cpp \
 	$(SRC)/Airspace/AirspaceComputerSettings.cpp \
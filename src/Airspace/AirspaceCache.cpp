@@ -0,0 +1,239 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "AirspaceCache.hpp"
+#include "Airspace/Airspaces.hpp"
+#include "Airspace/AirspacePolygon.hpp"
+#include "Airspace/AirspaceCircle.hpp"
+#include "OS/Path.hpp"
+
+#include <algorithm>
+#include <memory>
+
+#include <stdint.h>
+#include <string.h>
+#include <tchar.h>
+
+/* the cache is only read by the same build which wrote it, so the
+   plain structs are written in host format; the version number needs
+   to be bumped whenever the layout changes */
+
+struct AirspaceCacheHeader {
+  static constexpr unsigned VERSION = 1;
+
+  uint32_t version;
+
+  /**
+   * Number of characters of the source path, which follows the
+   * header.
+   */
+  uint32_t source_length;
+
+  uint32_t n_airspaces;
+};
+
+struct AirspaceCacheRecord {
+  AirspaceAltitude base, top;
+
+  AirspaceActivity days;
+
+  uint8_t shape;
+
+  uint8_t type;
+
+  /**
+   * Number of characters of the name and the radio text.
+   */
+  uint16_t name_length, radio_length;
+
+  /**
+   * Number of border points (polygon) or 0 (circle).
+   */
+  uint32_t n_points;
+};
+
+static bool
+WriteString(FILE *file, const TCHAR *s, size_t length)
+{
+  return fwrite(s, sizeof(*s), length, file) == length;
+}
+
+static bool
+ReadString(FILE *file, tstring &s, size_t length)
+{
+  s.resize(length);
+  return fread(&s.front(), sizeof(s.front()), length, file) == length;
+}
+
+static bool
+SaveAirspace(FILE *file, const AbstractAirspace &airspace)
+{
+  const TCHAR *name = airspace.GetName();
+  const size_t name_length = _tcslen(name);
+  const tstring &radio = airspace.GetRadioText();
+  if (name_length > 0xffff || radio.length() > 0xffff)
+    return false;
+
+  AirspaceCacheRecord record;
+
+  /* zero-fill all implicit padding bytes (to make valgrind happy) */
+  memset((void *)&record, 0, sizeof(record));
+
+  record.base = airspace.GetBase();
+  record.top = airspace.GetTop();
+  record.days = airspace.GetDays();
+  record.shape = (uint8_t)airspace.GetShape();
+  record.type = (uint8_t)airspace.GetType();
+  record.name_length = name_length;
+  record.radio_length = radio.length();
+
+  if (airspace.GetShape() == AbstractAirspace::Shape::POLYGON)
+    record.n_points = airspace.GetPoints().size();
+
+  if (fwrite(&record, sizeof(record), 1, file) != 1 ||
+      !WriteString(file, name, name_length) ||
+      !WriteString(file, radio.data(), radio.length()))
+    return false;
+
+  switch (airspace.GetShape()) {
+  case AbstractAirspace::Shape::CIRCLE: {
+    const AirspaceCircle &circle = (const AirspaceCircle &)airspace;
+    const GeoPoint center = circle.GetCenter();
+    const double radius = circle.GetRadius();
+    return fwrite(&center, sizeof(center), 1, file) == 1 &&
+      fwrite(&radius, sizeof(radius), 1, file) == 1;
+  }
+
+  case AbstractAirspace::Shape::POLYGON:
+    /* the border is already closed, and arcs have been expanded */
+    for (const auto &i : airspace.GetPoints()) {
+      const GeoPoint location = i.GetLocation();
+      if (fwrite(&location, sizeof(location), 1, file) != 1)
+        return false;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+bool
+SaveAirspaceCache(FILE *file, Path source,
+                  const std::vector<const AbstractAirspace *> &airspaces)
+{
+  AirspaceCacheHeader header;
+  header.version = AirspaceCacheHeader::VERSION;
+  header.source_length = _tcslen(source.c_str());
+  header.n_airspaces = airspaces.size();
+
+  if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+      !WriteString(file, source.c_str(), header.source_length))
+    return false;
+
+  for (const AbstractAirspace *airspace : airspaces)
+    if (!SaveAirspace(file, *airspace))
+      return false;
+
+  return true;
+}
+
+static AbstractAirspace *
+LoadAirspace(FILE *file, std::vector<GeoPoint> &points)
+{
+  AirspaceCacheRecord record;
+  tstring name, radio;
+  if (fread(&record, sizeof(record), 1, file) != 1 ||
+      record.type >= AIRSPACECLASSCOUNT ||
+      !ReadString(file, name, record.name_length) ||
+      !ReadString(file, radio, record.radio_length))
+    return nullptr;
+
+  std::unique_ptr<AbstractAirspace> airspace;
+
+  switch (AbstractAirspace::Shape(record.shape)) {
+  case AbstractAirspace::Shape::CIRCLE: {
+    GeoPoint center;
+    double radius;
+    if (fread(&center, sizeof(center), 1, file) != 1 ||
+        fread(&radius, sizeof(radius), 1, file) != 1)
+      return nullptr;
+
+    airspace.reset(new AirspaceCircle(center, radius));
+    break;
+  }
+
+  case AbstractAirspace::Shape::POLYGON:
+    if (record.n_points < 4 || record.n_points > 1024 * 1024)
+      return nullptr;
+
+    points.resize(record.n_points);
+    if (fread(points.data(), sizeof(points.front()), points.size(),
+              file) != points.size())
+      return nullptr;
+
+    airspace.reset(new AirspacePolygon(points));
+    break;
+
+  default:
+    return nullptr;
+  }
+
+  airspace->SetProperties(std::move(name), AirspaceClass(record.type),
+                          record.base, record.top);
+  airspace->SetRadio(radio);
+  airspace->SetDays(record.days);
+  return airspace.release();
+}
+
+bool
+LoadAirspaceCache(FILE *file, Path source, Airspaces &airspaces)
+{
+  AirspaceCacheHeader header;
+  tstring cached_source;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      header.version != AirspaceCacheHeader::VERSION ||
+      header.source_length > 4096 ||
+      !ReadString(file, cached_source, header.source_length) ||
+      cached_source != source.c_str())
+    return false;
+
+  /* load everything before adding anything, to avoid adding a partial
+     set of airspaces from a truncated file */
+  std::vector<std::unique_ptr<AbstractAirspace>> loaded;
+  loaded.reserve(std::min(header.n_airspaces, 65536u));
+
+  std::vector<GeoPoint> points;
+  for (unsigned i = 0; i < header.n_airspaces; ++i) {
+    AbstractAirspace *airspace = LoadAirspace(file, points);
+    if (airspace == nullptr)
+      return false;
+
+    loaded.emplace_back(airspace);
+  }
+
+  for (auto &i : loaded)
+    airspaces.Add(i.release());
+
+  return true;
+}
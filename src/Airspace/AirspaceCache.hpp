@@ -0,0 +1,61 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_AIRSPACE_CACHE_HPP
+#define XCSOAR_AIRSPACE_CACHE_HPP
+
+#include <vector>
+
+#include <stdio.h>
+
+class Airspaces;
+class AbstractAirspace;
+class Path;
+
+/**
+ * Write the given airspaces to a binary cache file, with all
+ * properties decoded and arcs already expanded to polygons, so
+ * LoadAirspaceCache() can restore them without parsing the original
+ * file.
+ *
+ * @param source the path of the original file; it is stored in the
+ * cache, because the #FileCache only compares size and modification
+ * time
+ * @return false on I/O error
+ */
+bool
+SaveAirspaceCache(FILE *file, Path source,
+                  const std::vector<const AbstractAirspace *> &airspaces);
+
+/**
+ * Load airspaces from a file written by SaveAirspaceCache() and add
+ * them to the #Airspaces object.  Nothing is added if the file is
+ * malformed, was written by an incompatible version or for a
+ * different source file.
+ *
+ * @return true on success
+ */
+bool
+LoadAirspaceCache(FILE *file, Path source, Airspaces &airspaces);
+
+#endif
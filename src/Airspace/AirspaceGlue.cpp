@@ -23,6 +23,7 @@ Copyright_License {
 
 #include "Airspace/AirspaceGlue.hpp"
 #include "Airspace/AirspaceParser.hpp"
+#include "Airspace/AirspaceCache.hpp"
 #include "Engine/Airspace/Airspaces.hpp"
 #include "Profile/ProfileKeys.hpp"
 #include "Operation/Operation.hpp"
@@ -33,10 +34,91 @@ Copyright_License {
 #include "IO/ZipArchive.hpp"
 #include "IO/ZipLineReader.hpp"
 #include "IO/MapFile.hpp"
+#include "IO/FileCache.hpp"
 #include "Profile/Profile.hpp"
+#include "Thread/ThreadPool.hpp"
+
+#include <memory>
 
 #include <string.h>
 
+static bool
+LoadCache(FileCache &cache, const TCHAR *name, Path original_path,
+          Airspaces &airspaces)
+{
+  FILE *file = cache.Load(name, original_path);
+  if (file == nullptr)
+    return false;
+
+  const bool success = LoadAirspaceCache(file, original_path, airspaces);
+  fclose(file);
+
+  if (success)
+    LogFormat(_T("Loaded airspace cache for %s"), original_path.c_str());
+  else
+    cache.Flush(name);
+
+  return success;
+}
+
+/**
+ * Save the airspaces which were added to #airspaces since #first
+ * (an index into Airspaces::GetPending()).
+ */
+static void
+SaveCache(FileCache &cache, const TCHAR *name, Path original_path,
+          const Airspaces &airspaces, size_t first)
+{
+  const auto &pending = airspaces.GetPending();
+  const std::vector<const AbstractAirspace *> parsed(pending.begin() + first,
+                                                     pending.end());
+
+  FILE *file = cache.Save(name, original_path);
+  if (file == nullptr)
+    return;
+
+  if (SaveAirspaceCache(file, original_path, parsed))
+    cache.Commit(name, file);
+  else
+    cache.Cancel(name, file);
+}
+
+/**
+ * Load the airspaces of one source from the cache, or parse it and
+ * update the cache.
+ *
+ * @param original_path the file which the cache is validated against
+ * @param pool the #ThreadPool which parses OpenAir files in parallel;
+ * it is created on the first cache miss
+ * @param parse a function parsing the source into the given
+ * #AirspaceParser
+ */
+template<typename F>
+static bool
+ReadAirspaceSource(Airspaces &airspaces, FileCache *cache,
+                   const TCHAR *cache_name, Path original_path,
+                   std::unique_ptr<ThreadPool> &pool, F &&parse)
+{
+  if (cache != nullptr && LoadCache(*cache, cache_name, original_path,
+                                    airspaces))
+    return true;
+
+  const size_t first = airspaces.GetPending().size();
+
+  if (!pool)
+    pool = std::make_unique<ThreadPool>("AirspaceParser",
+                                        ThreadPool::GetCPUCount());
+
+  AirspaceParser parser(airspaces, pool.get());
+  if (!parse(parser))
+    return false;
+
+  if (cache != nullptr)
+    SaveCache(*cache, cache_name, original_path, airspaces, first);
+
+  return true;
+}
+
 static bool
 ParseAirspaceFile(AirspaceParser &parser, Path path,
                   OperationEnvironment &operation)
@@ -78,6 +160,7 @@ void
 ReadAirspace(Airspaces &airspaces,
              RasterTerrain *terrain,
              const AtmosphericPressure &press,
+             FileCache *cache,
              OperationEnvironment &operation)
 {
   LogFormat("ReadAirspace");
@@ -85,21 +168,40 @@ ReadAirspace(Airspaces &airspaces,
 
   bool airspace_ok = false;
 
-  AirspaceParser parser(airspaces);
+  /* large OpenAir files are split into chunks which are parsed in
+     parallel; the threads are only started if a source is not
+     cached */
+  std::unique_ptr<ThreadPool> pool;
 
   // Read the airspace filenames from the registry
   auto path = Profile::GetPath(ProfileKeys::AirspaceFile);
   if (!path.IsNull())
-    airspace_ok |= ParseAirspaceFile(parser, path, operation);
-
-  path = Profile::GetPath(ProfileKeys::AdditionalAirspaceFile);
-  if (!path.IsNull())
-    airspace_ok |= ParseAirspaceFile(parser, path, operation);
-
-  auto archive = OpenMapFile();
-  if (archive)
-    airspace_ok |= ParseAirspaceFile(parser, archive->get(), "airspace.txt",
-                                     operation);
+    airspace_ok |= ReadAirspaceSource(airspaces, cache, _T("airspace"), path,
+                                      pool, [&](AirspaceParser &parser){
+        return ParseAirspaceFile(parser, path, operation);
+      });
+
+  auto additional_path = Profile::GetPath(ProfileKeys::AdditionalAirspaceFile);
+  if (!additional_path.IsNull())
+    airspace_ok |= ReadAirspaceSource(airspaces, cache,
+                                      _T("airspace-additional"),
+                                      additional_path, pool,
+                                      [&](AirspaceParser &parser){
+        return ParseAirspaceFile(parser, additional_path, operation);
+      });
+
+  /* the airspace file inside the map file is validated against the
+     map file */
+  const auto map_path = Profile::GetPath(ProfileKeys::MapFile);
+  if (!map_path.IsNull())
+    airspace_ok |= ReadAirspaceSource(airspaces, cache, _T("airspace-map"),
+                                      map_path, pool,
+                                      [&](AirspaceParser &parser){
+        auto archive = OpenMapFile();
+        return archive &&
+          ParseAirspaceFile(parser, archive->get(), "airspace.txt",
+                            operation);
+      });
 
   if (airspace_ok) {
     airspaces.Optimise();
@@ -28,14 +28,20 @@ class RasterTerrain;
 class AtmosphericPressure;
 class Airspaces;
 class OperationEnvironment;
+class FileCache;
 
 /**
  * Reads the airspace files into the memory
+ *
+ * @param cache an optional cache for the parsed airspace files; if
+ * a file has not been modified since it was cached, it is loaded from
+ * the cache instead of being parsed
  */
 void
 ReadAirspace(Airspaces &airspaces,
              RasterTerrain *terrain,
              const AtmosphericPressure &press,
+             FileCache *cache,
              OperationEnvironment &operation);
 
 #endif
@@ -39,9 +39,19 @@ Copyright_License {
 #include "Engine/Airspace/AirspaceClass.hpp"
 #include "Util/StaticString.hxx"
 #include "Util/StringCompare.hxx"
+#include "Thread/ThreadPool.hpp"
+
+#include <algorithm>
+#include <vector>
 
 #include <tchar.h>
 
+/**
+ * The airspaces parsed from a file, in the order in which they will
+ * be added to #Airspaces.
+ */
+typedef std::vector<AbstractAirspace *> AirspaceList;
+
 enum class AirspaceFileType {
   UNKNOWN,
   OPENAIR,
@@ -166,7 +176,7 @@ struct TempAirspaceType
   }
 
   void
-  AddPolygon(Airspaces &airspace_database)
+  AddPolygon(AirspaceList &airspace_list)
   {
     if (points.size() < 3)
       return;
@@ -175,17 +185,17 @@ struct TempAirspaceType
     as->SetProperties(std::move(name), type, base, top);
     as->SetRadio(radio);
     as->SetDays(days_of_operation);
-    airspace_database.Add(as);
+    airspace_list.push_back(as);
   }
 
   void
-  AddCircle(Airspaces &airspace_database)
+  AddCircle(AirspaceList &airspace_list)
   {
     AbstractAirspace *as = new AirspaceCircle(center, radius);
     as->SetProperties(std::move(name), type, base, top);
     as->SetRadio(radio);
     as->SetDays(days_of_operation);
-    airspace_database.Add(as);
+    airspace_list.push_back(as);
   }
 
   static int
@@ -496,7 +506,7 @@ ParseType(const TCHAR *buffer)
 }
 
 static bool
-ParseLine(Airspaces &airspace_database, StringParser<TCHAR> &&input,
+ParseLine(AirspaceList &airspace_list, StringParser<TCHAR> &&input,
           TempAirspaceType &temp_area)
 {
   double d;
@@ -526,7 +536,7 @@ ParseLine(Airspaces &airspace_database, StringParser<TCHAR> &&input,
         return false;
 
       temp_area.radius = Units::ToSysUnit(d, Unit::NAUTICAL_MILES);
-      temp_area.AddCircle(airspace_database);
+      temp_area.AddCircle(airspace_list);
       temp_area.Reset();
       break;
 
@@ -565,7 +575,7 @@ ParseLine(Airspaces &airspace_database, StringParser<TCHAR> &&input,
       if (!input.SkipWhitespace())
         break;
 
-      temp_area.AddPolygon(airspace_database);
+      temp_area.AddPolygon(airspace_list);
       temp_area.Reset();
 
       temp_area.type = ParseType(input.c_str());
@@ -606,7 +616,7 @@ ParseLine(Airspaces &airspace_database, StringParser<TCHAR> &&input,
 }
 
 static bool
-ParseLine(Airspaces &airspace_database, TCHAR *line,
+ParseLine(AirspaceList &airspace_list, TCHAR *line,
           TempAirspaceType &temp_area)
 {
   // Strip comments
@@ -614,7 +624,7 @@ ParseLine(Airspaces &airspace_database, TCHAR *line,
   if (comment != nullptr)
     *comment = _T('\0');
 
-  return ParseLine(airspace_database, StringParser<TCHAR>(line), temp_area);
+  return ParseLine(airspace_list, StringParser<TCHAR>(line), temp_area);
 }
 
 static AirspaceClass
@@ -758,7 +768,7 @@ ParseCircleTNP(StringParser<TCHAR> &input, TempAirspaceType &temp_area)
 }
 
 static bool
-ParseLineTNP(Airspaces &airspace_database, StringParser<TCHAR> &input,
+ParseLineTNP(AirspaceList &airspace_list, StringParser<TCHAR> &input,
              TempAirspaceType &temp_area, bool &ignore)
 {
   if (input.Match('#'))
@@ -786,7 +796,7 @@ ParseLineTNP(Airspaces &airspace_database, StringParser<TCHAR> &input,
     if (!ParseCircleTNP(input, temp_area))
       return false;
 
-    temp_area.AddCircle(airspace_database);
+    temp_area.AddCircle(airspace_list);
     temp_area.ResetTNP();
   } else if (input.SkipMatchIgnoreCase(_T("CLOCKWISE "), 10)) {
     temp_area.rotation = 1;
@@ -797,12 +807,12 @@ ParseLineTNP(Airspaces &airspace_database, StringParser<TCHAR> &input,
     if (!ParseArcTNP(input, temp_area))
       return false;
   } else if (input.SkipMatchIgnoreCase(_T("TITLE="), 6)) {
-    temp_area.AddPolygon(airspace_database);
+    temp_area.AddPolygon(airspace_list);
     temp_area.ResetTNP();
 
     temp_area.name = input.c_str();
   } else if (input.SkipMatchIgnoreCase(_T("TYPE="), 5)) {
-    temp_area.AddPolygon(airspace_database);
+    temp_area.AddPolygon(airspace_list);
     temp_area.ResetTNP();
 
     temp_area.type = ParseTypeTNP(input.c_str());
@@ -841,8 +851,201 @@ DetectFileType(const TCHAR *line)
   return AirspaceFileType::UNKNOWN;
 }
 
-bool
-AirspaceParser::Parse(TLineReader &reader, OperationEnvironment &operation)
+/**
+ * Does this OpenAir line begin a new airspace, i.e. is it an "AC"
+ * record which makes ParseLine() commit the previous one?  This must
+ * match the condition in ParseLine(), which is applied after
+ * stripping the comment.
+ */
+gcc_pure
+static bool
+IsOpenAirRecordStart(const TCHAR *line)
+{
+  const TCHAR *comment = StringFind(line, _T('*'));
+  const size_t length = comment != nullptr
+    ? size_t(comment - line)
+    : _tcslen(line);
+
+  return length >= 3 &&
+    (line[0] == _T('A') || line[0] == _T('a')) &&
+    (line[1] == _T('C') || line[1] == _T('c')) &&
+    IsWhitespaceNotNull(line[2]);
+}
+
+/**
+ * The non-empty lines of an OpenAir file, loaded into memory.
+ */
+class OpenAirLines {
+  struct Line {
+    /**
+     * The position of this line in #buffer.
+     */
+    size_t position;
+
+    /**
+     * The line number in the file (1-based).
+     */
+    unsigned number;
+  };
+
+  /**
+   * All lines, each one null-terminated.
+   */
+  std::vector<TCHAR> buffer;
+
+  std::vector<Line> lines;
+
+public:
+  unsigned size() const {
+    return lines.size();
+  }
+
+  void Append(const TCHAR *line, unsigned number) {
+    lines.push_back({buffer.size(), number});
+    buffer.insert(buffer.end(), line, line + _tcslen(line) + 1);
+  }
+
+  TCHAR *GetLine(unsigned i) {
+    return buffer.data() + lines[i].position;
+  }
+
+  unsigned GetNumber(unsigned i) const {
+    return lines[i].number;
+  }
+};
+
+/**
+ * The initial TempAirspaceType::name of an #OpenAirChunk.
+ *
+ * The name is not reset by an "AC" record; an airspace without "AN"
+ * record gets the name which was left over by the previous one (which
+ * is empty unless the previous one had no geometry).  A chunk cannot
+ * know that name, therefore it begins with this placeholder (which no
+ * "AN" record can produce), and ParseOpenAirParallel() replaces it.
+ */
+static constexpr const TCHAR *INHERITED_NAME = _T("\n");
+
+/**
+ * A range of #OpenAirLines beginning with an "AC" record, and the
+ * airspaces parsed from it.
+ */
+struct OpenAirChunk {
+  unsigned begin, end;
+
+  /**
+   * The index of the line which failed to parse, or #end.
+   */
+  unsigned error;
+
+  AirspaceList airspaces;
+
+  /**
+   * The name left over at the end of this chunk, or #INHERITED_NAME.
+   */
+  tstring name;
+
+  OpenAirChunk(unsigned _begin, unsigned _end)
+    :begin(_begin), end(_end), error(_end) {}
+};
+
+static void
+ParseOpenAirChunk(OpenAirLines &lines, OpenAirChunk &chunk)
+{
+  TempAirspaceType temp_area;
+  temp_area.name = INHERITED_NAME;
+
+  for (unsigned i = chunk.begin; i < chunk.end; ++i) {
+    if (!ParseLine(chunk.airspaces, lines.GetLine(i), temp_area)) {
+      chunk.error = i;
+      return;
+    }
+  }
+
+  /* this would be done by the "AC" record which begins the next
+     chunk (or at the end of the file) */
+  temp_area.AddPolygon(chunk.airspaces);
+
+  chunk.name = std::move(temp_area.name);
+}
+
+/**
+ * Parse the rest of an OpenAir file in parallel: the lines are loaded
+ * into memory and split into chunks at "AC" records, which are parsed
+ * by the #ThreadPool.  The result is the same as ParseLine() called
+ * for each line.
+ *
+ * @param line the current line (the first "AC" record)
+ */
+static bool
+ParseOpenAirParallel(TLineReader &reader, TCHAR *line, unsigned line_num,
+                     AirspaceList &airspace_list,
+                     OperationEnvironment &operation, ThreadPool &pool)
+{
+  const long file_size = reader.GetSize();
+
+  OpenAirLines lines;
+  do {
+    StripRight(line);
+    if (!StringIsEmpty(line))
+      lines.Append(line, line_num);
+
+    // Update the ProgressDialog
+    if ((line_num & 0xff) == 0)
+      operation.SetProgressPosition(reader.Tell() * 1024 / file_size);
+
+    ++line_num;
+  } while ((line = reader.ReadLine()) != nullptr);
+
+  /* a few chunks per thread, to balance the load */
+  const unsigned n_lines = lines.size();
+  const unsigned chunk_lines = n_lines / (4 * pool.GetConcurrency()) + 1;
+
+  std::vector<OpenAirChunk> chunks;
+  for (unsigned begin = 0; begin < n_lines;) {
+    unsigned end = std::min(begin + chunk_lines, n_lines);
+    while (end < n_lines && !IsOpenAirRecordStart(lines.GetLine(end)))
+      ++end;
+
+    chunks.emplace_back(begin, end);
+    begin = end;
+  }
+
+  pool.Run(chunks.size(), [&lines, &chunks](unsigned i){
+      ParseOpenAirChunk(lines, chunks[i]);
+    });
+
+  /* merge the chunks in file order */
+  tstring name;
+  for (auto i = chunks.begin(); i != chunks.end(); ++i) {
+    OpenAirChunk &chunk = *i;
+
+    if (!chunk.airspaces.empty() &&
+        StringIsEqual(chunk.airspaces.front()->GetName(), INHERITED_NAME))
+      chunk.airspaces.front()->SetName(std::move(name));
+
+    airspace_list.insert(airspace_list.end(),
+                         chunk.airspaces.begin(), chunk.airspaces.end());
+
+    if (chunk.error != chunk.end) {
+      /* the serial parser would have stopped here */
+      for (auto j = std::next(i); j != chunks.end(); ++j)
+        for (AbstractAirspace *as : j->airspaces)
+          delete as;
+
+      return ShowParseWarning(lines.GetNumber(chunk.error),
+                              lines.GetLine(chunk.error), operation);
+    }
+
+    if (chunk.name != INHERITED_NAME)
+      name = std::move(chunk.name);
+  }
+
+  return true;
+}
+
+static bool
+ParseLines(TLineReader &reader, AirspaceList &airspace_list,
+           OperationEnvironment &operation, ThreadPool *pool)
 {
   bool ignore = false;
 
@@ -868,17 +1071,21 @@ AirspaceParser::Parse(TLineReader &reader, OperationEnvironment &operation)
       filetype = DetectFileType(line);
       if (filetype == AirspaceFileType::UNKNOWN)
         continue;
+
+      if (filetype == AirspaceFileType::OPENAIR && pool != nullptr)
+        return ParseOpenAirParallel(reader, line, line_num, airspace_list,
+                                    operation, *pool);
     }
 
     // Parse the line
     if (filetype == AirspaceFileType::OPENAIR)
-      if (!ParseLine(airspaces, line, temp_area) &&
+      if (!ParseLine(airspace_list, line, temp_area) &&
           !ShowParseWarning(line_num, line, operation))
         return false;
 
     if (filetype == AirspaceFileType::TNP) {
       StringParser<TCHAR> input(line);
-      if (!ParseLineTNP(airspaces, input, temp_area, ignore) &&
+      if (!ParseLineTNP(airspace_list, input, temp_area, ignore) &&
           !ShowParseWarning(line_num, line, operation))
         return false;
     }
@@ -894,7 +1101,19 @@ AirspaceParser::Parse(TLineReader &reader, OperationEnvironment &operation)
   }
 
   // Process final area (if any)
-  temp_area.AddPolygon(airspaces);
+  temp_area.AddPolygon(airspace_list);
 
   return true;
 }
+
+bool
+AirspaceParser::Parse(TLineReader &reader, OperationEnvironment &operation)
+{
+  AirspaceList airspace_list;
+  const bool success = ParseLines(reader, airspace_list, operation, pool);
+
+  for (AbstractAirspace *as : airspace_list)
+    airspaces.Add(as);
+
+  return success;
+}
@@ -27,13 +27,21 @@ Copyright_License {
 class Airspaces;
 class TLineReader;
 class OperationEnvironment;
+class ThreadPool;
 
 class AirspaceParser
 {
   Airspaces &airspaces;
 
+  /**
+   * An optional #ThreadPool which parses OpenAir files in parallel.
+   * The result is the same as without it.
+   */
+  ThreadPool *pool;
+
 public:
-  AirspaceParser(Airspaces &_airspaces): airspaces(_airspaces) {}
+  AirspaceParser(Airspaces &_airspaces, ThreadPool *_pool=nullptr)
+    :airspaces(_airspaces), pool(_pool) {}
 
   bool Parse(TLineReader &reader, OperationEnvironment &operation);
 };
@@ -22,44 +22,141 @@ Copyright_License {
 */
 
 #include "ContestComputer.hpp"
-#include "Engine/Contest/Settings.hpp"
 
-ContestComputer::ContestComputer(const Trace &trace_full,
-                                 const Trace &trace_triangle,
-                                 const Trace &trace_sprint)
-  :contest_manager(Contest::OLC_SPRINT, trace_full, trace_triangle, trace_sprint, true)
+/**
+ * The time budget of one ContestManager::UpdateIdle() call, as
+ * configured in the settings.
+ */
+static constexpr std::chrono::milliseconds
+GetTickBudget(const ContestSettings &settings)
 {
+  return std::chrono::milliseconds(settings.tick_budget);
+}
+
+ContestComputer::ContestComputer(const Trace &_trace_full,
+                                 const Trace &_trace_triangle,
+                                 const Trace &_trace_sprint)
+  :StandbyThread("Contest"),
+   source_full(_trace_full),
+   source_triangle(_trace_triangle),
+   source_sprint(_trace_sprint),
+   trace_full(_trace_full.GetNoThinTime(), _trace_full.GetMaxTime(),
+              _trace_full.GetMaxSize()),
+   trace_triangle(_trace_triangle.GetNoThinTime(),
+                  _trace_triangle.GetMaxTime(),
+                  _trace_triangle.GetMaxSize()),
+   trace_sprint(_trace_sprint.GetNoThinTime(), _trace_sprint.GetMaxTime(),
+                _trace_sprint.GetMaxSize()),
+   contest_manager(Contest::OLC_SPRINT, trace_full, trace_triangle,
+                   trace_sprint, true),
+   solver_pool("ContestSolver", 3, true)
+{
+  settings.SetDefaults();
+  stats.Reset();
+
   contest_manager.SetIncremental(true);
+  contest_manager.SetThreadPool(&solver_pool);
+  contest_manager.SetTickBudget(GetTickBudget(settings));
+}
+
+void
+ContestComputer::SetTickBudget(std::chrono::steady_clock::duration budget)
+{
+  std::unique_lock<Mutex> lock(mutex);
+  WaitDone(lock);
+  contest_manager.SetTickBudget(budget);
+}
+
+void
+ContestComputer::SetIncremental(bool incremental)
+{
+  std::unique_lock<Mutex> lock(mutex);
+  WaitDone(lock);
+  contest_manager.SetIncremental(incremental);
+}
+
+void
+ContestComputer::Reset()
+{
+  std::unique_lock<Mutex> lock(mutex);
+  WaitDone(lock);
+
+  trace_full.clear();
+  trace_triangle.clear();
+  trace_sprint.clear();
+  contest_manager.Reset();
+  stats.Reset();
 }
 
 void
-ContestComputer::Solve(const ContestSettings &settings,
+ContestComputer::UpdateTraces()
+{
+  trace_full.Replicate(source_full);
+  trace_triangle.Replicate(source_triangle);
+  trace_sprint.Replicate(source_sprint);
+}
+
+void
+ContestComputer::Solve(const ContestSettings &_settings,
                        ContestStatistics &contest_stats)
 {
-  if (!settings.enable)
+  if (!_settings.enable)
     return;
 
-  contest_manager.SetHandicap(settings.handicap);
-  contest_manager.SetContest(settings.contest);
+  const std::lock_guard<Mutex> lock(mutex);
 
-  contest_manager.UpdateIdle();
+  if (!IsBusy()) {
+    UpdateTraces();
+    if (_settings.tick_budget != settings.tick_budget)
+      contest_manager.SetTickBudget(GetTickBudget(_settings));
+    settings = _settings;
+    Trigger();
+  }
 
-  contest_stats = contest_manager.GetStats();
+  contest_stats = stats;
 }
 
 bool
-ContestComputer::SolveExhaustive(const ContestSettings &settings,
+ContestComputer::SolveExhaustive(const ContestSettings &_settings,
                                  ContestStatistics &contest_stats)
 {
-  if (!settings.enable)
+  if (!_settings.enable)
     return false;
 
+  std::unique_lock<Mutex> lock(mutex);
+  WaitDone(lock);
+
+  UpdateTraces();
+  settings = _settings;
+
   contest_manager.SetHandicap(settings.handicap);
   contest_manager.SetContest(settings.contest);
+  contest_manager.SetPredicted(predicted);
 
   bool result = contest_manager.SolveExhaustive();
 
-  contest_stats = contest_manager.GetStats();
+  stats = contest_manager.GetStats();
+  contest_stats = stats;
 
   return result;
 }
+
+void
+ContestComputer::Tick() noexcept
+{
+  SetLowPriority();
+
+  const ContestSettings _settings = settings;
+  const TracePoint _predicted = predicted;
+
+  {
+    const ScopeUnlock unlock(mutex);
+
+    contest_manager.SetHandicap(_settings.handicap);
+    contest_manager.SetContest(_settings.contest);
+    contest_manager.SetPredicted(_predicted);
+    contest_manager.UpdateIdle();
+  }
+
+  stats = contest_manager.GetStats();
+}
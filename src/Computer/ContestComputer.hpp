@@ -25,39 +25,109 @@ Copyright_License {
 #define XCSOAR_CONTEST_COMPUTER_HPP
 
 #include "Engine/Contest/ContestManager.hpp"
+#include "Engine/Contest/Settings.hpp"
+#include "Engine/Trace/Trace.hpp"
+#include "Thread/StandbyThread.hpp"
+#include "Thread/ThreadPool.hpp"
+
+#include <chrono>
 
-struct ContestSettings;
 struct ContestStatistics;
-class Trace;
 
-class ContestComputer {
+/**
+ * Runs the contest optimisation in a low-priority thread, so the
+ * #CalculationThread never waits for a solver.  The thread works on
+ * copies of the traces, which are updated by Solve() while the
+ * thread is idle.
+ */
+class ContestComputer final : private StandbyThread {
+  const Trace &source_full, &source_triangle, &source_sprint;
+
+  /**
+   * Copies of the traces above.  They may only be modified while the
+   * thread is idle, and the mutex is locked.
+   */
+  Trace trace_full, trace_triangle, trace_sprint;
+
+  /**
+   * This object is used by the thread without holding the mutex.
+   * Other threads may only access it while the thread is idle, and
+   * the mutex is locked.
+   */
   ContestManager contest_manager;
 
+  /**
+   * Helper threads for the (exhaustive) triangle solvers.
+   */
+  ThreadPool solver_pool;
+
+  /* the following attributes are protected by the mutex */
+
+  ContestSettings settings;
+
+  TracePoint predicted = TracePoint::Invalid();
+
+  /**
+   * The result of the last run, published by the thread.
+   */
+  ContestStatistics stats;
+
 public:
+  /**
+   * @param trace_full etc. the traces to be optimised; they may only
+   * be modified by the thread calling Solve()
+   */
   ContestComputer(const Trace &trace_full,
                   const Trace &trace_triangle,
                   const Trace &trace_sprint);
 
-  void SetIncremental(bool incremental) {
-    contest_manager.SetIncremental(incremental);
+  ~ContestComputer() {
+    StandbyThread::LockStop();
   }
 
-  void Reset() {
-    contest_manager.Reset();
-  }
+  void SetIncremental(bool incremental);
+
+  /**
+   * Override the time budget of the incremental solver.  Solve()
+   * applies ContestSettings::tick_budget whenever it changes.
+   *
+   * @see ContestManager::SetTickBudget()
+   */
+  void SetTickBudget(std::chrono::steady_clock::duration budget);
+
+  void Reset();
 
   /**
    * @see ContestDijkstra::SetPredicted()
    */
-  void SetPredicted(const TracePoint &predicted) {
-    contest_manager.SetPredicted(predicted);
+  void SetPredicted(const TracePoint &_predicted) {
+    const std::lock_guard<Mutex> lock(mutex);
+    predicted = _predicted;
   }
 
+  /**
+   * Copy the traces and wake up the thread, unless it is still busy
+   * with the previous run.  This method does not wait for the thread;
+   * it returns the result of the last finished run.
+   */
   void Solve(const ContestSettings &settings_computer,
              ContestStatistics &contest_stats);
 
+  /**
+   * Find the final solution.  This is done synchronously in the
+   * calling thread, after waiting for the thread to become idle.
+   */
   bool SolveExhaustive(const ContestSettings &settings_computer,
                        ContestStatistics &contest_stats);
+
+private:
+  /**
+   * Caller must lock the mutex, and the thread must be idle.
+   */
+  void UpdateTraces();
+
+  /* virtual methods from class StandbyThread */
+  void Tick() noexcept override;
 };
 
 #endif
@@ -22,6 +22,7 @@ Copyright_License {
 */
 
 #include "Profile/ProfileKeys.hpp"
+#include "Profile/Profile.hpp"
 #include "Language/Language.hpp"
 #include "LocalPath.hpp"
 #include "UtilsSettings.hpp"
@@ -31,10 +32,13 @@ Copyright_License {
 #include "UIGlobals.hpp"
 #include "Waypoint/Patterns.hpp"
 #include "OS/Path.hpp"
+#include "Terrain/RasterTerrain.hpp"
 
 enum ControlIndex {
   DataPath,
   MapFile,
+  TerrainTileCacheSize,
+  TerrainMapped,
   WaypointFile,
   AdditionalWaypointFile,
   WatchedWaypointFile,
@@ -70,6 +74,25 @@ SiteConfigPanel::Prepare(ContainerWindow &parent, const PixelRect &rc)
             "waypoints, their details and airspaces."),
           ProfileKeys::MapFile, _T("*.xcm\0*.lkm\0"), FileType::MAP);
 
+  unsigned tile_cache_size = RasterTerrain::DEFAULT_TILE_CACHE_SIZE;
+  Profile::Get(ProfileKeys::TerrainTileCacheSize, tile_cache_size);
+  AddInteger(_("Terrain tile cache"),
+             _("Decoded terrain tiles are stored in a file of up to this size, "
+               "so they can be loaded again quickly, even after a restart.  "
+               "Zero disables this cache."),
+             _T("%d MB"), _T("%d"), 0, 4096, 64, tile_cache_size);
+  SetExpertRow(TerrainTileCacheSize);
+
+  bool terrain_mapped = false;
+  Profile::Get(ProfileKeys::TerrainMapped, terrain_mapped);
+  AddBoolean(_("Memory-mapped terrain"),
+             _("Decode the whole terrain once after the map database has been "
+               "changed, and map the result into memory.  This needs more "
+               "storage space, but no terrain tiles need to be decoded during "
+               "the flight."),
+             terrain_mapped);
+  SetExpertRow(TerrainMapped);
+
   AddFile(_("Waypoints"),
           _("Primary waypoints file.  Supported file types are Cambridge/WinPilot files (.dat), "
             "Zander files (.wpz) or SeeYou files (.cup)."),
@@ -119,6 +142,18 @@ SiteConfigPanel::Save(bool &_changed)
 
   MapFileChanged = SaveValueFileReader(MapFile, ProfileKeys::MapFile);
 
+  /* reload the terrain if its cache settings have changed */
+  int tile_cache_size = RasterTerrain::DEFAULT_TILE_CACHE_SIZE;
+  Profile::Get(ProfileKeys::TerrainTileCacheSize, tile_cache_size);
+  MapFileChanged |= SaveValue(TerrainTileCacheSize,
+                              ProfileKeys::TerrainTileCacheSize,
+                              tile_cache_size);
+
+  bool terrain_mapped = false;
+  Profile::Get(ProfileKeys::TerrainMapped, terrain_mapped);
+  MapFileChanged |= SaveValue(TerrainMapped, ProfileKeys::TerrainMapped,
+                              terrain_mapped);
+
   // WaypointFileChanged has already a meaningful value
   WaypointFileChanged |= SaveValueFileReader(WaypointFile, ProfileKeys::WaypointFile);
   WaypointFileChanged |= SaveValueFileReader(AdditionalWaypointFile, ProfileKeys::AdditionalWaypointFile);
@@ -221,6 +221,15 @@ public:
     altitude_top = _top;
   }
 
+  /**
+   * Set name of airspace
+   *
+   * @param _name Name of airspace
+   */
+  void SetName(tstring &&_name) {
+    name = std::move(_name);
+  }
+
   /**
    * Set radio frequency of airspace
    *
@@ -239,6 +248,10 @@ public:
     days_of_operation = mask;
   }
 
+  const AirspaceActivity &GetDays() const {
+    return days_of_operation;
+  }
+
   /**
    * Get type of airspace
    *
@@ -371,8 +384,11 @@ public:
   }
 
 protected:
-  /** Project border */
-  void Project(const FlatProjection &tp);
+  /**
+   * Project border.  Derived classes may override this to build
+   * auxiliary data which depends on the border.
+   */
+  virtual void Project(const FlatProjection &tp);
 
 private:
   /**
@@ -23,6 +23,7 @@
 #include "AirspacePolygon.hpp"
 #include "Geo/Flat/FlatProjection.hpp"
 #include "Geo/Flat/FlatRay.hpp"
+#include "Geo/ConvexHull/PolygonInterior.hpp"
 #include "AirspaceIntersectSort.hpp"
 #include "AirspaceIntersectionVector.hpp"
 
@@ -79,10 +80,45 @@ AirspacePolygon::GetCenter() const
   return GeoPoint(Angle::Native(lon), Angle::Native(lat));
 }
 
+void
+AirspacePolygon::Project(const FlatProjection &projection)
+{
+  AbstractAirspace::Project(projection);
+
+  const unsigned n_edges = m_border.size() - 1;
+  if (n_edges < MIN_INDEXED_EDGES) {
+    latitude_index.Clear();
+    flat_y_index.Clear();
+    return;
+  }
+
+  const unsigned n_bands = n_edges / 4;
+
+  latitude_index.Build(n_edges, n_bands, [this](unsigned i){
+      return m_border[i].GetLocation().latitude.Native();
+    });
+
+  flat_y_index.Build(n_edges, n_bands, [this](unsigned i){
+      return m_border[i].GetFlatLocation().y;
+    });
+}
+
 bool
 AirspacePolygon::Inside(const GeoPoint &loc) const
 {
-  return m_border.IsInside(loc);
+  if (!latitude_index.IsDefined())
+    return m_border.IsInside(loc);
+
+  /* winding number test (see PolygonInterior()) on only those edges
+     which may cross the latitude of the given location */
+  const double latitude = loc.latitude.Native();
+  int winding = 0;
+  latitude_index.Visit(latitude, latitude, [this, &loc, &winding](unsigned i){
+      winding += PolygonEdgeWinding(loc, m_border[i].GetLocation(),
+                                    m_border[i + 1].GetLocation());
+    });
+
+  return winding != 0;
 }
 
 AirspaceIntersectionVector
@@ -94,13 +130,20 @@ AirspacePolygon::Intersects(const GeoPoint &start, const GeoPoint &end,
 
   AirspaceIntersectSort sorter(start, *this);
 
-  for (auto it = m_border.begin(); it + 1 != m_border.end(); ++it) {
-
-    const FlatRay r_seg(it->GetFlatLocation(), (it + 1)->GetFlatLocation());
+  const auto add_edge = [this, &ray, &projection, &sorter](unsigned i){
+    const FlatRay r_seg(m_border[i].GetFlatLocation(),
+                        m_border[i + 1].GetFlatLocation());
     auto t = ray.DistinctIntersection(r_seg);
     if (t >= 0)
       sorter.add(t, projection.Unproject(ray.Parametric(t)));
-  }
+  };
+
+  if (flat_y_index.IsDefined())
+    /* an edge can only intersect the ray if their y ranges overlap */
+    flat_y_index.Visit(ray.point.y, ray.point.y + ray.vector.y, add_edge);
+  else
+    for (unsigned i = 0, n = m_border.size() - 1; i != n; ++i)
+      add_edge(i);
 
   return sorter.all();
 }
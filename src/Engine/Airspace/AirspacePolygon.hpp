@@ -24,6 +24,8 @@
 #define AIRSPACEPOLYGON_HPP
 
 #include "AbstractAirspace.hpp"
+#include "Geo/EdgeBandIndex.hpp"
+
 #include <vector>
 
 #ifdef DO_PRINT
@@ -32,6 +34,24 @@
 
 /** General polygon form airspace */
 class AirspacePolygon final : public AbstractAirspace {
+  /**
+   * Polygons with fewer edges than this are not indexed; a linear
+   * scan over the border is cheap enough.
+   */
+  static constexpr unsigned MIN_INDEXED_EDGES = 32;
+
+  /**
+   * Index of the border edges by latitude (in native units), used
+   * by Inside().  Built by Project().
+   */
+  EdgeBandIndex<double> latitude_index;
+
+  /**
+   * Index of the border edges by projected y coordinate, used by
+   * Intersects().  Built by Project().
+   */
+  EdgeBandIndex<int> flat_y_index;
+
 public:
   /**
    * Constructor.  For testing, pts vector is a cloud of points,
@@ -54,6 +74,9 @@ public:
   GeoPoint ClosestPoint(const GeoPoint &loc,
                         const FlatProjection &projection) const override;
 
+protected:
+  void Project(const FlatProjection &tp) override;
+
 public:
 #ifdef DO_PRINT
   friend std::ostream &operator<<(std::ostream &f,
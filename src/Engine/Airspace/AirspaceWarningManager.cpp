@@ -24,8 +24,9 @@
 #include "Geo/GeoVector.hpp"
 #include "Airspaces.hpp"
 #include "AbstractAirspace.hpp"
-#include "AirspaceIntersectionVisitor.hpp"
-#include "AirspaceAircraftPerformance.hpp"
+#include "AirspaceInterceptSolution.hpp"
+#include "Geo/Flat/FlatProjection.hpp"
+#include "Geo/Flat/FlatRay.hpp"
 #include "Task/Stats/TaskStats.hpp"
 
 #define CRUISE_FILTER_FACT 0.5
@@ -138,9 +139,12 @@ AirspaceWarningManager::Update(const AircraftState& state,
 
   // check from strongest to weakest alerts
   UpdateInside(state, glide_polar);
-  UpdateGlide(state, glide_polar);
-  UpdateFilter(state, circling);
-  UpdateTask(state, glide_polar, task_stats);
+
+  PredictionList predictions;
+  PredictGlide(state, glide_polar, predictions);
+  PredictFilter(state, circling, predictions);
+  PredictTask(state, glide_polar, task_stats, predictions);
+  UpdatePredicted(state, predictions);
 
   // action changes
   for (auto it = warnings.begin(), end = warnings.end(); it != end;) {
@@ -161,127 +165,12 @@ AirspaceWarningManager::Update(const AircraftState& state,
   return changed;
 }
 
-/**
- * Class used temporarily to check intersections with warning system
- */
-class AirspaceIntersectionWarningVisitor final
-  : public AirspaceIntersectionVisitor
-{
-  const AircraftState state;
-  const AirspaceAircraftPerformance &perf;
-  AirspaceWarningManager &warning_manager;
-  const AirspaceWarning::State warning_state;
-  const double max_time;
-  bool found;
-  const double max_alt;
-  bool mode_inside;
-
-public:
-  /**
-   * Constructor
-   *
-   * @param state State of aircraft
-   * @param perf Aircraft performance model
-   * @param warning_manager Warning manager to add items to
-   * @param warning_state Type of warning
-   * @param max_time Time limit of intercept
-   * @param max_alt Maximum height of base to allow (optional)
-   *
-   * @return Initialised object
-   */
-  AirspaceIntersectionWarningVisitor(const AircraftState &_state,
-                                     const AirspaceAircraftPerformance &_perf,
-                                     AirspaceWarningManager &_warning_manager,
-                                     const AirspaceWarning::State _warning_state,
-                                     const double _max_time,
-                                     const double _max_alt = -1):
-    state(_state),
-    perf(_perf),
-    warning_manager(_warning_manager),
-    warning_state(_warning_state),
-    max_time(_max_time),
-    found(false),
-    max_alt(_max_alt),
-    mode_inside(false)
-    {      
-    };
-
-  /**
-   * Check whether this intersection should be added to, or updated in, the warning manager
-   *
-   * @param airspace Airspace corresponding to current intersection
-   */
-  void Intersection(const AbstractAirspace& airspace) {
-    if (!airspace.IsActive())
-      return; // ignore inactive airspaces completely
-
-    if (!warning_manager.GetConfig().IsClassEnabled(airspace.GetType()) ||
-        ExcludeAltitude(airspace))
-      return;
-
-    AirspaceWarning *warning = warning_manager.GetWarningPtr(airspace);
-    if (warning == nullptr || warning->IsStateAccepted(warning_state)) {
-
-      AirspaceInterceptSolution solution;
-
-      if (mode_inside) {
-        solution = airspace.Intercept(state, perf,
-                                      state.location, state.location);
-      } else {
-        solution = Intercept(airspace, state, perf);
-      }
-      if (!solution.IsValid())
-        return;
-      if (solution.elapsed_time > max_time)
-        return;
-
-      if (warning == nullptr)
-        warning = warning_manager.GetNewWarningPtr(airspace);
-
-      warning->UpdateSolution(warning_state, solution);
-      found = true;
-    }
-  }
-
-  void Visit(const AbstractAirspace &as) override {
-    Intersection(as);
-  }
-
-  /**
-   * Determine whether intersections for this type were found (new or modified)
-   *
-   * @return True if intersections were found
-   */
-  bool Found() const {
-    return found;
-  }
-
-  void SetMode(bool m) {
-    mode_inside = m;
-  }
-
-private:
-  bool ExcludeAltitude(const AbstractAirspace& airspace) {
-    if (max_alt <= 0)
-      return false;
-
-    return (airspace.GetBaseAltitude(state) > max_alt);
-  }
-};
-
-
-bool 
-AirspaceWarningManager::UpdatePredicted(const AircraftState& state, 
-                                         const GeoPoint &location_predicted,
-                                         const AirspaceAircraftPerformance &perf,
-                                         const AirspaceWarning::State warning_state,
-                                        const double max_time)
+bool
+AirspaceWarningManager::UpdatePredicted(const AircraftState &state,
+                                        const PredictionList &predictions)
 {
-  // this is the time limit of intrusions, beyond which we are not interested.
-  // it can be the minimum of the user set warning time, or the time of the 
-  // task segment
-
-  const auto max_time_limit = std::min(double(config.warning_time), max_time);
+  if (predictions.empty())
+    return false;
 
   // the ceiling is the max height for predicted intrusions, given
   // that you may be climbing.  the ceiling is nominally set at 1000m
@@ -294,41 +183,101 @@ AirspaceWarningManager::UpdatePredicted(const AircraftState& state,
   const auto ceiling = state.altitude
     + std::max((unsigned)1000, config.altitude_warning_margin);
 
-  AirspaceIntersectionWarningVisitor visitor(state, perf, 
-                                             *this, 
-                                             warning_state, max_time_limit,
-                                             ceiling);
+  /* one query for the bounding box of all prediction vectors; it
+     includes all airspaces intersected by any of them, and all
+     airspaces the aircraft is inside */
 
-  airspaces.VisitIntersecting(state.location, location_predicted, visitor);
+  const FlatProjection &projection = GetProjection();
+  const FlatGeoPoint origin = projection.ProjectInteger(state.location);
 
-  visitor.SetMode(true);
+  StaticArray<FlatGeoPoint, 3> ends;
+  FlatBoundingBox box(origin);
+  for (const auto &prediction : predictions) {
+    const FlatGeoPoint end = projection.ProjectInteger(prediction.location);
+    ends.append(end);
+    box.Expand(end);
+  }
 
-  for (const auto &i : airspaces.QueryInside(state.location)) {
+  bool found = false;
+
+  for (const auto &i : airspaces.QueryIntersecting(box)) {
     const AbstractAirspace &airspace = i.GetAirspace();
-    visitor.Visit(airspace);
+
+    if (!airspace.IsActive())
+      continue; // ignore inactive airspaces completely
+
+    if (!config.IsClassEnabled(airspace.GetType()) ||
+        (ceiling > 0 && airspace.GetBaseAltitude(state) > ceiling))
+      continue;
+
+    const FlatBoundingBox &bounds = i;
+    const bool inside = bounds.IsInside(origin) &&
+      airspace.Inside(state.location);
+
+    AirspaceWarning *warning = GetWarningPtr(airspace);
+
+    const auto update = [this, &airspace, &warning, &found]
+      (AirspaceWarning::State warning_state,
+       const AirspaceInterceptSolution &solution, double max_time) {
+      if (!solution.IsValid() || solution.elapsed_time > max_time)
+        return;
+
+      if (warning == nullptr)
+        warning = GetNewWarningPtr(airspace);
+
+      warning->UpdateSolution(warning_state, solution);
+      found = true;
+    };
+
+    for (unsigned j = 0; j < predictions.size(); ++j) {
+      const Prediction &prediction = predictions[j];
+
+      // this is the time limit of intrusions, beyond which we are not
+      // interested.  it can be the minimum of the user set warning
+      // time, or the time of the task segment
+
+      const auto max_time_limit = std::min(double(config.warning_time),
+                                           prediction.max_time);
+
+      if (bounds.Intersects(FlatRay(origin, ends[j])) &&
+          (warning == nullptr ||
+           warning->IsStateAccepted(prediction.warning_state)))
+        update(prediction.warning_state,
+               airspace.Intercept(state, prediction.location,
+                                  projection, prediction.perf),
+               max_time_limit);
+
+      if (inside &&
+          (warning == nullptr ||
+           warning->IsStateAccepted(prediction.warning_state)))
+        update(prediction.warning_state,
+               airspace.Intercept(state, prediction.perf,
+                                  state.location, state.location),
+               max_time_limit);
+    }
   }
 
-  return visitor.Found();
+  return found;
 }
 
-
-bool 
-AirspaceWarningManager::UpdateTask(const AircraftState &state,
-                                   const GlidePolar &glide_polar,
-                                   const TaskStats &task_stats)
+void
+AirspaceWarningManager::PredictTask(const AircraftState &state,
+                                    const GlidePolar &glide_polar,
+                                    const TaskStats &task_stats,
+                                    PredictionList &predictions) const
 {
   if (!glide_polar.IsValid())
-    return false;
+    return;
 
   const ElementStat &current_leg = task_stats.current_leg;
 
   if (!task_stats.task_valid || !current_leg.location_remaining.IsValid())
-    return false;
+    return;
 
   const GlideResult &solution = current_leg.solution_remaining;
   if (!solution.IsOk() || !solution.IsAchievable())
     /* glide solver failed, cannot continue */
-    return false;
+    return;
 
   const AirspaceAircraftPerformance perf_task(glide_polar,
                                               current_leg.solution_remaining);
@@ -342,47 +291,47 @@ AirspaceWarningManager::UpdateTask(const AircraftState &state,
        the configured warning time */
     location_tp = state.location.IntermediatePoint(location_tp, max_distance);
 
-  return UpdatePredicted(state, location_tp, perf_task,
-                          AirspaceWarning::WARNING_TASK, time_remaining);
+  predictions.append(Prediction(location_tp, perf_task,
+                                AirspaceWarning::WARNING_TASK,
+                                time_remaining));
 }
 
 
-bool 
-AirspaceWarningManager::UpdateFilter(const AircraftState& state, const bool circling)
+void
+AirspaceWarningManager::PredictFilter(const AircraftState& state,
+                                      const bool circling,
+                                      PredictionList &predictions)
 {
   // update both filters even though we are using only one
   cruise_filter.Update(state);
   circling_filter.Update(state);
 
-  const GeoPoint location_predicted = circling?
-    circling_filter.GetPredictedState(prediction_time_filter).location:
-    cruise_filter.GetPredictedState(prediction_time_filter).location;
-
-  if (circling) 
-    return UpdatePredicted(state, location_predicted,
-                           AirspaceAircraftPerformance(circling_filter),
-                            AirspaceWarning::WARNING_FILTER, prediction_time_filter);
-  else
-    return UpdatePredicted(state, location_predicted,
-                           AirspaceAircraftPerformance(cruise_filter),
-                            AirspaceWarning::WARNING_FILTER, prediction_time_filter);
+  const AircraftStateFilter &filter = circling
+    ? circling_filter
+    : cruise_filter;
+
+  predictions.append(Prediction(filter.GetPredictedState(prediction_time_filter).location,
+                                AirspaceAircraftPerformance(filter),
+                                AirspaceWarning::WARNING_FILTER,
+                                prediction_time_filter));
 }
 
 
-bool 
-AirspaceWarningManager::UpdateGlide(const AircraftState &state,
-                                    const GlidePolar &glide_polar)
+void
+AirspaceWarningManager::PredictGlide(const AircraftState &state,
+                                     const GlidePolar &glide_polar,
+                                     PredictionList &predictions) const
 {
   if (!glide_polar.IsValid())
-    return false;
+    return;
 
   const GeoPoint location_predicted = 
     state.GetPredictedState(prediction_time_glide).location;
 
   const AirspaceAircraftPerformance perf_glide(glide_polar);
-  return UpdatePredicted(state, location_predicted,
-                          perf_glide,
-                          AirspaceWarning::WARNING_GLIDE, prediction_time_glide);
+  predictions.append(Prediction(location_predicted, perf_glide,
+                                AirspaceWarning::WARNING_GLIDE,
+                                prediction_time_glide));
 }
 
 bool
@@ -24,7 +24,10 @@
 
 #include "AirspaceWarning.hpp"
 #include "AirspaceWarningConfig.hpp"
+#include "AirspaceAircraftPerformance.hpp"
 #include "Util/AircraftStateFilter.hpp"
+#include "Geo/GeoPoint.hpp"
+#include "Util/StaticArray.hxx"
 #include "Util/Compiler.h"
 
 #include <list>
@@ -33,7 +36,6 @@ class TaskStats;
 class GlidePolar;
 class Airspaces;
 class FlatProjection;
-class AirspaceAircraftPerformance;
 
 /**
  * Class to detect and track airspace warnings
@@ -47,6 +49,34 @@ class AirspaceAircraftPerformance;
  *
  */
 class AirspaceWarningManager {
+  /**
+   * A predicted flight vector from the current location, to be
+   * checked against the airspaces by UpdatePredicted().
+   */
+  struct Prediction {
+    GeoPoint location;
+    AirspaceAircraftPerformance perf;
+    AirspaceWarning::State warning_state;
+    double max_time;
+
+    /* default constructor for StaticArray */
+    Prediction()
+      :perf(AirspaceAircraftPerformance::Simple()) {}
+
+    Prediction(const GeoPoint &_location,
+               const AirspaceAircraftPerformance &_perf,
+               AirspaceWarning::State _warning_state,
+               double _max_time)
+      :location(_location), perf(_perf),
+       warning_state(_warning_state), max_time(_max_time) {}
+  };
+
+  /**
+   * The predictions of one Update() call: glide, filter and task, in
+   * this order (from strongest to weakest alert).
+   */
+  typedef StaticArray<Prediction, 3> PredictionList;
+
   AirspaceWarningConfig config;
 
   const Airspaces &airspaces;
@@ -261,17 +291,23 @@ public:
   bool IsActive(const AbstractAirspace &airspace) const;
 
 private:
-  bool UpdateTask(const AircraftState &state, const GlidePolar &glide_polar,
-                  const TaskStats &task_stats);
-  bool UpdateFilter(const AircraftState& state, const bool circling);
-  bool UpdateGlide(const AircraftState& state, const GlidePolar &glide_polar);
+  void PredictTask(const AircraftState &state, const GlidePolar &glide_polar,
+                   const TaskStats &task_stats,
+                   PredictionList &predictions) const;
+  void PredictFilter(const AircraftState& state, const bool circling,
+                     PredictionList &predictions);
+  void PredictGlide(const AircraftState& state, const GlidePolar &glide_polar,
+                    PredictionList &predictions) const;
   bool UpdateInside(const AircraftState& state, const GlidePolar &glide_polar);
 
-  bool UpdatePredicted(const AircraftState& state, 
-                       const GeoPoint &location_predicted,
-                       const AirspaceAircraftPerformance &perf,
-                       const AirspaceWarning::State warning_state,
-                       double max_time);
+  /**
+   * Check all predictions against the airspaces.  The candidate
+   * airspaces for all prediction vectors (and those the aircraft is
+   * inside) are collected in one query, and each candidate is then
+   * checked against each prediction.
+   */
+  bool UpdatePredicted(const AircraftState& state,
+                       const PredictionList &predictions);
 };
 
 #endif
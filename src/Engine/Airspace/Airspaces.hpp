@@ -93,6 +93,14 @@ public:
    */
   void Add(AbstractAirspace *asp);
 
+  /**
+   * Returns the airspaces which were added with Add(), but have not
+   * yet been inserted into the tree by Optimise().
+   */
+  const std::deque<AbstractAirspace *> &GetPending() const {
+    return tmp_as;
+  }
+
   /**
    * Re-organise the internal airspace tree after inserting/deleting.
    * Should be called after inserting/deleting airspaces prior to performing
@@ -170,6 +178,13 @@ public:
   const_iterator_range QueryIntersecting(const GeoPoint &a,
                                          const GeoPoint &b) const;
 
+  /**
+   * Query airspaces whose bounding box intersects the given
+   * (projected) bounding box.  The result is in no specific order.
+   */
+  gcc_pure
+  const_iterator_range QueryIntersecting(const FlatBoundingBox &box) const;
+
   /**
    * Call visitor class on airspaces intersected by vector.
    * Note that the visitor is not instantiated separately for each match
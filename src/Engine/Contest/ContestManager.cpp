@@ -21,6 +21,8 @@
  */
 
 #include "ContestManager.hpp"
+#include "Time/TimeoutClock.hpp"
+#include "Thread/ThreadPool.hpp"
 
 ContestManager::ContestManager(const Contest _contest,
                                const Trace &trace_full,
@@ -59,6 +61,16 @@ ContestManager::SetIncremental(bool incremental)
   net_coupe.SetIncremental(incremental);
 }
 
+void
+ContestManager::SetThreadPool(ThreadPool *pool)
+{
+  thread_pool = pool;
+
+  olc_fai.SetThreadPool(pool);
+  xcontest_triangle.SetThreadPool(pool);
+  dhv_xc_triangle.SetThreadPool(pool);
+}
+
 void
 ContestManager::SetPredicted(const TracePoint &predicted)
 {
@@ -93,107 +105,129 @@ ContestManager::SetHandicap(unsigned handicap)
   net_coupe.SetHandicap(handicap);
 }
 
+/**
+ * Run the solver and store its result (if it has found one) and the
+ * time it has spent in the given slot of #ContestStatistics.
+ */
 static bool
-RunContest(AbstractContest &_contest,
-           ContestResult &result, ContestTraceVector &solution,
-           bool exhaustive)
+RunContest(AbstractContest &_contest, ContestStatistics &stats,
+           unsigned i, bool exhaustive, const TimeoutClock *deadline)
 {
+  const auto start = std::chrono::steady_clock::now();
+
   // run solver, return immediately if further processing is required
   // by subsequent calls
-  SolverResult r = _contest.Solve(exhaustive);
+  SolverResult r = _contest.Solve(exhaustive, deadline);
+
+  stats.solve_time[i] = std::chrono::steady_clock::now() - start;
+
   if (r != SolverResult::VALID)
     return false;
 
   // if no improved solution was found, must have finished processing
   // with invalid data
-  result = _contest.GetBestResult();
+  stats.result[i] = _contest.GetBestResult();
 
   // solver finished and improved solution was found.  save solution
   // and retrieve new trace.
 
-  solution = _contest.GetBestSolution();
+  stats.solution[i] = _contest.GetBestSolution();
 
   return true;
 }
 
+bool
+ContestManager::RunContests(AbstractContest &a, unsigned a_index,
+                            AbstractContest &b, unsigned b_index,
+                            bool exhaustive, const TimeoutClock *deadline)
+{
+  if (!exhaustive || thread_pool == nullptr) {
+    bool retval = RunContest(a, stats, a_index, exhaustive, deadline);
+    retval |= RunContest(b, stats, b_index, exhaustive, deadline);
+    return retval;
+  }
+
+  /* the solvers share only the (read-only) traces, and each one
+     writes a different slot of #stats */
+  bool results[2];
+  thread_pool->Run(2, [&](unsigned i){
+      results[i] = i == 0
+        ? RunContest(a, stats, a_index, exhaustive, deadline)
+        : RunContest(b, stats, b_index, exhaustive, deadline);
+    });
+
+  return results[0] || results[1];
+}
+
 bool
 ContestManager::UpdateIdle(bool exhaustive)
 {
   bool retval = false;
 
+  /* all solvers of this call share one deadline */
+  const TimeoutClock deadline(tick_budget);
+  const TimeoutClock *const deadline_ptr =
+    exhaustive || tick_budget <= std::chrono::steady_clock::duration::zero()
+    ? nullptr
+    : &deadline;
+
   switch (contest) {
   case Contest::NONE:
     break;
 
   case Contest::OLC_SPRINT:
-    retval = RunContest(olc_sprint, stats.result[0],
-                        stats.solution[0], exhaustive);
+    retval = RunContest(olc_sprint, stats, 0, exhaustive, deadline_ptr);
     break;
 
   case Contest::OLC_FAI:
-    retval = RunContest(olc_fai, stats.result[0],
-                        stats.solution[0], exhaustive);
+    retval = RunContest(olc_fai, stats, 0, exhaustive, deadline_ptr);
     break;
 
   case Contest::OLC_CLASSIC:
-    retval = RunContest(olc_classic, stats.result[0],
-                        stats.solution[0], exhaustive);
+    retval = RunContest(olc_classic, stats, 0, exhaustive, deadline_ptr);
     break;
 
   case Contest::OLC_LEAGUE:
-    retval = RunContest(olc_classic, stats.result[1],
-                        stats.solution[1], exhaustive);
+    retval = RunContest(olc_classic, stats, 1, exhaustive, deadline_ptr);
 
     olc_league.Feed(stats.solution[1]);
 
-    retval |= RunContest(olc_league, stats.result[0],
-                         stats.solution[0], exhaustive);
+    retval |= RunContest(olc_league, stats, 0, exhaustive, deadline_ptr);
     break;
 
   case Contest::OLC_PLUS:
-    retval = RunContest(olc_classic, stats.result[0],
-                        stats.solution[0], exhaustive);
-
-    retval |= RunContest(olc_fai, stats.result[1],
-                         stats.solution[1], exhaustive);
+    retval = RunContests(olc_classic, 0, olc_fai, 1,
+                         exhaustive, deadline_ptr);
 
     if (retval) {
       olc_plus.Feed(stats.result[0], stats.solution[0],
                     stats.result[1], stats.solution[1]);
 
-      RunContest(olc_plus, stats.result[2],
-                 stats.solution[2], exhaustive);
+      RunContest(olc_plus, stats, 2, exhaustive, deadline_ptr);
     }
 
     break;
 
   case Contest::DMST:
-    retval = RunContest(dmst_quad, stats.result[0],
-                        stats.solution[0], exhaustive);
+    retval = RunContest(dmst_quad, stats, 0, exhaustive, deadline_ptr);
     break;
 
   case Contest::XCONTEST:
-    retval = RunContest(xcontest_free, stats.result[0],
-                        stats.solution[0], exhaustive);
-    retval |= RunContest(xcontest_triangle, stats.result[1],
-                         stats.solution[1], exhaustive);
+    retval = RunContests(xcontest_free, 0, xcontest_triangle, 1,
+                         exhaustive, deadline_ptr);
     break;
 
   case Contest::DHV_XC:
-    retval = RunContest(dhv_xc_free, stats.result[0],
-                        stats.solution[0], exhaustive);
-    retval |= RunContest(dhv_xc_triangle, stats.result[1],
-                         stats.solution[1], exhaustive);
+    retval = RunContests(dhv_xc_free, 0, dhv_xc_triangle, 1,
+                         exhaustive, deadline_ptr);
     break;
 
   case Contest::SIS_AT:
-    retval = RunContest(sis_at, stats.result[0],
-                        stats.solution[0], exhaustive);
+    retval = RunContest(sis_at, stats, 0, exhaustive, deadline_ptr);
     break;
 
   case Contest::NET_COUPE:
-    retval = RunContest(net_coupe, stats.result[0],
-                        stats.solution[0], exhaustive);
+    retval = RunContest(net_coupe, stats, 0, exhaustive, deadline_ptr);
     break;
 
   };
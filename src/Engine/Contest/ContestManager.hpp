@@ -36,7 +36,11 @@
 #include "Solvers/NetCoupe.hpp"
 #include "ContestStatistics.hpp"
 
+#include <chrono>
+
 class Trace;
+class ThreadPool;
+class TimeoutClock;
 
 /**
  * Special task holder for Online Contest calculations
@@ -62,6 +66,19 @@ class ContestManager
   OLCSISAT sis_at;
   NetCoupe net_coupe;
 
+  /**
+   * The time budget of one incremental UpdateIdle() call.  Zero
+   * means the solvers stop after a fixed number of iterations.
+   */
+  std::chrono::steady_clock::duration tick_budget =
+    std::chrono::steady_clock::duration::zero();
+
+  /**
+   * An optional #ThreadPool which runs independent solvers in
+   * parallel during exhaustive solving.
+   */
+  ThreadPool *thread_pool = nullptr;
+
 public:
   /**
    * Base constructor.
@@ -85,6 +102,18 @@ public:
 
   void SetIncremental(bool incremental);
 
+  /**
+   * Use the given #ThreadPool for exhaustive solving: independent
+   * solvers (e.g. the free flight and the triangle of XContest) run
+   * in parallel, and the triangle solvers use it, too (see
+   * TriangleContest::SetThreadPool()).  The result is the same as
+   * with serial solving.
+   *
+   * @param pool the #ThreadPool or nullptr to solve serially; it must
+   * remain valid until this method is called again
+   */
+  void SetThreadPool(ThreadPool *pool);
+
   /**
    * @see ContestDijkstra::SetPredicted()
    */
@@ -96,12 +125,26 @@ public:
 
   void SetHandicap(unsigned handicap);
 
+  /**
+   * Limit the time spent by each incremental UpdateIdle() call.  The
+   * solvers suspend their search when the budget is used up, and
+   * resume it on the next call.  The time which was actually used by
+   * each solver is reported in ContestStatistics::solve_time.
+   *
+   * @param budget the budget shared by all solvers of one call, or
+   * zero to stop each solver after a fixed number of iterations
+   */
+  void SetTickBudget(std::chrono::steady_clock::duration budget) {
+    tick_budget = budget;
+  }
+
   /**
    * Update internal states (non-essential) for housework,
    * or where functions are slow and would cause loss to real-time performance.
    *
    * @param exhaustive true to find the final solution, false stops
-   * after a number of iterations (incremental search)
+   * after a number of iterations or when the tick budget is used up
+   * (incremental search)
    * @return True if internal state changed
    */
   bool UpdateIdle(bool exhaustive = false);
@@ -130,6 +173,15 @@ public:
   const ContestStatistics &GetStats() const {
     return stats;
   }
+
+private:
+  /**
+   * Run two independent solvers; in parallel if this is an
+   * exhaustive run and there is a #ThreadPool.
+   */
+  bool RunContests(AbstractContest &a, unsigned a_index,
+                   AbstractContest &b, unsigned b_index,
+                   bool exhaustive, const TimeoutClock *deadline);
 };
 
 #endif
@@ -27,15 +27,24 @@
 #include "ContestTrace.hpp"
 #include "Util/TypeTraits.hpp"
 
+#include <chrono>
+
 struct ContestStatistics
 {
   ContestResult result[3];
   ContestTraceVector solution[3];
 
+  /**
+   * The time spent by the solver of each result during the last
+   * ContestManager::UpdateIdle() call.
+   */
+  std::chrono::steady_clock::duration solve_time[3];
+
   void Reset() {
     for (unsigned i = 0; i < 3; ++i) {
       solution[i].clear();
       result[i].Reset();
+      solve_time[i] = std::chrono::steady_clock::duration::zero();
     }
   }
 
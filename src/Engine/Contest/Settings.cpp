@@ -29,4 +29,5 @@ ContestSettings::SetDefaults()
   predict = false;
   contest = Contest::OLC_PLUS;
   handicap = 100;
+  tick_budget = 20;
 }
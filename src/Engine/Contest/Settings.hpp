@@ -66,6 +66,13 @@ struct ContestSettings {
   /** Handicap factor */
   unsigned handicap;
 
+  /**
+   * The time budget [ms] of one incremental solver run in the
+   * background.  Zero means the solvers stop after a fixed number of
+   * iterations.
+   */
+  unsigned tick_budget;
+
   void SetDefaults();
 };
 
@@ -31,6 +31,7 @@
 #include <cassert>
 
 class TracePoint;
+class TimeoutClock;
 
 /**
  * Abstract class for contest searches
@@ -97,8 +98,12 @@ public:
    *
    * @param exhaustive true to find the final solution, false stops
    * after a number of iterations (incremental search)
+   * @param deadline if not nullptr, then an incremental search stops
+   * (soon) after this deadline has expired instead of after a fixed
+   * number of iterations; it is ignored by the exhaustive search
    */
-  virtual SolverResult Solve(bool exhaustive) noexcept = 0;
+  virtual SolverResult Solve(bool exhaustive,
+                             const TimeoutClock *deadline) noexcept = 0;
 
 protected:
   /**
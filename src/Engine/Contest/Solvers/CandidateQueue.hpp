@@ -0,0 +1,251 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_CONTEST_CANDIDATE_QUEUE_HPP
+#define XCSOAR_CONTEST_CANDIDATE_QUEUE_HPP
+
+#include "Util/Compiler.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+
+/**
+ * An ordered container of values with an unsigned key, used as the
+ * branch and bound tree of #TriangleContest.  It orders its entries
+ * like a std::multimap (values with equal keys stay in insertion
+ * order), but instead of allocating one node per entry, it keeps the
+ * keys in a list of small sorted blocks, and the values in an array
+ * which recycles its slots.
+ */
+template<typename T>
+class CandidateQueue {
+  /**
+   * Blocks which grow larger than this are split in two.
+   */
+  static constexpr unsigned MAX_BLOCK_SIZE = 256;
+
+  struct Entry {
+    unsigned key;
+
+    /**
+     * The index of the value in #values.
+     */
+    unsigned value;
+  };
+
+  typedef std::vector<Entry> Block;
+
+  /**
+   * The entries sorted by key.  There are no empty blocks.
+   */
+  std::vector<Block> blocks;
+
+  std::vector<T> values;
+
+  /**
+   * Unused slots in #values.
+   */
+  std::vector<unsigned> free_values;
+
+  unsigned n_entries = 0;
+
+public:
+  /**
+   * Refers to one entry.  It becomes invalid when the container is
+   * modified.
+   */
+  struct Position {
+    unsigned block, offset;
+  };
+
+  bool empty() const noexcept {
+    return n_entries == 0;
+  }
+
+  unsigned size() const noexcept {
+    return n_entries;
+  }
+
+  void clear() noexcept {
+    blocks.clear();
+    values.clear();
+    free_values.clear();
+    n_entries = 0;
+  }
+
+  gcc_pure
+  unsigned GetKey(Position p) const noexcept {
+    return blocks[p.block][p.offset].key;
+  }
+
+  /**
+   * Returns a reference to the value.  It becomes invalid when the
+   * container is modified.
+   */
+  gcc_pure
+  const T &Get(Position p) const noexcept {
+    return values[blocks[p.block][p.offset].value];
+  }
+
+  /**
+   * Returns the entry with the largest key; of several such entries,
+   * the one which was inserted last.
+   */
+  gcc_pure
+  Position Last() const noexcept {
+    assert(!empty());
+
+    return {unsigned(blocks.size() - 1), unsigned(blocks.back().size() - 1)};
+  }
+
+  /**
+   * Returns the first entry whose key is larger than the given one,
+   * or Last() if there is none.
+   */
+  gcc_pure
+  Position UpperBound(unsigned key) const noexcept {
+    assert(!empty());
+
+    const unsigned b = FindBlock(key);
+    if (b == blocks.size())
+      return Last();
+
+    const Block &block = blocks[b];
+    return {b, unsigned(std::upper_bound(block.begin(), block.end(),
+                                         key, CompareKeyEntry)
+                        - block.begin())};
+  }
+
+  /**
+   * Insert a value after all entries with the same key.
+   */
+  void Insert(unsigned key, const T &value) noexcept {
+    unsigned index;
+    if (free_values.empty()) {
+      index = values.size();
+      values.push_back(value);
+    } else {
+      index = free_values.back();
+      free_values.pop_back();
+      values[index] = value;
+    }
+
+    const Entry entry{key, index};
+    ++n_entries;
+
+    if (blocks.empty()) {
+      blocks.emplace_back();
+      blocks.back().push_back(entry);
+      return;
+    }
+
+    unsigned b = FindBlock(key);
+    if (b == blocks.size()) {
+      /* larger than all other keys: append */
+      --b;
+      blocks[b].push_back(entry);
+    } else {
+      Block &block = blocks[b];
+      block.insert(std::upper_bound(block.begin(), block.end(),
+                                    key, CompareKeyEntry),
+                   entry);
+    }
+
+    if (blocks[b].size() > MAX_BLOCK_SIZE)
+      SplitBlock(b);
+  }
+
+  void Erase(Position p) noexcept {
+    Block &block = blocks[p.block];
+    free_values.push_back(block[p.offset].value);
+    --n_entries;
+
+    block.erase(block.begin() + p.offset);
+    if (block.empty())
+      blocks.erase(blocks.begin() + p.block);
+  }
+
+  /**
+   * Erase all entries whose key is smaller than the given one.
+   */
+  void EraseBelow(unsigned key) noexcept {
+    /* first drop whole blocks */
+    auto b = std::partition_point(blocks.begin(), blocks.end(),
+                                  [key](const Block &block){
+                                    return block.back().key < key;
+                                  });
+    for (auto i = blocks.begin(); i != b; ++i)
+      Free(i->begin(), i->end());
+    blocks.erase(blocks.begin(), b);
+
+    /* then the beginning of the first remaining one */
+    if (!blocks.empty()) {
+      Block &block = blocks.front();
+      auto end = std::lower_bound(block.begin(), block.end(), key,
+                                  CompareEntryKey);
+      Free(block.begin(), end);
+      block.erase(block.begin(), end);
+    }
+  }
+
+private:
+  static bool CompareKeyEntry(unsigned key, const Entry &entry) noexcept {
+    return key < entry.key;
+  }
+
+  static bool CompareEntryKey(const Entry &entry, unsigned key) noexcept {
+    return entry.key < key;
+  }
+
+  /**
+   * Returns the index of the first block which contains a key larger
+   * than the given one, or blocks.size() if there is none.
+   */
+  gcc_pure
+  unsigned FindBlock(unsigned key) const noexcept {
+    return std::upper_bound(blocks.begin(), blocks.end(), key,
+                            [](unsigned key, const Block &block){
+                              return key < block.back().key;
+                            }) - blocks.begin();
+  }
+
+  void SplitBlock(unsigned b) noexcept {
+    Block &block = blocks[b];
+    const auto middle = block.begin() + block.size() / 2;
+    Block tail(middle, block.end());
+    block.erase(middle, block.end());
+    blocks.insert(blocks.begin() + b + 1, std::move(tail));
+  }
+
+  void Free(typename Block::const_iterator begin,
+            typename Block::const_iterator end) noexcept {
+    for (auto i = begin; i != end; ++i)
+      free_values.push_back(i->value);
+
+    n_entries -= end - begin;
+  }
+};
+
+#endif
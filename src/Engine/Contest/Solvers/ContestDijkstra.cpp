@@ -25,6 +25,7 @@ Copyright_License {
 #include "../ContestResult.hpp"
 #include "Trace/Trace.hpp"
 #include "Cast.hpp"
+#include "Time/TimeoutClock.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -32,6 +33,9 @@ Copyright_License {
 // set size of reserved queue elements (may differ from Dijkstra default)
 static constexpr unsigned CONTEST_QUEUE_SIZE = 5000;
 
+// number of Dijkstra steps per incremental run (or between two deadline checks)
+static constexpr unsigned INCREMENTAL_STEPS = 25;
+
 ContestDijkstra::ContestDijkstra(const Trace &_trace,
                                  bool _continuous,
                                  const unsigned n_legs,
@@ -55,10 +59,19 @@ ContestDijkstra::UpdateTrace(bool force) noexcept
   if (IsMasterUpdated(continuous)) {
     UpdateTraceFull();
 
-    trace_dirty = true;
-    finished = false;
+    unsigned first_new_point;
+    if (finished && incremental && continuous &&
+        PatchEdges(first_new_point)) {
+      /* the edge map has survived the thinning; resume the
+         incremental solver with the new points (if any) */
+      if (first_new_point < n_points)
+        AddIncrementalEdges(first_new_point);
+    } else {
+      trace_dirty = true;
+      finished = false;
 
-    first_finish_candidate = incremental ? n_points - 1 : 0;
+      first_finish_candidate = incremental ? n_points - 1 : 0;
+    }
   } else if (finished) {
     const unsigned old_size = n_points;
     if (UpdateTraceTail())
@@ -81,10 +94,22 @@ ContestDijkstra::UpdateTrace(bool force) noexcept
       first_finish_candidate = incremental ? n_points - 1 : 0;
     }
   }
+
+  if (incremental && continuous)
+    SavePointTimes();
+}
+
+void
+ContestDijkstra::SavePointTimes() noexcept
+{
+  point_times.clear();
+  point_times.reserve(n_points);
+  for (unsigned i = 0; i < n_points; ++i)
+    point_times.push_back(TraceManager::GetPoint(i).GetTime());
 }
 
 SolverResult
-ContestDijkstra::Solve(bool exhaustive) noexcept
+ContestDijkstra::Solve(bool exhaustive, const TimeoutClock *deadline) noexcept
 {
   assert(num_stages <= MAX_STAGES);
 
@@ -126,7 +151,16 @@ ContestDijkstra::Solve(bool exhaustive) noexcept
       return SolverResult::FAILED;
   }
 
-  SolverResult result = DistanceGeneral(exhaustive ? 0 - 1 : 25);
+  SolverResult result;
+  if (exhaustive || deadline == nullptr)
+    result = DistanceGeneral(exhaustive ? 0 - 1 : INCREMENTAL_STEPS);
+  else
+    /* run in small slices until the deadline expires; at least one
+       slice is run, to guarantee progress */
+    do {
+      result = DistanceGeneral(INCREMENTAL_STEPS);
+    } while (result == SolverResult::INCOMPLETE && !deadline->HasExpired());
+
   if (result != SolverResult::INCOMPLETE) {
     if (incremental && continuous)
       /* enable the incremental solver, which considers the existing
@@ -239,14 +273,26 @@ ContestDijkstra::AddEdges(const ScanTaskPoint origin,
 
   const unsigned weight = GetStageWeight(origin.GetStageNumber());
 
+  /* calculate all distances in one pass over the contiguous
+     coordinate arrays of the snapshot */
+  const unsigned first = destination.GetPointIndex();
+  assert(first <= n_points);
+  assert(snapshot.size() == n_points);
+
+  edge_distances.resize(n_points - first);
+  snapshot.CalcFlatDistances(snapshot.GetFlatLocation(origin.GetPointIndex()),
+                             first, n_points, edge_distances.data());
+
+  const int *const altitudes = snapshot.GetIntegerAltitudes();
+  const unsigned *distance = edge_distances.data();
+
   bool previous_above = false;
   for (const ScanTaskPoint end(destination.GetStageNumber(), n_points);
-       destination != end; destination.IncrementPointIndex()) {
-    bool above = GetPoint(destination).GetIntegerAltitude() >= min_altitude;
+       destination != end; destination.IncrementPointIndex(), ++distance) {
+    bool above = altitudes[destination.GetPointIndex()] >= min_altitude;
 
     if (above) {
-      const unsigned d = weight * CalcEdgeDistance(origin, destination);
-      Link(destination, origin, d);
+      Link(destination, origin, weight * *distance);
     } else if (previous_above) {
       /* After excessive thinning, the exact TracePoint that matches
          the required altitude difference may be gone, and the
@@ -255,8 +301,7 @@ ContestDijkstra::AddEdges(const ScanTaskPoint origin,
          matches. */
 
       /* TODO: interpolate the distance */
-      const unsigned d = weight * CalcEdgeDistance(origin, destination);
-      Link(destination, origin, d);
+      Link(destination, origin, weight * *distance);
     }
 
     previous_above = above;
@@ -286,30 +331,25 @@ ContestDijkstra::AddIncrementalEdges(unsigned first_point) noexcept
   finished = false;
   first_finish_candidate = first_point;
 
-  /* we need a copy of the current edge map, because the following
-     loop will modify it, invalidating the iterator */
-#if GCC_VERSION < 40800 || GCC_VERSION > 40802
-  const Dijkstra::EdgeMap edges = dijkstra.GetEdgeMap();
-#else
-  // workaround for http://gcc.gnu.org/bugzilla/show_bug.cgi?id=59548
-  Dijkstra::EdgeMap edges;
-  edges = dijkstra.GetEdgeMap();
-#endif
+  /* we need a copy of the current (non-final) nodes, because the
+     following loop will modify the edge map, invalidating the
+     iterator */
+  incremental_nodes.clear();
+  for (const auto &i : dijkstra.GetEdgeMap())
+    /* ignore final nodes */
+    if (!IsFinal(i.first))
+      incremental_nodes.push_back({i.first, i.second.value});
 
   /* establish links between each old node and each new node, to
      initiate the follow-up search, hoping a better solution will be
      found here */
-  for (const auto &i : edges) {
-    if (IsFinal(i.first))
-      /* ignore final nodes */
-      continue;
-
+  for (const auto &i : incremental_nodes) {
     /* "seek" the Dijkstra object to the current "old" node */
-    dijkstra.SetCurrentValue(i.second.value);
+    dijkstra.SetCurrentValue(i.value);
 
     /* add edges from the current "old" node to all "new" nodes
        (first_point .. n_points-1) */
-    AddEdges(i.first, first_point);
+    AddEdges(i.node, first_point);
   }
 
   /* see if new start points are possible now (due to relaxed start
@@ -318,6 +358,158 @@ ContestDijkstra::AddIncrementalEdges(unsigned first_point) noexcept
   AddStartEdges();
 }
 
+bool
+ContestDijkstra::PatchEdges(unsigned &first_new_point) noexcept
+{
+  assert(continuous);
+  assert(incremental);
+  assert(finished);
+
+  static constexpr unsigned REMOVED = -1;
+
+  /* map the old point indices to the new ones; the time stamps are
+     unique and ascending in both lists */
+  std::vector<unsigned> index_map(point_times.size(), REMOVED);
+  first_new_point = 0;
+  for (unsigned i = 0, j = 0; i < point_times.size() && j < n_points;) {
+    const unsigned time = TraceManager::GetPoint(j).GetTime();
+    if (point_times[i] < time)
+      ++i;
+    else if (point_times[i] > time)
+      ++j;
+    else {
+      index_map[i++] = j++;
+      first_new_point = j;
+    }
+  }
+
+  if (first_new_point == 0)
+    /* all old points are gone */
+    return false;
+
+  const auto Remap = [&index_map](unsigned i){
+    return i == predicted_index ? predicted_index : index_map[i];
+  };
+
+  /* sort the old edge map by stage and point index */
+  struct OldEdge {
+    unsigned point_index, parent_index, value;
+
+    bool operator<(const OldEdge &other) const noexcept {
+      return point_index < other.point_index;
+    }
+  };
+
+  std::vector<OldEdge> old_edges[MAX_STAGES];
+  for (const auto &i : dijkstra.GetEdgeMap())
+    old_edges[i.first.GetStageNumber()]
+      .push_back({i.first.GetPointIndex(),
+                  i.second.parent.GetPointIndex(),
+                  i.second.value});
+
+  dijkstra.Clear();
+
+  /* the nodes of the previous stage which have been inserted into
+     the new edge map, and whether they were linked to a new
+     predecessor */
+  struct NewNode {
+    unsigned point_index, value;
+    bool patched;
+  };
+
+  std::vector<NewNode> previous, current;
+
+  for (unsigned stage = 0; stage < num_stages; ++stage) {
+    auto &edges = old_edges[stage];
+    std::sort(edges.begin(), edges.end());
+
+    current.clear();
+
+    for (const auto &edge : edges) {
+      const unsigned point_index = Remap(edge.point_index);
+      if (point_index == REMOVED)
+        continue;
+
+      const ScanTaskPoint node(stage, point_index);
+
+      if (stage == 0) {
+        dijkstra.SetCurrentValue(edge.value);
+        LinkStart(node);
+        current.push_back({point_index, edge.value, false});
+        continue;
+      }
+
+      /* find the old predecessor among the nodes of the previous
+         stage */
+      const unsigned parent_index = Remap(edge.parent_index);
+      const auto parent =
+        std::lower_bound(previous.begin(), previous.end(), parent_index,
+                         [](const NewNode &a, unsigned b){
+                           return a.point_index < b;
+                         });
+
+      if (parent != previous.end() && parent->point_index == parent_index &&
+          !parent->patched) {
+        /* the chain is intact: keep this edge */
+        dijkstra.SetCurrentValue(edge.value);
+        dijkstra.Link(node, ScanTaskPoint(stage - 1, parent_index), 0);
+        current.push_back({point_index, edge.value, false});
+        continue;
+      }
+
+      /* the chain contained a removed point: link this node to the
+         best remaining predecessor, applying the same constraints as
+         AddEdges() */
+      const bool predicted_node = point_index == predicted_index;
+      const unsigned weight = GetStageWeight(stage - 1);
+      bool linked = false;
+      for (const auto &origin : previous) {
+        if (!predicted_node && origin.point_index > point_index)
+          break;
+
+        const ScanTaskPoint origin_node(stage - 1, origin.point_index);
+        const TracePoint &origin_point = GetPoint(origin_node);
+
+        if (predicted_node) {
+          dijkstra.SetCurrentValue(origin.value);
+          Link(node, origin_node,
+               weight * origin_point.FlatDistanceTo(predicted));
+          linked = true;
+          continue;
+        }
+
+        if (IsFinal(node)) {
+          const int min_altitude =
+            GetMinimumFinishAltitude(GetPoint(FindStart(origin_node)));
+          if (GetPoint(node).GetIntegerAltitude() < min_altitude &&
+              (point_index == origin.point_index ||
+               TraceManager::GetPoint(point_index - 1)
+               .GetIntegerAltitude() < min_altitude))
+            continue;
+        }
+
+        dijkstra.SetCurrentValue(origin.value);
+        Link(node, origin_node, weight * CalcEdgeDistance(origin_node, node));
+        linked = true;
+      }
+
+      if (linked)
+        current.push_back({point_index,
+                           dijkstra.GetEdgeMap().find(node)->second.value,
+                           true});
+    }
+
+    previous.swap(current);
+  }
+
+  /* the old Dijkstra search had finished; the patched edge map does
+     not need to be searched again */
+  dijkstra.ClearQueue();
+  dijkstra.Reserve(CONTEST_QUEUE_SIZE);
+
+  return true;
+}
+
 void
 ContestDijkstra::CopySolution(ContestTraceVector &result) const noexcept
 {
@@ -28,6 +28,7 @@ Copyright_License {
 #include "PathSolvers/NavDijkstra.hpp"
 #include "TraceManager.hpp"
 
+#include <vector>
 #include <cassert>
 
 class Trace;
@@ -66,6 +67,50 @@ class ContestDijkstra : public AbstractContest, protected NavDijkstra, public Tr
    */
   ContestTraceVector solution;
 
+  /**
+   * The time stamps of the points in TraceManager::trace.  Unlike
+   * the #TracePoint pointers, they remain valid after the master
+   * #Trace has been thinned, and allow mapping the nodes of the
+   * Dijkstra edge map to the new point indices.  Only maintained
+   * during incremental continuous search.
+   */
+  std::vector<unsigned> point_times;
+
+  struct IncrementalNode {
+    ScanTaskPoint node;
+    unsigned value;
+  };
+
+  /**
+   * A copy of the non-final nodes, used by AddIncrementalEdges().
+   * This is a member only to reuse its memory.
+   */
+  std::vector<IncrementalNode> incremental_nodes;
+
+  /**
+   * The edge distances calculated by AddEdges().  This is a member
+   * only to reuse its memory.
+   */
+  std::vector<unsigned> edge_distances;
+
+  void SavePointTimes() noexcept;
+
+  /**
+   * Points have been removed from the master #Trace (usually by
+   * thinning) after the incremental solver had finished, and
+   * UpdateTraceFull() has obtained a new copy.  Instead of discarding
+   * the Dijkstra edge map, patch it: nodes of removed points are
+   * dropped, and nodes whose chain contained a removed point are
+   * linked to their best remaining predecessor, one stage after the
+   * other.
+   *
+   * @param first_new_point receives the index of the first point
+   * which was not in the old trace
+   * @return false if nothing could be salvaged, and the search must
+   * be restarted from scratch
+   */
+  bool PatchEdges(unsigned &first_new_point) noexcept;
+
 protected:
   /**
    * The index of the first finish candidate.  During incremental
@@ -166,7 +211,8 @@ protected:
 
 public:
   /* public virtual methods from AbstractContest */
-  SolverResult Solve(bool exhaustive) noexcept override;
+  SolverResult Solve(bool exhaustive,
+                     const TimeoutClock *deadline) noexcept override;
   void Reset() noexcept override;
 
 protected:
@@ -41,7 +41,7 @@ OLCLeague::Reset() noexcept
 }
 
 SolverResult
-OLCLeague::Solve(bool exhaustive) noexcept
+OLCLeague::Solve(bool exhaustive, const TimeoutClock *deadline) noexcept
 {
   if (trace.size() < 2)
     return SolverResult::FAILED;
@@ -56,7 +56,8 @@ protected:
 public:
   /* virtual methods from class AbstractContest */
   void Reset() noexcept override;
-  SolverResult Solve(bool exhaustive) noexcept override;
+  SolverResult Solve(bool exhaustive,
+                     const TimeoutClock *deadline) noexcept override;
   void CopySolution(ContestTraceVector &vec) const noexcept override;
 };
 
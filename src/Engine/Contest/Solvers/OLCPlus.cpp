@@ -38,7 +38,7 @@ OLCPlus::Reset() noexcept
 }
 
 SolverResult
-OLCPlus::Solve(bool exhaustive) noexcept
+OLCPlus::Solve(bool exhaustive, const TimeoutClock *deadline) noexcept
 {
   return SaveSolution()
     ? SolverResult::VALID
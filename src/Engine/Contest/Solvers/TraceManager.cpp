@@ -97,6 +97,7 @@ TraceManager::ClearTrace() noexcept
   append_serial = modify_serial = Serial();
   trace_dirty = true;
   trace.clear();
+  snapshot.clear();
   n_points = 0;
   predicted = TracePoint::Invalid();
 }
@@ -106,6 +107,7 @@ TraceManager::UpdateTraceFull() noexcept
 {
   trace.reserve(trace_master.GetMaxSize());
   trace_master.GetPoints(trace);
+  snapshot.Update(trace_master);
   n_points = trace.size();
 
   if (n_points > 0 && predicted.IsDefined())
@@ -128,6 +130,7 @@ TraceManager::UpdateTraceTail() noexcept
     /* no new points */
     return false;
 
+  snapshot.Update(trace_master);
   n_points = trace.size();
 
   if (n_points > 0 && predicted.IsDefined())
@@ -26,6 +26,7 @@ Copyright_License {
 
 #include "Util/Serial.hpp"
 #include "Trace/Trace.hpp"
+#include "Trace/Snapshot.hpp"
 #include "Trace/Vector.hpp"
 #include "Trace/Point.hpp"
 
@@ -56,6 +57,12 @@ protected:
    */
   TracePointerVector trace;
 
+  /**
+   * A copy of the same points in "structure of arrays" layout, for
+   * loops which need only some attributes of many points.
+   */
+  TraceSnapshot snapshot;
+
   /** Number of points in current trace set */
   unsigned n_points;
 
@@ -24,6 +24,8 @@
 #include "Cast.hpp"
 #include "Trace/Trace.hpp"
 #include "Util/QuadTree.hxx"
+#include "Thread/ThreadPool.hpp"
+#include "Time/TimeoutClock.hpp"
 
 /*
  @todo potential to use 3d convex hull to speed search
@@ -55,6 +57,12 @@
  */
 static constexpr double max_distance(1000);
 
+/**
+ * The number of branch and bound iterations between two deadline
+ * checks.
+ */
+static constexpr unsigned DEADLINE_CHECK_INTERVAL = 64;
+
 TriangleContest::TriangleContest(const Trace &_trace,
                                  bool _predict,
                                  const unsigned _finish_alt_diff) noexcept
@@ -138,7 +146,7 @@ TriangleContest::UpdateTrace(bool force) noexcept
 }
 
 SolverResult
-TriangleContest::Solve(bool exhaustive) noexcept
+TriangleContest::Solve(bool exhaustive, const TimeoutClock *deadline) noexcept
 {
   if (trace_master.size() < 3) {
     ClearTrace();
@@ -158,7 +166,7 @@ TriangleContest::Solve(bool exhaustive) noexcept
     }
 
     if (is_closed)
-      SolveTriangle(exhaustive);
+      SolveTriangle(exhaustive, deadline);
 
     if (!SaveSolution())
       return SolverResult::FAILED;
@@ -170,7 +178,8 @@ TriangleContest::Solve(bool exhaustive) noexcept
 }
 
 void
-TriangleContest::SolveTriangle(bool exhaustive) noexcept
+TriangleContest::SolveTriangle(bool exhaustive,
+                               const TimeoutClock *deadline) noexcept
 {
   unsigned tp1 = 0,
            tp2 = 0,
@@ -210,13 +219,20 @@ TriangleContest::SolveTriangle(bool exhaustive) noexcept
 
     // TODO: reverse sort relaxed pairs according to number of contained points
 
+    /* with a thread pool, the pairs are solved in batches; the results
+       are evaluated below in the same order as the serial solver does */
+    const auto &pairs = relaxed_pairs.closing_pairs;
+    std::vector<Triangle> results;
+
     ClosingPairs close_look;
 
-    for (const auto relaxed_pair : relaxed_pairs.closing_pairs) {
+    for (unsigned i = 0; i < pairs.size(); ++i) {
+      const auto &relaxed_pair = pairs[i];
 
-      const auto triangle = RunBranchAndBound(relaxed_pair.first,
-                                              relaxed_pair.second,
-                                              best_d, exhaustive);
+      const auto triangle = thread_pool != nullptr
+        ? RunBranchAndBound(pairs, i, results, best_d)
+        : RunBranchAndBound(relaxed_pair.first, relaxed_pair.second,
+                            best_d, exhaustive, nullptr);
 
       if (std::get<3>(triangle) > best_d) {
         // solution is better than best_d
@@ -235,7 +251,7 @@ TriangleContest::SolveTriangle(bool exhaustive) noexcept
         } else {
           // otherwise we should solve the triangle again for every unrelaxed pair
           // contained inside the current relaxed pair. *damn!*
-          for (const auto closing_pair : closing_pairs.closing_pairs) {
+          for (const auto &closing_pair : closing_pairs.closing_pairs) {
             if (closing_pair.first >= relaxed_pair.first &&
                 closing_pair.second <= relaxed_pair.second)
               close_look.Insert(closing_pair);
@@ -244,10 +260,13 @@ TriangleContest::SolveTriangle(bool exhaustive) noexcept
       }
     }
 
-    for (const auto &close_look_pair : close_look.closing_pairs) {
-      const auto triangle = RunBranchAndBound(close_look_pair.first,
-                                              close_look_pair.second,
-                                              best_d, exhaustive);
+    for (unsigned i = 0; i < close_look.closing_pairs.size(); ++i) {
+      const auto &close_look_pair = close_look.closing_pairs[i];
+
+      const auto triangle = thread_pool != nullptr
+        ? RunBranchAndBound(close_look.closing_pairs, i, results, best_d)
+        : RunBranchAndBound(close_look_pair.first, close_look_pair.second,
+                            best_d, exhaustive, nullptr);
 
       if (std::get<3>(triangle) > best_d) {
         // solution is better than best_d
@@ -268,7 +287,8 @@ TriangleContest::SolveTriangle(bool exhaustive) noexcept
      * one closing pair only (0 -> n_points-1) which allows us to suspend the
      * solver...
      */
-    const auto triangle = RunBranchAndBound(0, n_points - 1, best_d, false);
+    const auto triangle = RunBranchAndBound(0, n_points - 1, best_d, false,
+                                            deadline);
 
     if (std::get<3>(triangle) > best_d) {
       // solution is better than best_d
@@ -297,9 +317,40 @@ TriangleContest::SolveTriangle(bool exhaustive) noexcept
 }
 
 
-std::tuple<unsigned, unsigned, unsigned, unsigned>
-TriangleContest::RunBranchAndBound(unsigned from, unsigned to, unsigned worst_d,
-                                   bool exhaustive) noexcept
+TriangleContest::Triangle
+TriangleContest::RunBranchAndBound(const std::vector<ClosingPair> &pairs,
+                                   unsigned i, std::vector<Triangle> &results,
+                                   unsigned worst_d) const noexcept
+{
+  assert(thread_pool != nullptr);
+  assert(i < pairs.size());
+
+  const unsigned batch_size = thread_pool->GetConcurrency();
+  const unsigned offset = i % batch_size;
+
+  if (offset == 0) {
+    /* start a new batch: solve this pair and the following ones in
+       parallel, each with its own tree, all with the bound known
+       before the batch */
+    const unsigned n = std::min(batch_size, unsigned(pairs.size()) - i);
+    results.resize(n);
+
+    thread_pool->Run(n, [&](unsigned j){
+        CandidateTree tree;
+        bool _running = false;
+        results[j] = RunBranchAndBound(tree, _running,
+                                       pairs[i + j].first, pairs[i + j].second,
+                                       worst_d, nullptr);
+      });
+  }
+
+  return results[offset];
+}
+
+TriangleContest::Triangle
+TriangleContest::RunBranchAndBound(CandidateTree &tree, bool &_running,
+                                   unsigned from, unsigned to, unsigned worst_d,
+                                   const TimeoutClock *deadline) const noexcept
 {
   /* Some general information about the branch and bound method can be found here:
    * http://eaton.math.rpi.edu/faculty/Mitchell/papers/leeejem.html
@@ -330,23 +381,18 @@ TriangleContest::RunBranchAndBound(unsigned from, unsigned to, unsigned worst_d,
     OLCTriangleRules::MakeValidator(trace_master.GetProjection(),
                                     GetPoint(from).GetLocation());
 
-  if (!running) {
+  if (!_running) {
     // initiate algorithm. otherwise continue unfinished run
-    running = true;
+    _running = true;
 
     // initialize bound-and-branch tree with root node (note: Candidate set interval is [min, max))
     CandidateSet root_candidates(*this, from, to + 1);
     if (root_candidates.IsFeasible(validator) &&
         root_candidates.df_max >= worst_d)
-      branch_and_bound.emplace(root_candidates.df_max, root_candidates);
+      tree.Insert(root_candidates.df_max, root_candidates);
   }
 
-  // set max_iterations only if non-exhaustive and predictive solving is enabled.
-  // otherwise use predefined value.
-  if (!exhaustive && predict)
-    max_iterations = tick_iterations;
-
-  while (!branch_and_bound.empty()) {
+  while (!tree.empty()) {
     /* now loop over the tree, branching each found candidate set, adding the branch if it's feasible.
      * remove all candidate sets with d_max smaller than d_min of the largest integral candidate set
      * always work on the node with largest d_min
@@ -355,14 +401,20 @@ TriangleContest::RunBranchAndBound(unsigned from, unsigned to, unsigned worst_d,
     iterations++;
 
     // break loop if max_iterations or max_tree_size exceeded
-    if (iterations > max_iterations || branch_and_bound.size() > max_tree_size)
+    if (iterations > max_iterations || tree.size() > max_tree_size)
+      break;
+
+    // suspend if the deadline has expired; checking the clock is
+    // cheap, but not free, so do it only every few iterations
+    if (deadline != nullptr && iterations % DEADLINE_CHECK_INTERVAL == 0 &&
+        deadline->HasExpired())
       break;
 
     // first clean up tree, removeing all nodes with d_max < worst_d
-    branch_and_bound.erase(branch_and_bound.begin(), branch_and_bound.lower_bound(worst_d));
+    tree.EraseBelow(worst_d);
 
     // we might have cleaned up the whole tree. nothing to do then...
-    if (branch_and_bound.empty())
+    if (tree.empty())
       break;
 
     /* get node to work on.
@@ -370,88 +422,89 @@ TriangleContest::RunBranchAndBound(unsigned from, unsigned to, unsigned worst_d,
      * this is a mixed depht-first/breadth-first approach, the latter
      * beeing faster, but the first a lot more memory efficient.
      */
-    std::multimap<unsigned, CandidateSet>::iterator node;
+    CandidateTree::Position position;
 
-    if (branch_and_bound.size() > n_points * 4 && iterations % 16 != 0) {
-      node = branch_and_bound.upper_bound(branch_and_bound.rbegin()->first / 2);
-      if (node == branch_and_bound.end()) --node;
-    } else {
-      node = --branch_and_bound.end();
-    }
+    if (tree.size() > n_points * 4 && iterations % 16 != 0)
+      position = tree.UpperBound(tree.GetKey(tree.Last()) / 2);
+    else
+      position = tree.Last();
 
-    if (node->second.df_min >= worst_d &&
-        node->second.IsIntegral(*this, validator)) {
+    /* remove the node from the tree before adding its children, which
+       may reuse its storage */
+    const unsigned node_d = tree.GetKey(position);
+    const CandidateSet node = tree.Get(position);
+    tree.Erase(position);
+
+    if (node.df_min >= worst_d &&
+        node.IsIntegral(*this, validator)) {
       // node is integral feasible -> a possible solution
 
-      worst_d = node->second.df_min;
+      worst_d = node.df_min;
 
-      tp1 = node->second.tp1.index_min;
-      tp2 = node->second.tp2.index_min;
-      tp3 = node->second.tp3.index_min;
-      best_d = node->first;
+      tp1 = node.tp1.index_min;
+      tp2 = node.tp2.index_min;
+      tp3 = node.tp3.index_min;
+      best_d = node_d;
 
       integral_feasible = true;
 
     } else {
       // split largest bounding box of node and create child nodes
 
-      const unsigned tp1_diag = node->second.tp1.GetDiagnoal();
-      const unsigned tp2_diag = node->second.tp2.GetDiagnoal();
-      const unsigned tp3_diag = node->second.tp3.GetDiagnoal();
+      const unsigned tp1_diag = node.tp1.GetDiagnoal();
+      const unsigned tp2_diag = node.tp2.GetDiagnoal();
+      const unsigned tp3_diag = node.tp3.GetDiagnoal();
 
       const unsigned max_diag = std::max({tp1_diag, tp2_diag, tp3_diag});
 
-      if (tp1_diag == max_diag && node->second.tp1.GetSize() != 1) {
+      if (tp1_diag == max_diag && node.tp1.GetSize() != 1) {
         // split tp1 range
-        const unsigned split = (node->second.tp1.index_min + node->second.tp1.index_max) / 2;
+        const unsigned split = (node.tp1.index_min + node.tp1.index_max) / 2;
 
-        if (split <= node->second.tp2.index_max) {
-          CheckAddCandidate(worst_d, validator,
-                            {TurnPointRange(*this, node->second.tp1.index_min, split),
-                             node->second.tp2, node->second.tp3});
+        if (split <= node.tp2.index_max) {
+          CheckAddCandidate(tree, worst_d, validator,
+                            {TurnPointRange(*this, node.tp1.index_min, split),
+                             node.tp2, node.tp3});
 
-          CheckAddCandidate(worst_d, validator,
-                            {TurnPointRange(*this, split, node->second.tp1.index_max),
-                             node->second.tp2, node->second.tp3});
+          CheckAddCandidate(tree, worst_d, validator,
+                            {TurnPointRange(*this, split, node.tp1.index_max),
+                             node.tp2, node.tp3});
         }
-      } else if (tp2_diag == max_diag && node->second.tp2.GetSize() != 1) {
+      } else if (tp2_diag == max_diag && node.tp2.GetSize() != 1) {
         // split tp2 range
-        const unsigned split = (node->second.tp2.index_min + node->second.tp2.index_max) / 2;
-
-        if (split <= node->second.tp3.index_max && split >= node->second.tp1.index_min) {
-          CheckAddCandidate(worst_d, validator,
-                            {node->second.tp1,
-                             TurnPointRange(*this, node->second.tp2.index_min, split),
-                             node->second.tp3});
-
-          CheckAddCandidate(worst_d, validator,
-                            {node->second.tp1,
-                             TurnPointRange(*this, split, node->second.tp2.index_max),
-                             node->second.tp3});
+        const unsigned split = (node.tp2.index_min + node.tp2.index_max) / 2;
+
+        if (split <= node.tp3.index_max && split >= node.tp1.index_min) {
+          CheckAddCandidate(tree, worst_d, validator,
+                            {node.tp1,
+                             TurnPointRange(*this, node.tp2.index_min, split),
+                             node.tp3});
+
+          CheckAddCandidate(tree, worst_d, validator,
+                            {node.tp1,
+                             TurnPointRange(*this, split, node.tp2.index_max),
+                             node.tp3});
         }
-      } else if (node->second.tp3.GetSize() != 1) {
+      } else if (node.tp3.GetSize() != 1) {
         // split tp3 range
-        const unsigned split = (node->second.tp3.index_min + node->second.tp3.index_max) / 2;
+        const unsigned split = (node.tp3.index_min + node.tp3.index_max) / 2;
 
-        if (split >= node->second.tp2.index_min) {
-          CheckAddCandidate(worst_d, validator,
-                            {node->second.tp1, node->second.tp2,
-                             TurnPointRange(*this, node->second.tp3.index_min, split)});
+        if (split >= node.tp2.index_min) {
+          CheckAddCandidate(tree, worst_d, validator,
+                            {node.tp1, node.tp2,
+                             TurnPointRange(*this, node.tp3.index_min, split)});
 
-          CheckAddCandidate(worst_d, validator,
-                            {node->second.tp1, node->second.tp2,
-                             TurnPointRange(*this, split, node->second.tp3.index_max)});
+          CheckAddCandidate(tree, worst_d, validator,
+                            {node.tp1, node.tp2,
+                             TurnPointRange(*this, split, node.tp3.index_max)});
         }
       }
     }
-
-    // remove current node
-    branch_and_bound.erase(node);
   }
 
 
-  if (branch_and_bound.empty())
-    running = false;
+  if (tree.empty())
+    _running = false;
 
   if (integral_feasible) {
     if (tp1 > tp2) std::swap(tp1, tp2);
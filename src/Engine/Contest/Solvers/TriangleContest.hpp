@@ -27,9 +27,15 @@
 #include "OLCTriangleRules.hpp"
 #include "TraceManager.hpp"
 #include "Trace/Point.hpp"
+#include "CandidateQueue.hpp"
 #include "Geo/Flat/FlatBoundingBox.hpp"
 
-#include <map>
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+class ThreadPool;
+class TimeoutClock;
 
 /**
  * Specialisation of AbstractContest for OLC Triangle (triangle) rules
@@ -92,16 +98,27 @@ private:
 
   typedef std::pair<unsigned, unsigned> ClosingPair;
 
+  /**
+   * A list of closing pairs, sorted by the first index.  No pair
+   * contains another one.
+   */
   struct ClosingPairs {
-    std::map<unsigned, unsigned> closing_pairs;
+    std::vector<ClosingPair> closing_pairs;
 
     bool Insert(const ClosingPair &p) noexcept {
       auto found = FindRange(p);
       if (found.first == 0 && found.second == 0) {
-        const auto result = closing_pairs.insert(p);
-        if (!result.second)
-          result.first->second = p.second;
-        RemoveRange(std::next(result.first), p.second);
+        auto i = std::lower_bound(closing_pairs.begin(), closing_pairs.end(),
+                                  p.first,
+                                  [](const ClosingPair &a, unsigned first){
+                                    return a.first < first;
+                                  });
+        if (i != closing_pairs.end() && i->first == p.first)
+          i->second = p.second;
+        else
+          i = closing_pairs.insert(i, p);
+
+        RemoveRange(std::next(i), p.second);
         return true;
       } else {
         return false;
@@ -121,15 +138,13 @@ private:
       return ClosingPair(0, 0);
     }
 
-    void RemoveRange(std::map<unsigned, unsigned>::iterator it,
+    void RemoveRange(std::vector<ClosingPair>::iterator it,
                      unsigned last) noexcept {
-      const auto end = closing_pairs.end();
-      while (it != end) {
-        if (it->second < last)
-          it = closing_pairs.erase(it);
-        else
-          it++;
-      }
+      closing_pairs.erase(std::remove_if(it, closing_pairs.end(),
+                                         [last](const ClosingPair &i){
+                                           return i.second < last;
+                                         }),
+                          closing_pairs.end());
     }
 
     void Clear() noexcept {
@@ -244,7 +259,7 @@ private:
      * distances for certain checks, otherwise real distances for marginal fai triangles.
      */
     gcc_pure
-    bool IsIntegral(TriangleContest &parent,
+    bool IsIntegral(const TriangleContest &parent,
                     const OLCTriangleValidator &validator) const noexcept {
       if (!(tp1.GetSize() == 1 && tp2.GetSize() == 1 && tp3.GetSize() == 1))
         return false;
@@ -260,7 +275,15 @@ private:
     }
   };
 
-  std::multimap<unsigned, CandidateSet> branch_and_bound;
+  typedef CandidateQueue<CandidateSet> CandidateTree;
+
+  CandidateTree branch_and_bound;
+
+  /**
+   * An optional #ThreadPool which is used to run the branch and bound
+   * algorithm for several closing pairs in parallel.
+   */
+  ThreadPool *thread_pool = nullptr;
 
 public:
   TriangleContest(const Trace &_trace,
@@ -271,24 +294,85 @@ public:
     incremental = _incremental;
   }
 
+  /**
+   * Use the given #ThreadPool for exhaustive (or non-predictive)
+   * solving.  The result is the same as with the serial solver,
+   * unless the iteration or tree size limits are hit; see
+   * RunBranchAndBound().
+   *
+   * @param pool the #ThreadPool or nullptr to solve serially; it must
+   * remain valid until this method is called again
+   */
+  void SetThreadPool(ThreadPool *pool) noexcept {
+    thread_pool = pool;
+  }
+
 protected:
   bool FindClosingPairs(unsigned old_size) noexcept;
-  void SolveTriangle(bool exhaustive) noexcept;
+  void SolveTriangle(bool exhaustive, const TimeoutClock *deadline) noexcept;
+
+  typedef std::tuple<unsigned, unsigned, unsigned, unsigned> Triangle;
 
-  std::tuple<unsigned, unsigned, unsigned, unsigned>
-  RunBranchAndBound(unsigned from, unsigned to, unsigned best_d,
-                    bool exhaustive) noexcept;
+  Triangle RunBranchAndBound(unsigned from, unsigned to, unsigned best_d,
+                             bool exhaustive,
+                             const TimeoutClock *deadline) noexcept {
+    if (exhaustive)
+      deadline = nullptr;
+
+    // set max_iterations only if non-exhaustive and predictive solving is enabled
+    // and there is no deadline. otherwise use predefined value.
+    if (!exhaustive && predict && deadline == nullptr)
+      max_iterations = tick_iterations;
+
+    return RunBranchAndBound(branch_and_bound, running,
+                             from, to, best_d, deadline);
+  }
+
+  /**
+   * Run the branch and bound algorithm on the given tree.  This
+   * method does not modify the object and may therefore be called
+   * from several threads at a time, each with its own tree.
+   *
+   * @param deadline if not nullptr, then the algorithm is suspended
+   * when this deadline expires; it can be resumed by calling this
+   * method again with the same tree
+   */
+  Triangle RunBranchAndBound(CandidateTree &tree, bool &_running,
+                             unsigned from, unsigned to, unsigned worst_d,
+                             const TimeoutClock *deadline) const noexcept;
+
+  /**
+   * Return the result of the closing pair with the given index, in
+   * the order of the serial solver.  The pairs are solved in batches
+   * of GetConcurrency() pairs, in parallel on #thread_pool: when
+   * the index starts a new batch, all pairs of that batch are
+   * solved with a fresh tree each, and #worst_d (the best distance
+   * known before the batch) as the bound.
+   *
+   * The result of each pair depends only on its batch, not on the
+   * scheduling of the threads, so the solution is reproducible.  It
+   * is the same as the serial solver's unless #max_iterations or
+   * #max_tree_size is hit: then the serial solver resumes the
+   * aborted tree in the next pair, and pairs of one batch prune with
+   * a lower bound than the serial solver would, so a different
+   * triangle may be found.
+   *
+   * @param results storage for the results of the current batch
+   */
+  Triangle RunBranchAndBound(const std::vector<ClosingPair> &pairs,
+                             unsigned i, std::vector<Triangle> &results,
+                             unsigned worst_d) const noexcept;
 
   void UpdateTrace(bool force) noexcept override;
   void ResetBranchAndBound() noexcept;
 
 private:
-  void CheckAddCandidate(unsigned worst_d,
-                         const OLCTriangleValidator &validator,
-                         CandidateSet candidate_set) noexcept {
+  static void CheckAddCandidate(CandidateTree &tree, unsigned worst_d,
+                                const OLCTriangleValidator &validator,
+                                CandidateSet candidate_set) noexcept {
     if (candidate_set.df_max >= worst_d &&
         candidate_set.IsFeasible(validator))
-      branch_and_bound.emplace(candidate_set.df_max, candidate_set);
+      tree.Insert(candidate_set.df_max, candidate_set);
   }
 
 public:
@@ -302,7 +386,8 @@ public:
 
   /* virtual methods from AbstractContest */
   void Reset() noexcept override;
-  SolverResult Solve(bool exhaustive) noexcept override;
+  SolverResult Solve(bool exhaustive,
+                     const TimeoutClock *deadline) noexcept override;
 
 protected:
   /* virtual methods from AbstractContest */
@@ -59,9 +59,9 @@ XContestTriangle::CalculateResult() const noexcept
 }
 
 SolverResult
-XContestTriangle::Solve(bool exhaustive) noexcept
+XContestTriangle::Solve(bool exhaustive, const TimeoutClock *deadline) noexcept
 {
-  SolverResult result = TriangleContest::Solve(exhaustive);
+  SolverResult result = TriangleContest::Solve(exhaustive, deadline);
   if (result != SolverResult::FAILED)
     best_d = 0; // reset heuristic
 
@@ -38,7 +38,8 @@ public:
 
 protected:
   /* virtual methods from AbstractContest */
-  SolverResult Solve(bool exhaustive) noexcept override;
+  SolverResult Solve(bool exhaustive,
+                     const TimeoutClock *deadline) noexcept override;
 
   /* virtual methods from TriangleContest */
   ContestResult CalculateResult() const noexcept override;
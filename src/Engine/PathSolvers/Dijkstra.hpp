@@ -202,6 +202,15 @@ public:
     q.reserve(size);
   }
 
+  /**
+   * Clear the queue, but keep the edge map.  This hack is needed
+   * for patching the edge map, see
+   * ContestDijkstra::PatchEdges().
+   */
+  void ClearQueue() noexcept {
+    q.clear();
+  }
+
   /**
    * Clear the queue and re-insert all known links.
    */
@@ -25,10 +25,9 @@ Copyright_License {
 #define ASTAR_HPP
 
 #include "Util/ReservablePriorityQueue.hpp"
+#include "Util/FlatHashMap.hpp"
 #include "Util/Compiler.h"
 
-#include <unordered_map>
-
 struct AStarPriorityValue
 {
   static constexpr unsigned MINMAX_OFFSET = 134217727;
@@ -75,12 +74,12 @@ template <class Node, class Hash=std::hash<Node>,
           bool m_min=true>
 class AStar
 {
-  typedef std::unordered_map<Node, AStarPriorityValue, Hash, KeyEqual> node_value_map;
+  typedef FlatHashMap<Node, AStarPriorityValue, Hash, KeyEqual> node_value_map;
 
   typedef typename node_value_map::iterator node_value_iterator;
   typedef typename node_value_map::const_iterator node_value_const_iterator;
 
-  typedef std::unordered_map<Node, Node, Hash, KeyEqual> node_parent_map;
+  typedef FlatHashMap<Node, Node, Hash, KeyEqual> node_parent_map;
 
   typedef typename node_parent_map::iterator node_parent_iterator;
   typedef typename node_parent_map::const_iterator node_parent_const_iterator;
@@ -27,6 +27,9 @@
 #include "Util/GlobalSliceAllocator.hxx"
 #include "Geo/Flat/FlatProjection.hpp"
 
+#include <algorithm>
+#include <cassert>
+
 #define REACH_BUFFER 1
 #define REACH_SWEEP (ROUTEPOLAR_Q1-REACH_BUFFER)
 
@@ -34,6 +37,12 @@
 #define REACH_MIN_STEP 25
 #define REACH_MAX_VERTICES 2000
 
+/**
+ * The maximum number of corner points tried by
+ * FlatTriangleFanTree::CheckGap().
+ */
+static constexpr unsigned MAX_GAP_CANDIDATES = 16;
+
 static bool
 AlmostTheSame(const FlatGeoPoint p1, const FlatGeoPoint p2)
 {
@@ -122,25 +131,25 @@ FlatTriangleFanTree::FillReach(const AFlatGeoPoint &origin, const int index_low,
   height = origin.altitude;
 
   // fill vector
-  if (!IsRoot()) {
-    const int index_mid = (index_high + index_low) / 2;
-    const FlatGeoPoint x_mid = parms.ReachIntercept(index_mid, origin,
-                                                    geo_origin);
-    if (TooClose(x_mid, origin))
-      return false;
-  }
-
   AddOrigin(origin, index_high - index_low);
-  for (int index = index_low; index < index_high; ++index) {
-    FlatGeoPoint x = parms.ReachIntercept(index, origin, geo_origin);
-    /* if ReachIntercept() did not find anything reasonable it returns
-       a FlatGeoPoint that is almost the same as origin, but differs
-       +/- 1 due to conversion errors. The resulting polygon can have
-       overlapping edges causing triangulation failures. */
-    if (AlmostTheSame(origin, x))
-      x = origin;
-
-    AddPoint(x);
+
+  FlatGeoPoint intercepts[ROUTEPOLAR_POINTS];
+  for (int index = index_low; index < index_high;) {
+    const int chunk = std::min(index_high - index, int(ROUTEPOLAR_POINTS));
+    parms.ReachIntercepts(index, index + chunk, origin, geo_origin,
+                          intercepts);
+
+    for (int i = 0; i < chunk; ++i, ++index) {
+      FlatGeoPoint x = intercepts[i];
+      /* if ReachIntercepts() did not find anything reasonable it returns
+         a FlatGeoPoint that is almost the same as origin, but differs
+         +/- 1 due to conversion errors. The resulting polygon can have
+         overlapping edges causing triangulation failures. */
+      if (AlmostTheSame(origin, x))
+        x = origin;
+
+      AddPoint(x);
+    }
   }
 
   return CommitPoints(IsRoot());
@@ -227,14 +236,30 @@ FlatTriangleFanTree::CheckGap(const AFlatGeoPoint &n, const RouteLink &e_1,
     index_right = e_long.polar_index + REACH_SWEEP;
   }
 
+  AFlatGeoPoint candidates[MAX_GAP_CANDIDATES];
+  unsigned n_candidates = 0;
   for (auto f = f0; f < 0.9; f += 0.1) {
+    assert(n_candidates < MAX_GAP_CANDIDATES);
+
     // find corner point
     const FlatGeoPoint px = (dp * f + FlatGeoPoint(n));
     // position x is length (n to p_short) along (n to p_long)
     const int h = n.altitude + f * h_loss;
 
     // altitude calculated from pure glide from n to x
-    const AFlatGeoPoint x(px, h);
+    candidates[n_candidates++] = AFlatGeoPoint(px, h);
+  }
+
+  /* look up the middle radial of all candidates at once; a candidate
+     whose middle radial hits the terrain right away is skipped */
+  const int index_mid = (index_left + index_right) / 2;
+  FlatGeoPoint x_mid[MAX_GAP_CANDIDATES];
+  parms.ReachIntercepts(index_mid, candidates, n_candidates, x_mid);
+
+  for (unsigned i = 0; i < n_candidates; ++i) {
+    const AFlatGeoPoint &x = candidates[i];
+    if (TooClose(x_mid[i], x))
+      continue;
 
     FlatTriangleFanTree child(depth + 1);
     if (child.FillReach(x, index_left, index_right, parms)) {
@@ -93,6 +93,10 @@ public:
   }
 
   /**
+   * The caller of a child fan (i.e. CheckGap()) has already checked
+   * that the middle radial of [index_low, index_high) leaves the
+   * origin.
+   *
    * @return true if a valid fan has been filled, false to discard
    * this object
    */
@@ -45,11 +45,18 @@ struct ReachFanParms {
     :rpolars(_rpolars), projection(_projection), terrain(_terrain),
      terrain_base(_terrain_base) {}
 
-  gcc_pure
-  FlatGeoPoint ReachIntercept(int index, const AFlatGeoPoint &flat_origin,
-                              const GeoPoint &origin) const {
-    return rpolars.ReachIntercept(index, flat_origin, origin,
-                                  terrain, projection);
+  void ReachIntercepts(int index_low, int index_high,
+                       const AFlatGeoPoint &flat_origin,
+                       const GeoPoint &origin,
+                       FlatGeoPoint *results) const {
+    rpolars.ReachIntercepts(index_low, index_high, flat_origin, origin,
+                            terrain, projection, results);
+  }
+
+  void ReachIntercepts(int index, const AFlatGeoPoint *flat_origins,
+                       unsigned n, FlatGeoPoint *results) const {
+    rpolars.ReachIntercepts(index, flat_origins, n,
+                            terrain, projection, results);
   }
 };
 
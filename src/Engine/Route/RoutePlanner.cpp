@@ -27,6 +27,7 @@
 RoutePlanner::RoutePlanner()
   :terrain(NULL), planner(0),
    unique_links(50000),
+   current_link(UINT_MAX),
    reach_polar_mode(RoutePlannerConfig::Polar::TASK)
 {
   Reset();
@@ -165,11 +166,7 @@ RoutePlanner::Solve(const AGeoPoint &origin, const AGeoPoint &destination,
     if (IsSetUnique(e))
       AddEdges(e);
 
-    while (!links.empty()) {
-      AddEdges(links.front());
-      links.pop();
-    }
-
+    ProcessLinks();
   }
 
   count_unique = unique_links.size();
@@ -409,9 +406,43 @@ RoutePlanner::CheckClearanceTerrain(const RouteLink &e, RoutePoint& inp) const
     return true;
 
   count_terrain++;
+
+  if (current_link != UINT_MAX && pending_links[current_link] == e) {
+    const auto &result = pending_clearance[current_link];
+    if (!result.clear)
+      inp = result.inp;
+    return result.clear;
+  }
+
   return rpolars_route.CheckClearance(e, terrain, projection, inp);
 }
 
+void
+RoutePlanner::ProcessLinks()
+{
+  while (!links.empty()) {
+    pending_links.clear();
+    while (!links.empty()) {
+      pending_links.push_back(links.front());
+      links.pop();
+    }
+
+    const unsigned n = pending_links.size();
+    pending_clearance.resize(n);
+    if (terrain != nullptr && terrain->IsDefined())
+      rpolars_route.CheckClearance(pending_links.data(), n,
+                                   terrain, projection,
+                                   pending_clearance.data());
+
+    /* AddEdges() may append new candidates to #links, which are
+       processed in the next batch */
+    for (current_link = 0; current_link < n; ++current_link)
+      AddEdges(pending_links[current_link]);
+
+    current_link = UINT_MAX;
+  }
+}
+
 void
 RoutePlanner::AddNearbyTerrainSweep(const RoutePoint& p,
                                        const RouteLink &c_link, const int sign)
@@ -33,6 +33,7 @@
 
 #include <utility>
 #include <unordered_set>
+#include <vector>
 
 #include <limits.h>
 
@@ -135,6 +136,19 @@ private:
   /** Link candidates to be processed for intersection tests */
   RouteLinkQueue links;
 
+  /**
+   * The batch of #links currently being processed by
+   * ProcessLinks(), and their terrain clearance computed in advance.
+   */
+  std::vector<RouteLink> pending_links;
+  std::vector<RoutePolars::Clearance> pending_clearance;
+
+  /**
+   * The index of the #pending_links element being passed to
+   * AddEdges(), or UINT_MAX.
+   */
+  unsigned current_link;
+
   /** Result route found by solve() method */
   Route solution_route;
 
@@ -372,6 +386,14 @@ protected:
   bool CheckClearanceTerrain(const RouteLink &e, RoutePoint& inp) const;
 
 private:
+  /**
+   * Process all link candidates in #links, including the ones added
+   * during processing.  The terrain clearance of each batch is
+   * computed at once, which allows sorting the terrain lookups by
+   * raster tile.
+   */
+  void ProcessLinks();
+
   /**
    * Check a second category of obstacle clearance.  This allows compound
    * obstacle categories by subclasses.
@@ -26,6 +26,10 @@
 #include "Geo/Flat/FlatProjection.hpp"
 #include "Terrain/RasterMap.hpp"
 
+#include <algorithm>
+#include <vector>
+#include <cassert>
+
 #define MC_CEILING_PENALTY_FACTOR 5.0
 
 inline FlatGeoPoint
@@ -129,6 +133,40 @@ RoutePolars::CheckClearance(const RouteLink &e, const RasterMap* map,
   return false;
 }
 
+void
+RoutePolars::CheckClearance(const RouteLink *e, const unsigned n,
+                            const RasterMap *map,
+                            const FlatProjection &proj,
+                            Clearance *result) const
+{
+  if (!config.IsTerrainEnabled()) {
+    for (unsigned i = 0; i < n; ++i)
+      result[i].clear = true;
+    return;
+  }
+
+  assert(map);
+
+  std::vector<RasterMap::FirstIntersectionLine> lines(n);
+  for (unsigned i = 0; i < n; ++i) {
+    auto &line = lines[i];
+    line.origin = proj.Unproject(e[i].first);
+    line.h_origin = e[i].first.altitude;
+    line.destination = proj.Unproject(e[i].second);
+    line.h_destination = e[i].second.altitude;
+    line.h_virt = CalcVHeight(e[i]);
+  }
+
+  map->FirstIntersection(lines.data(), n, climb_ceiling, GetSafetyHeight());
+
+  for (unsigned i = 0; i < n; ++i) {
+    result[i].clear = !lines[i].intersecting;
+    if (!result[i].clear)
+      result[i].inp = RoutePoint(proj.ProjectInteger(lines[i].intx),
+                                 lines[i].h);
+  }
+}
+
 RouteLink
 RoutePolars::GenerateIntermediate(const RoutePoint& _dest,
                                    const RoutePoint& _origin,
@@ -240,24 +278,86 @@ RoutePolars::CalcGlideArrival(const AFlatGeoPoint& origin,
   return origin.altitude - CalcVHeight(e);
 }
 
-FlatGeoPoint
-RoutePolars::ReachIntercept(const int index, const AFlatGeoPoint &flat_origin,
-                            const GeoPoint &origin,
-                            const RasterMap* map,
-                            const FlatProjection &proj) const
+void
+RoutePolars::ReachIntercepts(int index_low, const int index_high,
+                             const AFlatGeoPoint &flat_origin,
+                             const GeoPoint &origin,
+                             const RasterMap *map,
+                             const FlatProjection &proj,
+                             FlatGeoPoint *results) const
 {
+  assert(index_low <= index_high);
+
   const bool valid = map && map->IsDefined();
   const int altitude = flat_origin.altitude - GetSafetyHeight();
-  const FlatGeoPoint flat_dest = MSLIntercept(index, flat_origin,
-                                              altitude, proj);
 
-  if (!valid)
-    return flat_dest;
+  RasterMap::IntersectionLine lines[ROUTEPOLAR_POINTS];
+
+  while (index_low < index_high) {
+    const unsigned n = std::min(unsigned(index_high - index_low),
+                                unsigned(ROUTEPOLAR_POINTS));
 
-  const GeoPoint dest = proj.Unproject(flat_dest);
-  const GeoPoint p = map->Intersection(origin, altitude,
-                                       altitude, dest, height_min_working);
+    for (unsigned i = 0; i < n; ++i)
+      results[i] = MSLIntercept(index_low + i, flat_origin, altitude, proj);
 
+    if (valid) {
+      for (unsigned i = 0; i < n; ++i) {
+        auto &line = lines[i];
+        line.origin = origin;
+        line.destination = proj.Unproject(results[i]);
+        line.h_origin = line.h_glide = altitude;
+      }
+
+      map->Intersection(lines, n, height_min_working);
+
+      for (unsigned i = 0; i < n; ++i)
+        results[i] = ClipIntercept(flat_origin, results[i],
+                                   lines[i].intx, proj);
+    }
+
+    index_low += n;
+    results += n;
+  }
+}
+
+void
+RoutePolars::ReachIntercepts(const int index,
+                             const AFlatGeoPoint *flat_origins,
+                             const unsigned n,
+                             const RasterMap *map,
+                             const FlatProjection &proj,
+                             FlatGeoPoint *results) const
+{
+  for (unsigned i = 0; i < n; ++i)
+    results[i] = MSLIntercept(index, flat_origins[i],
+                              flat_origins[i].altitude - GetSafetyHeight(),
+                              proj);
+
+  if (map == nullptr || !map->IsDefined())
+    return;
+
+  std::vector<RasterMap::IntersectionLine> lines(n);
+  for (unsigned i = 0; i < n; ++i) {
+    auto &line = lines[i];
+    line.origin = proj.Unproject(flat_origins[i]);
+    line.destination = proj.Unproject(results[i]);
+    line.h_origin = line.h_glide =
+      flat_origins[i].altitude - GetSafetyHeight();
+  }
+
+  map->Intersection(lines.data(), n, height_min_working);
+
+  for (unsigned i = 0; i < n; ++i)
+    results[i] = ClipIntercept(flat_origins[i], results[i],
+                               lines[i].intx, proj);
+}
+
+FlatGeoPoint
+RoutePolars::ClipIntercept(const AFlatGeoPoint &flat_origin,
+                           const FlatGeoPoint &flat_dest,
+                           const GeoPoint &p,
+                           const FlatProjection &proj)
+{
   if (!p.IsValid())
     return flat_dest;
 
@@ -64,6 +64,17 @@ public:
   /** Altitude (m) above which the aircraft cannot climb */
   int climb_ceiling;
 
+  /**
+   * The result of one link for the batched CheckClearance().
+   */
+  struct Clearance {
+    /** Is the link clear of terrain? */
+    bool clear;
+
+    /** Clearance after intersection point, if not #clear */
+    RoutePoint inp;
+  };
+
   /**
    * Re-initialise performance tables when polar or wind changes
    *
@@ -111,6 +122,17 @@ public:
   bool CheckClearance(const RouteLink &e, const RasterMap* map,
                       const FlatProjection &proj, RoutePoint &inp) const;
 
+  /**
+   * Batched version of CheckClearance() for many links; the terrain
+   * lookups are grouped by raster tile.
+   *
+   * @param e Links to evaluate
+   * @param n Number of links
+   * @param result (output) the result of each link
+   */
+  void CheckClearance(const RouteLink *e, unsigned n, const RasterMap *map,
+                      const FlatProjection &proj, Clearance *result) const;
+
   /**
    * Rotate line from start to end either left or right
    *
@@ -243,17 +265,50 @@ public:
     return height_min_working;
   }
 
-  gcc_pure
-  FlatGeoPoint ReachIntercept(int index, const AFlatGeoPoint &flat_origin,
-                              const GeoPoint &origin,
-                              const RasterMap* map,
-                              const FlatProjection &proj) const;
+  /**
+   * Calculate the reach intercepts of all indices in the range
+   * [index_low, index_high) from one origin, with one batched
+   * terrain intersection call.
+   *
+   * @param results an array of (index_high - index_low) elements
+   */
+  void ReachIntercepts(int index_low, int index_high,
+                       const AFlatGeoPoint &flat_origin,
+                       const GeoPoint &origin,
+                       const RasterMap *map,
+                       const FlatProjection &proj,
+                       FlatGeoPoint *results) const;
+
+  /**
+   * Calculate the reach intercept of one index from many origins,
+   * with one batched terrain intersection call.
+   *
+   * @param results an array of n elements
+   */
+  void ReachIntercepts(int index, const AFlatGeoPoint *flat_origins,
+                       unsigned n,
+                       const RasterMap *map,
+                       const FlatProjection &proj,
+                       FlatGeoPoint *results) const;
 
 private:
   gcc_pure
   FlatGeoPoint MSLIntercept(const int index, const FlatGeoPoint &p,
                             double altitude,
                             const FlatProjection &proj) const;
+
+  /**
+   * Convert the terrain intersection #p of a reach radial to a
+   * #FlatGeoPoint.
+   *
+   * @param flat_dest the MSL intercept of the radial, returned if
+   * there is no terrain intersection
+   */
+  gcc_pure
+  static FlatGeoPoint ClipIntercept(const AFlatGeoPoint &flat_origin,
+                                    const FlatGeoPoint &flat_dest,
+                                    const GeoPoint &p,
+                                    const FlatProjection &proj);
 };
 
 #endif
@@ -43,15 +43,32 @@ TaskDijkstra::GetPoint(const ScanTaskPoint sp) const noexcept
   return (*boundaries[sp.GetStageNumber()])[sp.GetPointIndex()];
 }
 
+void
+TaskDijkstra::PrepareBoundaries() noexcept
+{
+  prepared.clear();
+
+  for (unsigned stage = 0; stage < num_stages; ++stage) {
+    prepared_offsets[stage] = prepared.size();
+
+    for (const SearchPoint &i : *boundaries[stage])
+      prepared.emplace_back(i.GetLocation());
+  }
+}
+
 void
 TaskDijkstra::AddEdges(const ScanTaskPoint curNode) noexcept
 {
   ScanTaskPoint destination(curNode.GetStageNumber() + 1, 0);
   const unsigned dsize = GetStageSize(destination.GetStageNumber());
 
+  const PreparedGeoPoint &origin = GetPreparedPoint(curNode);
+  const PreparedGeoPoint *p =
+    prepared.data() + prepared_offsets[destination.GetStageNumber()];
+
   for (const ScanTaskPoint end(destination.GetStageNumber(), dsize);
-       destination != end; destination.IncrementPointIndex())
-    Link(destination, curNode, CalcDistance(curNode, destination));
+       destination != end; destination.IncrementPointIndex(), ++p)
+    Link(destination, curNode, (unsigned)Distance(origin, *p));
 }
 
 void
@@ -72,12 +89,14 @@ TaskDijkstra::AddStartEdges(unsigned stage,
 {
   assert(currentLocation.IsValid());
 
+  const PreparedGeoPoint location(currentLocation.GetLocation());
+
   ScanTaskPoint destination(stage, 0);
   const unsigned dsize = GetStageSize(stage);
 
   for (const ScanTaskPoint end(stage, dsize);
        destination != end; destination.IncrementPointIndex())
-    LinkStart(destination, CalcDistance(destination, currentLocation));
+    LinkStart(destination, CalcDistance(destination, location));
 }
 
 bool
@@ -25,6 +25,9 @@
 
 #include "PathSolvers/NavDijkstra.hpp"
 #include "Geo/SearchPoint.hpp"
+#include "Geo/Math.hpp"
+
+#include <vector>
 
 #include <cassert>
 
@@ -55,6 +58,14 @@ class TaskDijkstra : protected NavDijkstra
 {
   const SearchPointVector *boundaries[MAX_STAGES];
 
+  /**
+   * The boundaries of all stages in one array, prepared for fast
+   * distance calculations.  The points of stage #i begin at
+   * #prepared_offsets[i].  Filled by PrepareBoundaries().
+   */
+  std::vector<PreparedGeoPoint> prepared;
+  unsigned prepared_offsets[MAX_STAGES];
+
   const bool is_min;
 
 public:
@@ -89,6 +100,12 @@ protected:
   gcc_pure
   const SearchPoint &GetPoint(ScanTaskPoint sp) const noexcept;
 
+  /**
+   * Copy the boundaries into #prepared.  Call this after all
+   * SetBoundary() calls, before adding the start edges.
+   */
+  void PrepareBoundaries() noexcept;
+
   bool Run() noexcept;
 
   bool Link(const ScanTaskPoint node, const ScanTaskPoint parent,
@@ -110,44 +127,33 @@ protected:
    */
   void AddStartEdges(unsigned stage, const SearchPoint &loc) noexcept;
 
-  /** 
-   * Distance function for free point
-   * 
+  /**
+   * Distance function between a node and a location
+   *
    * @param curNode Destination node
    * @param currentLocation Origin location
-   * 
-   * @return Distance (flat) from origin to destination
+   *
+   * @return Distance from origin to destination
    */
   gcc_pure
   unsigned CalcDistance(const ScanTaskPoint curNode,
-                        const SearchPoint &currentLocation) const noexcept {
+                        const PreparedGeoPoint &currentLocation) const noexcept {
     /* using expensive floating point formulas here to avoid integer
-       rounding errors */
-
-    const GeoPoint &a = GetPoint(curNode).GetLocation();
-    const GeoPoint &b = currentLocation.GetLocation();
-
-    return (unsigned)a.Distance(b);
-  }
+       rounding errors; PrepareBoundaries() has already done the
+       per-point part of the work */
 
-  /** 
-   * Distance function for edges
-   * 
-   * @param s1 Origin node
-   * @param s2 Destination node
-   * 
-   * @return Distance (flat) from origin to destination
-   */
-  gcc_pure
-  unsigned CalcDistance(const ScanTaskPoint s1,
-                        const ScanTaskPoint s2) const noexcept {
-    return CalcDistance(s1, GetPoint(s2));
+    return (unsigned)Distance(GetPreparedPoint(curNode), currentLocation);
   }
 
 private:
   gcc_pure
   unsigned GetStageSize(const unsigned stage) const noexcept;
 
+  const PreparedGeoPoint &GetPreparedPoint(ScanTaskPoint sp) const noexcept {
+    return prepared[prepared_offsets[sp.GetStageNumber()] +
+                    sp.GetPointIndex()];
+  }
+
 protected:
   /* methods from NavDijkstra */
   virtual void AddEdges(ScanTaskPoint curNode) noexcept final;
@@ -27,6 +27,7 @@ TaskDijkstraMax::DistanceMax() noexcept
 {
   dijkstra.Clear();
   dijkstra.Reserve(256);
+  PrepareBoundaries();
   AddZeroStartEdges();
   return Run();
 }
@@ -27,6 +27,7 @@ TaskDijkstraMin::DistanceMin(const SearchPoint &currentLocation) noexcept
 {
   dijkstra.Clear();
   dijkstra.Reserve(256);
+  PrepareBoundaries();
 
   if (currentLocation.IsValid()) {
     AddStartEdges(0, currentLocation);
@@ -0,0 +1,86 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Snapshot.hpp"
+#include "Trace.hpp"
+
+void
+TraceSnapshot::clear() noexcept
+{
+  append_serial = modify_serial = Serial();
+  times.clear();
+  xs.clear();
+  ys.clear();
+  altitudes.clear();
+  varios.clear();
+}
+
+inline void
+TraceSnapshot::Append(const TracePoint &point) noexcept
+{
+  const FlatGeoPoint &flat = point.GetFlatLocation();
+
+  times.push_back(point.GetTime());
+  xs.push_back(flat.x);
+  ys.push_back(flat.y);
+  altitudes.push_back(point.GetIntegerAltitude());
+  varios.push_back(point.GetVario());
+}
+
+bool
+TraceSnapshot::Update(const Trace &trace) noexcept
+{
+  if (modify_serial == trace.GetModifySerial() &&
+      append_serial == trace.GetAppendSerial())
+    /* no news */
+    return false;
+
+  auto i = trace.begin();
+  if (modify_serial == trace.GetModifySerial() && size() <= trace.size()) {
+    /* points were only appended: copy the new ones */
+    i = std::prev(trace.end(), trace.size() - size());
+  } else {
+    /* the trace was thinned: start from scratch */
+    times.clear();
+    xs.clear();
+    ys.clear();
+    altitudes.clear();
+    varios.clear();
+  }
+
+  const unsigned n = trace.size();
+  times.reserve(n);
+  xs.reserve(n);
+  ys.reserve(n);
+  altitudes.reserve(n);
+  varios.reserve(n);
+
+  for (const auto end = trace.end(); i != end; ++i)
+    Append(*i);
+
+  assert(size() == trace.size());
+
+  append_serial = trace.GetAppendSerial();
+  modify_serial = trace.GetModifySerial();
+  return true;
+}
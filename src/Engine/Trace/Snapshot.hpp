@@ -0,0 +1,164 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#ifndef XCSOAR_TRACE_SNAPSHOT_HPP
+#define XCSOAR_TRACE_SNAPSHOT_HPP
+
+#include "Util/Serial.hpp"
+#include "Math/FastMath.hpp"
+#include "Geo/Flat/FlatGeoPoint.hpp"
+#include "Util/Compiler.h"
+
+#include <vector>
+
+#include <cassert>
+
+class Trace;
+class TracePoint;
+
+/**
+ * A copy of a #Trace in "structure of arrays" layout: time, projected
+ * location, altitude and vario of all points are stored in separate
+ * contiguous arrays, ordered by time.  Unlike #TracePointerVector,
+ * it does not refer to the nodes of the #Trace, and loops over one
+ * attribute of many points touch only the memory they need, which
+ * allows the compiler to vectorise them.
+ *
+ * Update() keeps it in sync with the #Trace; appended points are
+ * copied incrementally, and a full copy is only made after the
+ * #Trace has been thinned or cleared (see Trace::GetModifySerial()).
+ */
+class TraceSnapshot {
+  /**
+   * The Trace::GetAppendSerial() value of the last Update().
+   */
+  Serial append_serial;
+
+  /**
+   * The Trace::GetModifySerial() value of the last Update().
+   */
+  Serial modify_serial;
+
+  std::vector<unsigned> times;
+  std::vector<int> xs, ys;
+  std::vector<int> altitudes;
+  std::vector<float> varios;
+
+public:
+  bool empty() const noexcept {
+    return times.empty();
+  }
+
+  unsigned size() const noexcept {
+    return times.size();
+  }
+
+  void clear() noexcept;
+
+  /**
+   * Synchronise this object with the given #Trace.  This object
+   * must always be updated from the same #Trace (or be cleared in
+   * between).
+   *
+   * @return true if the contents have changed
+   */
+  bool Update(const Trace &trace) noexcept;
+
+  gcc_pure
+  unsigned GetTime(unsigned i) const noexcept {
+    assert(i < size());
+
+    return times[i];
+  }
+
+  gcc_pure
+  FlatGeoPoint GetFlatLocation(unsigned i) const noexcept {
+    assert(i < size());
+
+    return FlatGeoPoint(xs[i], ys[i]);
+  }
+
+  gcc_pure
+  int GetIntegerAltitude(unsigned i) const noexcept {
+    assert(i < size());
+
+    return altitudes[i];
+  }
+
+  gcc_pure
+  double GetVario(unsigned i) const noexcept {
+    assert(i < size());
+
+    return varios[i];
+  }
+
+  const unsigned *GetTimes() const noexcept {
+    return times.data();
+  }
+
+  const int *GetFlatX() const noexcept {
+    return xs.data();
+  }
+
+  const int *GetFlatY() const noexcept {
+    return ys.data();
+  }
+
+  const int *GetIntegerAltitudes() const noexcept {
+    return altitudes.data();
+  }
+
+  const float *GetVarios() const noexcept {
+    return varios.data();
+  }
+
+  /**
+   * Calculate the flat distances from the given location to the
+   * points [first, last).  The result is the same as
+   * FlatGeoPoint::Distance().
+   *
+   * @param dest an array of (last - first) elements
+   */
+  void CalcFlatDistances(FlatGeoPoint origin, unsigned first, unsigned last,
+                         unsigned *gcc_restrict dest) const noexcept {
+    assert(first <= last);
+    assert(last <= size());
+
+    const int *gcc_restrict x = xs.data(), *gcc_restrict y = ys.data();
+
+    /* two passes: the first one has no function calls and can be
+       vectorised, the second one calculates the square roots */
+    for (unsigned i = first; i < last; ++i) {
+      const int dx = x[i] - origin.x, dy = y[i] - origin.y;
+      dest[i - first] = dx * dx + dy * dy;
+    }
+
+    for (unsigned i = 0, n = last - first; i < n; ++i)
+      dest[i] = isqrt4(dest[i]);
+  }
+
+private:
+  void Append(const TracePoint &point) noexcept;
+};
+
+#endif
@@ -36,6 +36,9 @@ Trace::Trace(const unsigned _no_thin_time, const unsigned max_time,
    opt_size((3 * max_size) / 4)
 {
   assert(max_size >= 4);
+
+  delta_list.reserve(max_size);
+  skipped_deltas.reserve(max_size);
 }
 
 void
@@ -58,6 +61,54 @@ Trace::clear()
   ++append_serial;
 }
 
+void
+Trace::Replicate(const Trace &src)
+{
+  if (src.empty()) {
+    if (!empty())
+      clear();
+    return;
+  }
+
+  /* count the points which are newer than our last one; if the
+     source has only appended those since the last call, then
+     appending them here yields the same trace */
+  if (!empty() &&
+      src.front().GetTime() == front().GetTime() &&
+      src.back().GetTime() >= back().GetTime()) {
+    const unsigned last_time = back().GetTime();
+    const unsigned n_new =
+      std::count_if(src.begin(), src.end(),
+                    [last_time](const TracePoint &point){
+                      return point.GetTime() > last_time;
+                    });
+
+    if (size() + n_new == src.size()) {
+      for (auto i = std::prev(src.end(), n_new); i != src.end(); ++i)
+        push_back(*i);
+      return;
+    }
+  }
+
+  /* the source has been thinned, cleared or has gone back in time:
+     copy everything, including the projection */
+
+  clear();
+
+  task_projection = src.task_projection;
+  average_delta_distance = src.average_delta_distance;
+  average_delta_time = src.average_delta_time;
+
+  for (const TraceDelta &i : src.chronological_list) {
+    TraceDelta *td = allocator.allocate(1);
+    allocator.construct(td, i);
+
+    delta_list.push(*td);
+    chronological_list.push_back(*td);
+    ++cached_size;
+  }
+}
+
 unsigned
 Trace::GetRecentTime(const unsigned t) const
 {
@@ -74,7 +125,7 @@ Trace::GetRecentTime(const unsigned t) const
 void
 Trace::UpdateDelta(TraceDelta &td)
 {
-  assert(cached_size == delta_list.size());
+  assert(cached_size >= delta_list.size());
   assert(cached_size == chronological_list.size());
 
   if (&td == &chronological_list.front() ||
@@ -85,29 +136,29 @@ Trace::UpdateDelta(TraceDelta &td)
   const TraceDelta &previous = *std::prev(ci);
   const TraceDelta &next = *std::next(ci);
 
-  delta_list.erase(delta_list.iterator_to(td));
   td.Update(previous.point, next.point);
-  delta_list.insert(td);
+
+  /* items which were set aside by EraseDelta() are not in the heap */
+  if (td.IsLinked())
+    delta_list.update(td);
 }
 
 void
-Trace::EraseInside(DeltaList::iterator it)
+Trace::EraseInside(TraceDelta &td)
 {
   assert(cached_size > 0);
-  assert(cached_size == delta_list.size());
+  assert(cached_size >= delta_list.size());
   assert(cached_size == chronological_list.size());
-  assert(it != delta_list.end());
-
-  const TraceDelta &td = *it;
   assert(!td.IsEdge());
 
   const auto ci = chronological_list.iterator_to(td);
-  TraceDelta &previous = const_cast<TraceDelta &>(*std::prev(ci));
-  TraceDelta &next = const_cast<TraceDelta &>(*std::next(ci));
+  TraceDelta &previous = *std::prev(ci);
+  TraceDelta &next = *std::next(ci);
 
   // now delete the item
-  chronological_list.erase(chronological_list.iterator_to(td));
-  delta_list.erase_and_dispose(it, MakeDisposer());
+  chronological_list.erase(ci);
+  delta_list.erase(td);
+  MakeDisposer()(&td);
   --cached_size;
 
   // and update the deltas
@@ -128,19 +179,26 @@ Trace::EraseDelta(const unsigned target_size, const unsigned recent)
 
   const unsigned recent_time = GetRecentTime(recent);
 
-  auto candidate = delta_list.begin();
-  while (size() > target_size) {
-    const TraceDelta &td = *candidate;
+  /* the items which must not be removed are taken out of the heap
+     while thinning, and are put back afterwards */
+  assert(skipped_deltas.empty());
+
+  while (size() > target_size && !delta_list.empty()) {
+    TraceDelta &td = delta_list.top();
     if (!td.IsEdge() && td.point.GetTime() < recent_time) {
-      EraseInside(candidate);
-      candidate = delta_list.begin(); // find new top
+      EraseInside(td);
       modified = true;
     } else {
-      ++candidate;
       // suppressed removal, skip it.
+      delta_list.pop();
+      skipped_deltas.push_back(&td);
     }
   }
 
+  for (TraceDelta *td : skipped_deltas)
+    delta_list.push(*td);
+  skipped_deltas.clear();
+
   return modified;
 }
 
@@ -155,10 +213,8 @@ Trace::EraseEarlierThan(const unsigned p_time)
     auto ci = chronological_list.begin();
     TraceDelta &td = *ci;
     chronological_list.erase(ci);
-
-    auto i = delta_list.find(td);
-    assert(i != delta_list.end());
-    delta_list.erase_and_dispose(i, MakeDisposer());
+    delta_list.erase(td);
+    MakeDisposer()(&td);
 
     --cached_size;
   } while (!empty() && GetFront().point.GetTime() < p_time);
@@ -183,10 +239,8 @@ Trace::EraseLaterThan(const unsigned min_time)
     TraceDelta &td = GetBack();
 
     chronological_list.erase(chronological_list.iterator_to(td));
-
-    auto i = delta_list.find(td);
-    assert(i != delta_list.end());
-    delta_list.erase_and_dispose(i, MakeDisposer());
+    delta_list.erase(td);
+    MakeDisposer()(&td);
 
     --cached_size;
   }
@@ -203,12 +257,10 @@ Trace::EraseLaterThan(const unsigned min_time)
 void
 Trace::EraseStart(TraceDelta &td)
 {
-  delta_list.erase(delta_list.iterator_to(td));
-
   td.elim_distance = null_delta;
   td.elim_time = null_time;
 
-  delta_list.insert(td);
+  delta_list.update(td);
 }
 
 void
@@ -248,7 +300,7 @@ Trace::push_back(const TracePoint &point)
   allocator.construct(td, point);
   td->point.Project(task_projection);
 
-  delta_list.insert(*td);
+  delta_list.push(*td);
   chronological_list.push_back(*td);
 
   ++cached_size;
@@ -28,13 +28,14 @@ Copyright_License {
 #include "Util/NonCopyable.hpp"
 #include "Util/SliceAllocator.hxx"
 #include "Util/Serial.hpp"
+#include "Util/IndexedHeap.hpp"
 #include "Geo/Flat/TaskProjection.hpp"
 #include "Util/Compiler.h"
 
 #include <boost/intrusive/list.hpp>
-#include <boost/intrusive/set.hpp>
 
 #include <algorithm>
+#include <vector>
 
 #include <cassert>
 #include <stdlib.h>
@@ -55,7 +56,7 @@ class TracePointerVector;
 class Trace : private NonCopyable
 {
   struct TraceDelta
-    : boost::intrusive::set_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>>,
+    : IndexedHeapHook,
       boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>> {
 
     /**
@@ -168,11 +169,12 @@ class Trace : private NonCopyable
     }
   };
 
-  /* using multiset, not because we need multiple values (we don't),
-     but to avoid set's overhead for duplicate elimination */
-  typedef boost::intrusive::multiset<TraceDelta,
-                                     boost::intrusive::compare<TraceDelta::DeltaRankOp>,
-                                     boost::intrusive::constant_time_size<false>> DeltaList;
+  /**
+   * All points ranked by TraceDelta::DeltaRank(); the top is the
+   * best candidate for thinning.  During EraseDelta(), points which
+   * must not be thinned are temporarily removed from it.
+   */
+  typedef IndexedHeap<TraceDelta, TraceDelta::DeltaRankOp> DeltaList;
 
   typedef boost::intrusive::list<TraceDelta,
                                  boost::intrusive::constant_time_size<false>> ChronologicalList;
@@ -180,6 +182,12 @@ class Trace : private NonCopyable
   SliceAllocator<TraceDelta, 128u> allocator;
 
   DeltaList delta_list;
+
+  /**
+   * Temporary storage for EraseDelta().  This is a member only to
+   * reuse its memory.
+   */
+  std::vector<TraceDelta *> skipped_deltas;
   ChronologicalList chronological_list;
   unsigned cached_size;
 
@@ -256,13 +264,11 @@ protected:
 
   /**
    * Erase a non-edge item from delta list and tree, updating
-   * deltas in the process.  This Invalidates the calling iterator.
-   *
-   * @param it Item to erase
-   * @param tree Tree to remove from
+   * deltas in the process.
    *
+   * @param td Item to erase
    */
-  void EraseInside(DeltaList::iterator it);
+  void EraseInside(TraceDelta &td);
 
   /**
    * Erase elements based on delta metric until the size is
@@ -317,6 +323,18 @@ public:
    */
   void clear();
 
+  /**
+   * Make this object an exact copy of the given #Trace, which is
+   * usually owned by another thread.  Both must have been constructed
+   * with the same parameters.
+   *
+   * If the source has only appended points since the last call, then
+   * only those are appended here, which (like in the source) does not
+   * change the modify serial, and incremental solvers working on this
+   * object may continue.  Otherwise, everything is copied.
+   */
+  void Replicate(const Trace &src);
+
   void EraseEarlierThan(double time) {
     EraseEarlierThan((unsigned)time);
   }
@@ -329,6 +347,14 @@ public:
     return max_size;
   }
 
+  unsigned GetMaxTime() const {
+    return max_time;
+  }
+
+  unsigned GetNoThinTime() const {
+    return no_thin_time;
+  }
+
   /**
    * Size of traces (in tree, not in temporary store) ---
    * must call optimise() before this for it to be accurate.
@@ -29,6 +29,16 @@ struct GeoPoint;
 struct FlatGeoPoint;
 class SearchPoint;
 
+/**
+ * Contribution of the edge from a to b to the winding number of the
+ * point p: +1 for an upward crossing with p left of the edge, -1 for
+ * a downward crossing with p right of the edge, 0 otherwise.  This
+ * allows callers which know which edges may cross the latitude of p
+ * to calculate the winding number without looping over all edges.
+ */
+gcc_pure int
+PolygonEdgeWinding(const GeoPoint &p, const GeoPoint &a, const GeoPoint &b);
+
 /**
  * Note that this expects the vector to be closed, that is, starting point
  * and ending point are the same
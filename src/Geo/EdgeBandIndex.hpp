@@ -0,0 +1,178 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_GEO_EDGE_BAND_INDEX_HPP
+#define XCSOAR_GEO_EDGE_BAND_INDEX_HPP
+
+#include "Util/Compiler.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <assert.h>
+
+/**
+ * A spatial index over the edges of a polygon: the vertical range of
+ * the polygon is divided into bands of equal height, and each band
+ * lists the edges whose vertical extent overlaps it.  A query for a
+ * vertical range visits only the edges of the bands it overlaps,
+ * i.e. O(k) instead of O(n) edges.
+ *
+ * The edges are identified by their index; edge i connects vertices
+ * i and i+1.  The index does not store coordinates; the caller
+ * performs the exact test on each visited edge.
+ *
+ * @param T the coordinate type (integer or floating point)
+ */
+template<typename T>
+class EdgeBandIndex {
+  T y_min, band_height;
+
+  /**
+   * For each band, the position of its first element in #edges.
+   * Has one extra element at the end.
+   */
+  std::vector<unsigned> band_offsets;
+
+  std::vector<unsigned> edges;
+
+  /**
+   * The first band of each edge; used by Visit() to visit each edge
+   * only once.
+   */
+  std::vector<unsigned> first_bands;
+
+public:
+  /**
+   * Has Build() been called?
+   */
+  bool IsDefined() const noexcept {
+    return !band_offsets.empty();
+  }
+
+  void Clear() noexcept {
+    band_offsets.clear();
+    edges.clear();
+    first_bands.clear();
+  }
+
+  /**
+   * Build the index.
+   *
+   * @param n_edges the number of edges
+   * @param n_bands the number of bands; should be roughly
+   * proportional to the number of edges
+   * @param get_y a function returning the vertical coordinate of the
+   * given vertex (0..n_edges)
+   */
+  template<typename F>
+  void Build(unsigned n_edges, unsigned n_bands, F &&get_y) {
+    assert(n_edges > 0);
+    assert(n_bands > 0);
+
+    T y_max = y_min = get_y(0);
+    for (unsigned i = 1; i <= n_edges; ++i) {
+      const T y = get_y(i);
+      y_min = std::min(y_min, y);
+      y_max = std::max(y_max, y);
+    }
+
+    band_height = (y_max - y_min) / T(n_bands);
+    if (!(band_height > T(0)))
+      /* flat polygon (or integer range smaller than the number of
+         bands); GetBand() clamps to the last band */
+      band_height = T(1);
+
+    /* count the edges of each band */
+    band_offsets.assign(n_bands + 1, 0);
+    first_bands.resize(n_edges);
+    for (unsigned i = 0; i < n_edges; ++i) {
+      const auto range = GetBandRange(get_y(i), get_y(i + 1));
+      first_bands[i] = range.first;
+      for (unsigned b = range.first; b <= range.second; ++b)
+        ++band_offsets[b + 1];
+    }
+
+    for (unsigned b = 0; b < n_bands; ++b)
+      band_offsets[b + 1] += band_offsets[b];
+
+    /* fill the bands */
+    edges.resize(band_offsets.back());
+    std::vector<unsigned> fill(band_offsets.begin(), band_offsets.end() - 1);
+    for (unsigned i = 0; i < n_edges; ++i) {
+      const auto range = GetBandRange(get_y(i), get_y(i + 1));
+      for (unsigned b = range.first; b <= range.second; ++b)
+        edges[fill[b]++] = i;
+    }
+  }
+
+  /**
+   * Invoke the function once for each edge whose band overlaps the
+   * given vertical range (and possibly for some other edges).  Edges
+   * whose vertical extent overlaps the range are always visited.
+   */
+  template<typename F>
+  void Visit(T y1, T y2, F &&f) const {
+    assert(IsDefined());
+
+    const auto range = GetBandRange(y1, y2);
+
+    for (unsigned b = range.first; b <= range.second; ++b) {
+      for (unsigned i = band_offsets[b], end = band_offsets[b + 1];
+           i != end; ++i) {
+        const unsigned edge = edges[i];
+
+        /* an edge which spans several of the visited bands is
+           visited only in the first one */
+        if (b == std::max(range.first, first_bands[edge]))
+          f(edge);
+      }
+    }
+  }
+
+private:
+  gcc_pure
+  unsigned GetNumBands() const noexcept {
+    return band_offsets.size() - 1;
+  }
+
+  gcc_pure
+  unsigned GetBand(T y) const noexcept {
+    if (!(y > y_min))
+      return 0;
+
+    const T band = (y - y_min) / band_height;
+    const unsigned last = GetNumBands() - 1;
+    return band < T(last) ? unsigned(band) : last;
+  }
+
+  gcc_pure
+  std::pair<unsigned, unsigned> GetBandRange(T y1, T y2) const noexcept {
+    if (y2 < y1)
+      std::swap(y1, y2);
+
+    return std::make_pair(GetBand(y1), GetBand(y2));
+  }
+};
+
+#endif
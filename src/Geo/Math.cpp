@@ -159,18 +159,31 @@ Middle(const GeoPoint &a, const GeoPoint &b)
   return IntermediatePoint(a, b, distance / 2);
 }
 
+PreparedGeoPoint::PreparedGeoPoint(const GeoPoint &location)
+  :longitude(location.longitude), latitude(location.latitude)
+{
+  const auto u = atan((1 - FLATTENING) * latitude.tan());
+  sin_u = sin(u);
+  cos_u = cos(u);
+}
+
 void
 DistanceBearing(const GeoPoint &loc1, const GeoPoint &loc2,
                 double *distance, Angle *bearing)
 {
-  const auto lon21 = loc2.longitude - loc1.longitude;
+  DistanceBearing(PreparedGeoPoint(loc1), PreparedGeoPoint(loc2),
+                  distance, bearing);
+}
 
-  auto u1 = atan((1 - FLATTENING) * loc1.latitude.tan()),
-    u2 = atan((1 - FLATTENING) * loc2.latitude.tan());
+void
+DistanceBearing(const PreparedGeoPoint &loc1, const PreparedGeoPoint &loc2,
+                double *distance, Angle *bearing)
+{
+  const auto lon21 = loc2.longitude - loc1.longitude;
 
-  auto sinu1 = sin(u1), cosu1 = cos(u1);
+  const auto sinu1 = loc1.sin_u, cosu1 = loc1.cos_u;
 
-  auto sinu2 = sin(u2), cosu2 = cos(u2);
+  const auto sinu2 = loc2.sin_u, cosu2 = loc2.cos_u;
 
   auto lambda = lon21.Radians(), lambda_p = Angle::FullCircle().Radians();
 
@@ -384,6 +397,14 @@ Distance(const GeoPoint &loc1, const GeoPoint &loc2)
   return distance;
 }
 
+double
+Distance(const PreparedGeoPoint &loc1, const PreparedGeoPoint &loc2)
+{
+  double distance;
+  DistanceBearing(loc1, loc2, &distance, nullptr);
+  return distance;
+}
+
 Angle
 Bearing(const GeoPoint &loc1, const GeoPoint &loc2)
 {
@@ -31,10 +31,10 @@ Copyright_License {
 #ifndef XCSOAR_GEO_MATH_HPP
 #define XCSOAR_GEO_MATH_HPP
 
+#include "Math/Angle.hpp"
 #include "Util/Compiler.h"
 
 struct GeoPoint;
-class Angle;
 
 /**
  * Calculates projected distance from P3 along line P1-P2.
@@ -58,6 +58,37 @@ gcc_pure
 double
 Distance(const GeoPoint &loc1, const GeoPoint &loc2);
 
+/**
+ * A location with the values precalculated which Distance() derives
+ * from each location's latitude.  When calculating the distances
+ * between many pairs of a set of locations, this saves three
+ * trigonometric function calls per pair.
+ */
+struct PreparedGeoPoint {
+  Angle longitude, latitude;
+
+  /**
+   * Sine and cosine of the reduced latitude on the WGS84 ellipsoid.
+   */
+  double sin_u, cos_u;
+
+  PreparedGeoPoint() = default;
+
+  explicit PreparedGeoPoint(const GeoPoint &location);
+};
+
+void
+DistanceBearing(const PreparedGeoPoint &loc1, const PreparedGeoPoint &loc2,
+                double *distance, Angle *bearing);
+
+/**
+ * Calculates the distance between two locations; the result is the
+ * same as Distance(const GeoPoint &, const GeoPoint &).
+ */
+gcc_pure
+double
+Distance(const PreparedGeoPoint &loc1, const PreparedGeoPoint &loc2);
+
 /**
  * Calculates the bearing between two locations
  * @param loc1 Location 1
@@ -35,13 +35,16 @@ class FileCache {
 public:
   FileCache(AllocatedPath &&_cache_path);
 
-protected:
+  /**
+   * Returns the path of the given cache file.  This can be used for
+   * cache files which are managed by the caller, and which are not
+   * validated against an original file.
+   */
   gcc_pure
   AllocatedPath MakeCachePath(const TCHAR *name) const {
     return AllocatedPath::Build(cache_path, name);
   }
 
-public:
   void Flush(const TCHAR *name);
   FILE *Load(const TCHAR *name, Path original_path);
 
@@ -36,4 +36,5 @@ Profile::Load(const ProfileMap &map, ContestSettings &settings)
   }
 
   map.Get(ProfileKeys::PredictContest, settings.predict);
+  map.Get(ProfileKeys::ContestTickBudget, settings.tick_budget);
 }
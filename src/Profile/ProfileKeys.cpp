@@ -146,6 +146,8 @@ const char MenuTimeout[] = "MenuTimeout";
 const char TerrainContrast[] = "TerrainContrast";
 const char TerrainBrightness[] = "TerrainBrightness";
 const char TerrainRamp[] = "TerrainRamp";
+const char TerrainTileCacheSize[] = "TerrainTileCacheSize";
+const char TerrainMapped[] = "TerrainMapped";
 const char EnableFLARMMap[] = "EnableFLARMDisplay";
 const char EnableFLARMGauge[] = "EnableFLARMGauge";
 const char AutoCloseFlarmDialog[] = "AutoCloseFlarmDialog";
@@ -184,6 +186,7 @@ const char AutoMc[] = "AutoMc";
 const char EnableExternalTriggerCruise[] = "EnableExternalTriggerCruise";
 const char OLCRules[] = "OLCRules";
 const char PredictContest[] = "PredictContest";
+const char ContestTickBudget[] = "ContestTickBudget";
 const char Handicap[] = "Handicap";
 const char SnailWidthScale[] = "SnailWidthScale";
 const char SnailType[] = "SnailType";
@@ -138,6 +138,8 @@ extern const char MenuTimeout[];
 extern const char TerrainContrast[];
 extern const char TerrainBrightness[];
 extern const char TerrainRamp[];
+extern const char TerrainTileCacheSize[];
+extern const char TerrainMapped[];
 extern const char EnableFLARMMap[];
 extern const char EnableFLARMGauge[];
 extern const char AutoCloseFlarmDialog[];
@@ -179,6 +181,7 @@ extern const char AutoMc[];
 extern const char EnableExternalTriggerCruise[];
 extern const char OLCRules[];
 extern const char PredictContest[];
+extern const char ContestTickBudget[];
 extern const char Handicap[];
 extern const char SnailWidthScale[];
 extern const char SnailType[];
@@ -27,7 +27,9 @@ Copyright_License {
 #include "Util/StaticArray.hxx"
 #include "Geo/GeoPoint.hpp"
 
-#ifndef ENABLE_OPENGL
+#ifdef ENABLE_OPENGL
+#include "AirspaceVertexCache.hpp"
+#else
 #include "TransparentRendererCache.hpp"
 #endif
 
@@ -52,7 +54,13 @@ class AirspaceRenderer
 
   StaticArray<GeoPoint,32> intersections;
 
-#ifndef ENABLE_OPENGL
+#ifdef ENABLE_OPENGL
+  /**
+   * The polygon vertices in an OpenGL buffer, which is built once
+   * and then reused in every frame.
+   */
+  AirspaceVertexCache vertex_cache;
+#else
   /**
    * This object caches the airspace fill.  This avoids drawing it
    * again and again each frame when nothing has changed.
@@ -35,9 +35,95 @@ Copyright_License {
 #include "Airspace/AirspaceWarningCopy.hpp"
 #include "Engine/Airspace/Predicate/AirspacePredicate.hpp"
 #include "Screen/OpenGL/Scope.hpp"
+#include "Screen/OpenGL/Geo.hpp"
 
-class AirspaceVisitorRenderer final
+#include <glm/mat4x4.hpp>
+
+/**
+ * A #MapCanvas which draws airspace polygons from the
+ * #AirspaceVertexCache, and projects them to screen coordinates only
+ * if the cache cannot be used.
+ */
+class AirspacePolygonCanvas
   : protected MapCanvas
+{
+  const glm::mat4 modelview;
+
+  /**
+   * The airspace which was last passed to PreparePolygon(), and the
+   * return value of that call.
+   */
+  const AirspacePolygon *prepared_airspace = nullptr;
+  bool prepared_visible;
+
+protected:
+  const AirspaceVertexCache &vertex_cache;
+
+  /**
+   * Copies of the pen and brush selected in the #Canvas, for drawing
+   * from the #AirspaceVertexCache.
+   */
+  Pen pen;
+  Brush brush;
+
+  AirspacePolygonCanvas(Canvas &_canvas, const WindowProjection &_projection,
+                        const AirspaceVertexCache &_vertex_cache)
+    :MapCanvas(_canvas, _projection,
+               _projection.GetScreenBounds().Scale(1.1)),
+     modelview(ToGLM(_projection, _vertex_cache.GetCenter())),
+     vertex_cache(_vertex_cache) {}
+
+  void Select(const Pen &_pen) {
+    pen = _pen;
+    canvas.Select(pen);
+  }
+
+  void Select(const Brush &_brush) {
+    brush = _brush;
+    canvas.Select(brush);
+  }
+
+  /**
+   * Fill the polygon with the selected brush.
+   */
+  void DrawInterior(const AirspacePolygon &airspace,
+                    const AirspaceVertexCache::Polygon *cached) {
+    if (cached != nullptr)
+      vertex_cache.DrawFill(*cached, modelview, brush);
+    else if (Prepare(airspace))
+      DrawPrepared();
+  }
+
+  /**
+   * Draw the outline of the polygon with the selected pen.
+   */
+  void DrawOutline(const AirspacePolygon &airspace,
+                   const AirspaceVertexCache::Polygon *cached) {
+    if (cached != nullptr && AirspaceVertexCache::CanDrawOutline(pen))
+      vertex_cache.DrawOutline(*cached, modelview, pen);
+    else if (Prepare(airspace))
+      DrawPrepared();
+  }
+
+private:
+  /**
+   * Call PreparePolygon() unless that has already been done for this
+   * airspace.
+   *
+   * @return false if the polygon is not visible
+   */
+  bool Prepare(const AirspacePolygon &airspace) {
+    if (&airspace != prepared_airspace) {
+      prepared_airspace = &airspace;
+      prepared_visible = PreparePolygon(airspace.GetPoints());
+    }
+
+    return prepared_visible;
+  }
+};
+
+class AirspaceVisitorRenderer final
+  : protected AirspacePolygonCanvas
 {
   const AirspaceLook &look;
   const AirspaceWarningCopy &warning_manager;
@@ -47,9 +133,9 @@ public:
   AirspaceVisitorRenderer(Canvas &_canvas, const WindowProjection &_projection,
                           const AirspaceLook &_look,
                           const AirspaceWarningCopy &_warnings,
-                          const AirspaceRendererSettings &_settings)
-    :MapCanvas(_canvas, _projection,
-               _projection.GetScreenBounds().Scale(1.1)),
+                          const AirspaceRendererSettings &_settings,
+                          const AirspaceVertexCache &_vertex_cache)
+    :AirspacePolygonCanvas(_canvas, _projection, _vertex_cache),
      look(_look), warning_manager(_warnings), settings(_settings)
   {
     glStencilMask(0xff);
@@ -100,8 +186,7 @@ private:
   }
 
   void VisitPolygon(const AirspacePolygon &airspace) {
-    if (!PreparePolygon(airspace.GetPoints()))
-      return;
+    const auto *cached = vertex_cache.Find(airspace);
 
     const AirspaceClassRendererSettings &class_settings =
       settings.classes[airspace.GetType()];
@@ -119,7 +204,7 @@ private:
       if (!fill_airspace) {
         // set stencil for filling (bit 0)
         SetFillStencil();
-        DrawPrepared();
+        DrawOutline(airspace, cached);
         glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
       }
 
@@ -127,20 +212,20 @@ private:
       {
         SetupInterior(airspace, !fill_airspace);
         const GLEnable<GL_BLEND> blend;
-        DrawPrepared();
+        DrawInterior(airspace, cached);
       }
 
       if (!fill_airspace) {
         // clear fill stencil (bit 0)
         ClearFillStencil();
-        DrawPrepared();
+        DrawOutline(airspace, cached);
         glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
       }
     }
 
     // draw outline
     if (SetupOutline(airspace))
-      DrawPrepared();
+      DrawOutline(airspace, cached);
   }
 
 public:
@@ -161,12 +246,12 @@ private:
     AirspaceClass type = airspace.GetType();
 
     if (settings.black_outline)
-      canvas.SelectBlackPen();
+      Select(Pen(1, COLOR_BLACK));
     else if (settings.classes[type].border_width == 0)
       // Don't draw outlines if border_width == 0
       return false;
     else
-      canvas.Select(look.classes[type].border_pen);
+      Select(look.classes[type].border_pen);
 
     canvas.SelectHollowBrush();
 
@@ -189,7 +274,7 @@ private:
       glStencilFunc(GL_EQUAL, 0, 2);
     glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 
-    canvas.Select(Brush(class_look.fill_color.WithAlpha(90)));
+    Select(Brush(class_look.fill_color.WithAlpha(90)));
     canvas.SelectNullPen();
   }
 
@@ -200,7 +285,7 @@ private:
     glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 
     canvas.SelectHollowBrush();
-    canvas.Select(look.thick_pen);
+    Select(look.thick_pen);
   }
 
   void ClearFillStencil() {
@@ -210,12 +295,12 @@ private:
     glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
 
     canvas.SelectHollowBrush();
-    canvas.Select(look.thick_pen);
+    Select(look.thick_pen);
   }
 };
 
 class AirspaceFillRenderer final
-  : protected MapCanvas
+  : protected AirspacePolygonCanvas
 {
   const AirspaceLook &look;
   const AirspaceWarningCopy &warning_manager;
@@ -225,9 +310,9 @@ public:
   AirspaceFillRenderer(Canvas &_canvas, const WindowProjection &_projection,
                        const AirspaceLook &_look,
                        const AirspaceWarningCopy &_warnings,
-                       const AirspaceRendererSettings &_settings)
-    :MapCanvas(_canvas, _projection,
-               _projection.GetScreenBounds().Scale(1.1)),
+                       const AirspaceRendererSettings &_settings,
+                       const AirspaceVertexCache &_vertex_cache)
+    :AirspacePolygonCanvas(_canvas, _projection, _vertex_cache),
      look(_look), warning_manager(_warnings), settings(_settings)
   {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -249,18 +334,17 @@ private:
   }
 
   void VisitPolygon(const AirspacePolygon &airspace) {
-    if (!PreparePolygon(airspace.GetPoints()))
-      return;
+    const auto *cached = vertex_cache.Find(airspace);
 
     if (!warning_manager.IsAcked(airspace) && SetupInterior(airspace)) {
       // fill interior without overpainting any previous outlines
       GLEnable<GL_BLEND> blend;
-      DrawPrepared();
+      DrawInterior(airspace, cached);
     }
 
     // draw outline
     if (SetupOutline(airspace))
-      DrawPrepared();
+      DrawOutline(airspace, cached);
   }
 
 public:
@@ -281,12 +365,12 @@ private:
     AirspaceClass type = airspace.GetType();
 
     if (settings.black_outline)
-      canvas.SelectBlackPen();
+      Select(Pen(1, COLOR_BLACK));
     else if (settings.classes[type].border_width == 0)
       // Don't draw outlines if border_width == 0
       return false;
     else
-      canvas.Select(look.classes[type].border_pen);
+      Select(look.classes[type].border_pen);
 
     canvas.SelectHollowBrush();
 
@@ -299,7 +383,7 @@ private:
 
     const AirspaceClassLook &class_look = look.classes[airspace.GetType()];
 
-    canvas.Select(Brush(class_look.fill_color.WithAlpha(48)));
+    Select(Brush(class_look.fill_color.WithAlpha(48)));
     canvas.SelectNullPen();
 
     return true;
@@ -313,20 +397,24 @@ AirspaceRenderer::DrawInternal(Canvas &canvas,
                                const AirspaceWarningCopy &awc,
                                const AirspacePredicate &visible)
 {
+  vertex_cache.Update(*airspaces);
+
   const auto range =
     airspaces->QueryWithinRange(projection.GetGeoScreenCenter(),
                                 projection.GetScreenDistanceMeters());
 
   if (settings.fill_mode == AirspaceRendererSettings::FillMode::ALL ||
       settings.fill_mode == AirspaceRendererSettings::FillMode::NONE) {
-    AirspaceFillRenderer renderer(canvas, projection, look, awc, settings);
+    AirspaceFillRenderer renderer(canvas, projection, look, awc, settings,
+                                  vertex_cache);
     for (const auto &i : range) {
       const AbstractAirspace &airspace = i.GetAirspace();
       if (visible(airspace))
         renderer.Visit(airspace);
     }
   } else {
-    AirspaceVisitorRenderer renderer(canvas, projection, look, awc, settings);
+    AirspaceVisitorRenderer renderer(canvas, projection, look, awc, settings,
+                                     vertex_cache);
     for (const auto &i : range) {
       const AbstractAirspace &airspace = i.GetAirspace();
       if (visible(airspace))
@@ -0,0 +1,199 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifdef ENABLE_OPENGL
+
+#include "AirspaceVertexCache.hpp"
+#include "Airspace/Airspaces.hpp"
+#include "Airspace/AirspacePolygon.hpp"
+#include "Screen/Pen.hpp"
+#include "Screen/Brush.hpp"
+#include "Screen/OpenGL/Buffer.hpp"
+#include "Screen/OpenGL/VertexPointer.hpp"
+#include "Screen/OpenGL/Triangulate.hpp"
+#include "Screen/OpenGL/Program.hpp"
+#include "Screen/OpenGL/Shaders.hpp"
+#include "Math/Point2D.hpp"
+
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <assert.h>
+
+AirspaceVertexCache::AirspaceVertexCache()
+  :array_buffer(nullptr), airspaces(nullptr)
+{
+  AddSurfaceListener(*this);
+}
+
+AirspaceVertexCache::~AirspaceVertexCache()
+{
+  RemoveSurfaceListener(*this);
+
+  delete array_buffer;
+}
+
+void
+AirspaceVertexCache::Update(const Airspaces &_airspaces)
+{
+  if (array_buffer == nullptr)
+    array_buffer = new GLArrayBuffer();
+  else if (&_airspaces == airspaces && _airspaces.GetSerial() == serial)
+    return;
+
+  airspaces = &_airspaces;
+  serial = _airspaces.GetSerial();
+
+  polygons.clear();
+  triangles.clear();
+
+  if (_airspaces.IsEmpty())
+    /* the projection is not initialised */
+    return;
+
+  center = _airspaces.GetProjection().GetCenter();
+
+  std::vector<FloatPoint2D> vertices;
+
+  for (const auto &i : _airspaces.QueryAll()) {
+    const AbstractAirspace &airspace = i.GetAirspace();
+    if (airspace.GetShape() != AbstractAirspace::Shape::POLYGON)
+      continue;
+
+    const SearchPointVector &points = airspace.GetPoints();
+    if (points.size() < 3 || points.size() > 0xffff)
+      /* too large for 16 bit triangle indices; this one will be
+         drawn in screen coordinates */
+      continue;
+
+    Polygon polygon;
+    polygon.offset = vertices.size();
+    polygon.n_vertices = points.size();
+    polygon.first_index = triangles.size();
+
+    for (const auto &p : points) {
+      const GeoPoint relative = p.GetLocation() - center;
+      vertices.emplace_back(float(relative.longitude.Native()),
+                            float(relative.latitude.Native()));
+    }
+
+    triangles.resize(polygon.first_index + 3 * (polygon.n_vertices - 2));
+    polygon.n_indices =
+      PolygonToTriangles(vertices.data() + polygon.offset,
+                         polygon.n_vertices,
+                         triangles.data() + polygon.first_index, 0);
+    triangles.resize(polygon.first_index + polygon.n_indices);
+
+    if (polygon.n_indices == 0) {
+      /* triangulation has failed; discard the vertices, too */
+      vertices.resize(polygon.offset);
+      continue;
+    }
+
+    polygons.insert(std::make_pair(&airspace, polygon));
+  }
+
+  array_buffer->Load(GLsizeiptr(vertices.size() * sizeof(vertices.front())),
+                     vertices.data());
+}
+
+const AirspaceVertexCache::Polygon *
+AirspaceVertexCache::Find(const AirspacePolygon &airspace) const
+{
+  auto i = polygons.find(&airspace);
+  return i != polygons.end()
+    ? &i->second
+    : nullptr;
+}
+
+bool
+AirspaceVertexCache::CanDrawOutline(const Pen &pen)
+{
+  /* same condition as in Canvas::DrawPolygon() */
+  return pen.GetWidth() <= 2;
+}
+
+void
+AirspaceVertexCache::DrawFill(const Polygon &polygon,
+                              const glm::mat4 &modelview,
+                              const Brush &brush) const
+{
+  assert(array_buffer != nullptr);
+
+  OpenGL::solid_shader->Use();
+  glUniformMatrix4fv(OpenGL::solid_modelview, 1, GL_FALSE,
+                     glm::value_ptr(modelview));
+
+  array_buffer->Bind();
+  const FloatPoint2D *const buffer = nullptr;
+  ScopeVertexPointer vp(buffer + polygon.offset);
+
+  brush.Bind();
+  glDrawElements(GL_TRIANGLES, polygon.n_indices, GL_UNSIGNED_SHORT,
+                 triangles.data() + polygon.first_index);
+
+  array_buffer->Unbind();
+
+  glUniformMatrix4fv(OpenGL::solid_modelview, 1, GL_FALSE,
+                     glm::value_ptr(glm::mat4(1)));
+}
+
+void
+AirspaceVertexCache::DrawOutline(const Polygon &polygon,
+                                 const glm::mat4 &modelview,
+                                 const Pen &pen) const
+{
+  assert(array_buffer != nullptr);
+  assert(CanDrawOutline(pen));
+
+  OpenGL::solid_shader->Use();
+  glUniformMatrix4fv(OpenGL::solid_modelview, 1, GL_FALSE,
+                     glm::value_ptr(modelview));
+
+  array_buffer->Bind();
+  const FloatPoint2D *const buffer = nullptr;
+  ScopeVertexPointer vp(buffer + polygon.offset);
+
+  pen.Bind();
+  glDrawArrays(GL_LINE_LOOP, 0, polygon.n_vertices);
+  pen.Unbind();
+
+  array_buffer->Unbind();
+
+  glUniformMatrix4fv(OpenGL::solid_modelview, 1, GL_FALSE,
+                     glm::value_ptr(glm::mat4(1)));
+}
+
+void
+AirspaceVertexCache::SurfaceCreated()
+{
+}
+
+void
+AirspaceVertexCache::SurfaceDestroyed()
+{
+  delete array_buffer;
+  array_buffer = nullptr;
+}
+
+#endif /* ENABLE_OPENGL */
@@ -0,0 +1,149 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_AIRSPACE_VERTEX_CACHE_HPP
+#define XCSOAR_AIRSPACE_VERTEX_CACHE_HPP
+
+#include "Screen/OpenGL/Surface.hpp"
+#include "Screen/OpenGL/System.hpp"
+#include "Util/FlatHashMap.hpp"
+#include "Util/Serial.hpp"
+#include "Util/Compiler.h"
+#include "Geo/GeoPoint.hpp"
+
+#include <glm/fwd.hpp>
+
+#include <vector>
+
+class Airspaces;
+class AbstractAirspace;
+class AirspacePolygon;
+class GLArrayBuffer;
+class Pen;
+class Brush;
+
+/**
+ * Keeps the vertices of all airspace polygons in a static OpenGL
+ * array buffer, together with their triangulation.  The vertices are
+ * stored in radians relative to the #Airspaces projection center,
+ * just like #TopographyFileRenderer does it, and are transformed to
+ * screen coordinates by the model-view matrix (see ToGLM()).  This
+ * avoids projecting and triangulating each polygon again in every
+ * frame.
+ */
+class AirspaceVertexCache final : GLSurfaceListener {
+public:
+  struct Polygon {
+    /**
+     * The index of the first vertex in the array buffer.
+     */
+    unsigned offset;
+
+    /**
+     * The number of vertices in the array buffer.
+     */
+    unsigned n_vertices;
+
+    /**
+     * The position of this polygon's triangle indices in
+     * #triangles.  They are relative to #offset.
+     */
+    unsigned first_index, n_indices;
+  };
+
+private:
+  GLArrayBuffer *array_buffer;
+
+  /**
+   * The #Airspaces object and its serial which #array_buffer was
+   * built from.
+   */
+  const Airspaces *airspaces;
+  Serial serial;
+
+  /**
+   * The reference point of all vertices.
+   */
+  GeoPoint center;
+
+  FlatHashMap<const AbstractAirspace *, Polygon> polygons;
+
+  std::vector<GLushort> triangles;
+
+public:
+  AirspaceVertexCache();
+  ~AirspaceVertexCache();
+
+  AirspaceVertexCache(const AirspaceVertexCache &) = delete;
+  AirspaceVertexCache &operator=(const AirspaceVertexCache &) = delete;
+
+  const GeoPoint &GetCenter() const {
+    return center;
+  }
+
+  /**
+   * Rebuild the array buffer if the given #Airspaces object is a
+   * different one or has been modified since the last call.
+   */
+  void Update(const Airspaces &airspaces);
+
+  /**
+   * Look up the given polygon.  Returns nullptr if it is not in the
+   * cache (e.g. because it could not be triangulated); the caller
+   * must then fall back to drawing it in screen coordinates.
+   */
+  gcc_pure
+  const Polygon *Find(const AirspacePolygon &airspace) const;
+
+  /**
+   * Can the given pen be drawn by DrawOutline()?  Wide lines are
+   * built from triangles in screen coordinates (see
+   * Canvas::DrawPolygon()), which cannot be cached.
+   */
+  gcc_pure
+  static bool CanDrawOutline(const Pen &pen);
+
+  /**
+   * Fill the polygon with the given brush.
+   *
+   * @param modelview the matrix returned by ToGLM() for #center
+   */
+  void DrawFill(const Polygon &polygon, const glm::mat4 &modelview,
+                const Brush &brush) const;
+
+  /**
+   * Draw the outline of the polygon with the given pen.  The pen
+   * must be accepted by CanDrawOutline().
+   *
+   * @param modelview the matrix returned by ToGLM() for #center
+   */
+  void DrawOutline(const Polygon &polygon, const glm::mat4 &modelview,
+                   const Pen &pen) const;
+
+private:
+  /* virtual methods from class GLSurfaceListener */
+  void SurfaceCreated() override;
+  void SurfaceDestroyed() override;
+};
+
+#endif
@@ -27,6 +27,7 @@
 #endif
 
 #include <cstdint>
+#include <cassert>
 
 class Canvas;
 
@@ -172,6 +173,19 @@ public:
 #endif
   }
 
+  /**
+   * Returns a pointer to the specified row (0 is the top-most row).
+   */
+  RawColor *GetRow(unsigned y) {
+    assert(y < height);
+
+#ifndef USE_GDI
+    return GetBuffer() + y * corrected_width;
+#else
+    return GetBuffer() + (height - 1 - y) * corrected_width;
+#endif
+  }
+
   void SetDirty() {
 #ifdef ENABLE_OPENGL
     dirty = true;
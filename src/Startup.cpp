@@ -351,7 +351,7 @@ Startup()
 
   // Reads the airspace files
   ReadAirspace(airspace_database, terrain, computer_settings.pressure,
-               operation);
+               file_cache, operation);
 
   {
     const AircraftState aircraft_state =
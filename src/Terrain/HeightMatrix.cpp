@@ -23,6 +23,7 @@ Copyright_License {
 
 #include "HeightMatrix.hpp"
 #include "RasterMap.hpp"
+#include "Thread/ThreadPool.hpp"
 
 #ifdef ENABLE_OPENGL
 #include "Geo/GeoBounds.hpp"
@@ -30,7 +31,10 @@ Copyright_License {
 #include "Projection/WindowProjection.hpp"
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <string.h>
+#include <stdlib.h>
 
 void
 HeightMatrix::SetSize(size_t _size)
@@ -57,29 +61,65 @@ HeightMatrix::SetSize(unsigned width, unsigned height,
           (height + quantisation_pixels - 1) / quantisation_pixels);
 }
 
+/**
+ * Invoke the function f(y0, y1) for bands of rows which together
+ * cover the range [y0, y1).  If a #ThreadPool is given, the bands
+ * are processed in parallel.  Each row must be independent of all
+ * others.
+ */
+template<typename F>
+static void
+ForEachRowBand(ThreadPool *pool, unsigned y0, unsigned y1, F &&f)
+{
+  const unsigned n_rows = y1 - y0;
+
+  /* a few more bands than threads, because some rows (e.g. those
+     outside of the map) are much cheaper than others */
+  const unsigned n_bands = pool != nullptr
+    ? std::min(n_rows, pool->GetConcurrency() * 2)
+    : 1;
+
+  if (n_bands <= 1) {
+    f(y0, y1);
+    return;
+  }
+
+  pool->Run(n_bands, [y0, n_rows, n_bands, &f](unsigned i){
+      f(y0 + i * n_rows / n_bands, y0 + (i + 1) * n_rows / n_bands);
+    });
+}
+
 #ifdef ENABLE_OPENGL
 
 void
 HeightMatrix::Fill(const RasterMap &map, const GeoBounds &bounds,
-                   unsigned width, unsigned height, bool interpolate)
+                   unsigned width, unsigned height, bool interpolate,
+                   ThreadPool *pool)
 {
   SetSize(width, height);
 
   const Angle delta_y = bounds.GetHeight() / height;
-  Angle latitude = bounds.GetNorth();
-  for (auto p = data.begin(), end = p + width * height;
-       p != end; p += width, latitude -= delta_y) {
-    map.ScanLine(GeoPoint(bounds.GetWest(), latitude),
-                 GeoPoint(bounds.GetEast(), latitude),
-                 p, width, interpolate);
-  }
+
+  ForEachRowBand(pool, 0, height, [&](unsigned y0, unsigned y1){
+      auto p = data.begin() + y0 * width;
+      for (unsigned y = y0; y < y1; ++y, p += width) {
+        /* calculate the latitude from the row number instead of
+           accumulating delta_y, so the result does not depend on how
+           the rows are split into bands */
+        const Angle latitude = bounds.GetNorth() - delta_y * y;
+        map.ScanLine(GeoPoint(bounds.GetWest(), latitude),
+                     GeoPoint(bounds.GetEast(), latitude),
+                     p, width, interpolate);
+      }
+    });
 }
 
 #else
 
 void
 HeightMatrix::Fill(const RasterMap &map, const WindowProjection &projection,
-                   unsigned quantisation_pixels, bool interpolate)
+                   unsigned quantisation_pixels, bool interpolate,
+                   ThreadPool *pool)
 {
   const unsigned screen_width = projection.GetScreenWidth();
   const unsigned screen_height = projection.GetScreenHeight();
@@ -87,13 +127,90 @@ HeightMatrix::Fill(const RasterMap &map, const WindowProjection &projection,
   SetSize((screen_width + quantisation_pixels - 1) / quantisation_pixels,
           (screen_height + quantisation_pixels - 1) / quantisation_pixels);
 
-  auto p = data.begin();
-  for (unsigned y = 0; y < screen_height;
-       y += quantisation_pixels, p += width) {
-    map.ScanLine(projection.ScreenToGeo(0, y),
-                 projection.ScreenToGeo(screen_width, y),
-                 p, width, interpolate);
+  FillRect(map, projection, PixelPoint(0, 0), quantisation_pixels,
+           0, width, 0, height, interpolate, pool);
+}
+
+void
+HeightMatrix::FillRect(const RasterMap &map,
+                       const WindowProjection &projection,
+                       PixelPoint origin, unsigned quantisation_pixels,
+                       unsigned x0, unsigned x1, unsigned y0, unsigned y1,
+                       bool interpolate, ThreadPool *pool)
+{
+  assert(x0 <= x1 && x1 <= width);
+  assert(y0 <= y1 && y1 <= height);
+
+  if (x0 == x1)
+    return;
+
+  const int q = quantisation_pixels;
+  const int left = origin.x + int(x0) * q;
+  const int right = origin.x + int(x1 - 1) * q;
+
+  ForEachRowBand(pool, y0, y1, [&](unsigned band_y0, unsigned band_y1){
+      auto p = data.begin() + band_y0 * width + x0;
+      for (unsigned y = band_y0; y < band_y1; ++y, p += width) {
+        const int screen_y = origin.y + int(y) * q;
+        const GeoPoint start = projection.ScreenToGeo(left, screen_y);
+
+        if (x1 - x0 == 1)
+          /* ScanLine() needs at least two distinct points */
+          *p = map.GetInterpolatedHeight(start);
+        else
+          map.ScanLine(start, projection.ScreenToGeo(right, screen_y),
+                       p, x1 - x0, interpolate);
+      }
+    });
+}
+
+void
+HeightMatrix::Shift(int dx, int dy)
+{
+  assert(unsigned(abs(dx)) < width);
+  assert(unsigned(abs(dy)) < height);
+
+  const unsigned n = width - abs(dx);
+  const int src_offset = dy * int(width) + dx;
+
+  auto move_row = [this, n, dx, src_offset](unsigned y){
+    TerrainHeight *dest = data.begin() + y * width + std::max(-dx, 0);
+    memmove(dest, dest + src_offset, n * sizeof(*dest));
+  };
+
+  if (dy > 0) {
+    for (unsigned y = 0, end = height - dy; y < end; ++y)
+      move_row(y);
+  } else {
+    for (unsigned y = height; y > unsigned(-dy); --y)
+      move_row(y - 1);
   }
 }
 
+void
+HeightMatrix::Shift(const RasterMap &map, const WindowProjection &projection,
+                    PixelPoint origin, unsigned quantisation_pixels,
+                    int dx, int dy, bool interpolate, ThreadPool *pool)
+{
+  Shift(dx, dy);
+
+  /* scan the newly exposed rows, and then the newly exposed columns
+     of the remaining rows */
+
+  const unsigned keep_y0 = dy < 0 ? -dy : 0;
+  const unsigned keep_y1 = dy > 0 ? height - dy : height;
+
+  FillRect(map, projection, origin, quantisation_pixels,
+           0, width, 0, keep_y0, interpolate, pool);
+  FillRect(map, projection, origin, quantisation_pixels,
+           0, width, keep_y1, height, interpolate, pool);
+
+  if (dx < 0)
+    FillRect(map, projection, origin, quantisation_pixels,
+             0, -dx, keep_y0, keep_y1, interpolate, pool);
+  else if (dx > 0)
+    FillRect(map, projection, origin, quantisation_pixels,
+             width - dx, width, keep_y0, keep_y1, interpolate, pool);
+}
+
 #endif
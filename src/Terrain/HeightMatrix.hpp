@@ -28,11 +28,13 @@ Copyright_License {
 #include "Util/AllocatedArray.hxx"
 
 class RasterMap;
+class ThreadPool;
 
 #ifdef ENABLE_OPENGL
 class GeoBounds;
 #else
 class WindowProjection;
+struct PixelPoint;
 #endif
 
 class HeightMatrix {
@@ -54,15 +56,57 @@ public:
 #ifdef ENABLE_OPENGL
   /**
    * Copy values from the #RasterMap to the buffer, north-up only.
+   *
+   * @param pool an optional #ThreadPool which is used to scan bands
+   * of rows in parallel
    */
   void Fill(const RasterMap &map, const GeoBounds &bounds,
-            unsigned _width, unsigned _height, bool interpolate);
+            unsigned _width, unsigned _height, bool interpolate,
+            ThreadPool *pool=nullptr);
 #else
   /**
    * @param interpolate true enables interpolation of sub-pixel values
+   * @param pool an optional #ThreadPool which is used to scan bands
+   * of rows in parallel
    */
   void Fill(const RasterMap &map, const WindowProjection &map_projection,
-            unsigned quantisation_pixels, bool interpolate);
+            unsigned quantisation_pixels, bool interpolate,
+            ThreadPool *pool=nullptr);
+
+  /**
+   * Fill a rectangle of cells without resizing the matrix.  The cell
+   * (x, y) is sampled at the screen position (origin.x + x *
+   * quantisation_pixels, origin.y + y * quantisation_pixels).
+   *
+   * @param x0 the first column
+   * @param x1 the end column (exclusive)
+   * @param y0 the first row
+   * @param y1 the end row (exclusive)
+   */
+  void FillRect(const RasterMap &map, const WindowProjection &map_projection,
+                PixelPoint origin, unsigned quantisation_pixels,
+                unsigned x0, unsigned x1, unsigned y0, unsigned y1,
+                bool interpolate, ThreadPool *pool=nullptr);
+
+  /**
+   * Move the contents of the matrix, so that the new cell (x, y)
+   * contains the value of the old cell (x + dx, y + dy).  The values
+   * of the newly exposed cells are undefined; they have to be filled
+   * with FillRect().
+   */
+  void Shift(int dx, int dy);
+
+  /**
+   * Move the contents of the matrix with Shift(), and fill the newly
+   * exposed cells with FillRect().  The result is the same as a
+   * FillRect() of the whole matrix, except for the rounding errors of
+   * the kept cells, which were sampled with a different projection.
+   *
+   * @param origin the screen position of the new cell (0,0)
+   */
+  void Shift(const RasterMap &map, const WindowProjection &map_projection,
+             PixelPoint origin, unsigned quantisation_pixels,
+             int dx, int dy, bool interpolate, ThreadPool *pool=nullptr);
 #endif
 
   unsigned GetWidth() const {
@@ -0,0 +1,106 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_TERRAIN_INTERPOLATE_HPP
+#define XCSOAR_TERRAIN_INTERPOLATE_HPP
+
+#include "Height.hpp"
+#include "Util/Compiler.h"
+
+#ifdef __ARM_NEON__
+#include "NEON.hpp"
+#elif defined(__SSE2__)
+#include "SSE2.hpp"
+#endif
+
+#include <cstdint>
+
+/**
+ * The portable implementation of the bilinear height interpolation.
+ * It returns exactly the same values as RasterBuffer::GetInterpolated().
+ */
+class PortableHeightInterpolation {
+public:
+  gcc_hot
+  static void Interpolate(const int16_t *gcc_restrict a,
+                          const int16_t *gcc_restrict b,
+                          const int16_t *gcc_restrict c,
+                          const int16_t *gcc_restrict d,
+                          const uint16_t *gcc_restrict ix,
+                          const uint16_t *gcc_restrict iy,
+                          TerrainHeight *gcc_restrict dest, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) {
+      if (TerrainHeight(a[i]).IsSpecial() || TerrainHeight(b[i]).IsSpecial() ||
+          TerrainHeight(c[i]).IsSpecial() || TerrainHeight(d[i]).IsSpecial()) {
+        dest[i] = TerrainHeight(a[i]);
+        continue;
+      }
+
+      const unsigned kx = 0x100 - ix[i];
+      const unsigned ky = 0x100 - iy[i];
+
+      dest[i] = TerrainHeight((a[i] * kx * ky
+                               + b[i] * ix[i] * ky
+                               + c[i] * kx * iy[i]
+                               + d[i] * ix[i] * iy[i]) >> 16);
+    }
+  }
+};
+
+/**
+ * Use the SIMD implementation (if available) as much as possible,
+ * and the portable one for the odd remainder.
+ */
+template<typename Optimised, unsigned N>
+struct SelectOptimisedHeightInterpolation {
+  static constexpr unsigned PORTABLE_MASK = N - 1;
+  static constexpr unsigned OPTIMISED_MASK = ~PORTABLE_MASK;
+
+  gcc_flatten
+  static void Interpolate(const int16_t *gcc_restrict a,
+                          const int16_t *gcc_restrict b,
+                          const int16_t *gcc_restrict c,
+                          const int16_t *gcc_restrict d,
+                          const uint16_t *gcc_restrict ix,
+                          const uint16_t *gcc_restrict iy,
+                          TerrainHeight *gcc_restrict dest, unsigned n) {
+    const unsigned no = n & OPTIMISED_MASK;
+
+    Optimised::Interpolate(a, b, c, d, ix, iy, dest, no);
+    PortableHeightInterpolation::Interpolate(a + no, b + no, c + no, d + no,
+                                             ix + no, iy + no, dest + no,
+                                             n & PORTABLE_MASK);
+  }
+};
+
+#ifdef __ARM_NEON__
+using HeightInterpolation =
+  SelectOptimisedHeightInterpolation<NEONHeightInterpolation, 8>;
+#elif defined(__SSE2__)
+using HeightInterpolation =
+  SelectOptimisedHeightInterpolation<SSE2HeightInterpolation, 8>;
+#else
+using HeightInterpolation = PortableHeightInterpolation;
+#endif
+
+#endif
@@ -24,8 +24,11 @@ Copyright_License {
 #include "RasterTileCache.hpp"
 #include "Terrain/RasterLocation.hpp"
 
-#include <stdlib.h>
 #include <algorithm>
+#include <vector>
+
+#include <limits.h>
+#include <stdlib.h>
 
 //#define DEBUG_TILE
 #ifdef DEBUG_TILE
@@ -41,13 +44,70 @@ RasterTileCache::FirstIntersection(const SignedRasterLocation origin,
                                    const int h_safety,
                                    RasterLocation &_location, int &_h,
                                    const bool can_climb) const
+{
+  TileCursor cursor;
+  return FirstIntersection(origin, destination, h_origin, h_dest,
+                           slope_fact, h_ceiling, h_safety,
+                           _location, _h, can_climb, cursor);
+}
+
+template<typename L>
+std::vector<unsigned>
+RasterTileCache::SortByOriginTile(const L *lines, unsigned n) const
+{
+  std::vector<std::pair<unsigned, unsigned>> keys;
+  keys.reserve(n);
+  for (unsigned i = 0; i < n; ++i) {
+    const RasterLocation origin = lines[i].origin;
+    const unsigned tile = IsInside(origin)
+      ? (origin.y / tile_height) * tiles.GetWidth() + origin.x / tile_width
+      : UINT_MAX;
+    keys.emplace_back(tile, i);
+  }
+
+  std::sort(keys.begin(), keys.end());
+
+  std::vector<unsigned> order;
+  order.reserve(n);
+  for (const auto &i : keys)
+    order.push_back(i.second);
+  return order;
+}
+
+void
+RasterTileCache::FirstIntersection(FirstIntersectionLine *lines, unsigned n,
+                                   const int h_ceiling,
+                                   const int h_safety) const
+{
+  TileCursor cursor;
+  for (const unsigned i : SortByOriginTile(lines, n)) {
+    FirstIntersectionLine &line = lines[i];
+    line.intersecting =
+      FirstIntersection(line.origin, line.destination,
+                        line.h_origin, line.h_dest, line.slope_fact,
+                        h_ceiling, h_safety, line.location, line.h,
+                        line.can_climb, cursor);
+  }
+}
+
+bool
+RasterTileCache::FirstIntersection(const SignedRasterLocation origin,
+                                   const SignedRasterLocation destination,
+                                   int h_origin,
+                                   int h_dest,
+                                   const int slope_fact, const int h_ceiling,
+                                   const int h_safety,
+                                   RasterLocation &_location, int &_h,
+                                   const bool can_climb,
+                                   TileCursor &cursor) const
 {
   RasterLocation location = origin;
   if (!IsInside(location))
     // origin is outside overall bounds
     return false;
 
-  const TerrainHeight h_origin2 = GetFieldDirect(origin.x, origin.y).first;
+  const TerrainHeight h_origin2 =
+    GetFieldDirect(origin.x, origin.y, cursor).first;
   if (h_origin2.IsInvalid()) {
     _location = location;
     _h = h_origin;
@@ -115,7 +175,8 @@ RasterTileCache::FirstIntersection(const SignedRasterLocation origin,
       if (!IsInside(location))
         break; // outside bounds
 
-      const auto field_direct = GetFieldDirect(location.x, location.y);
+      const auto field_direct = GetFieldDirect(location.x, location.y,
+                                               cursor);
       if (field_direct.first.IsInvalid())
         break;
 
@@ -225,14 +286,25 @@ RasterTileCache::FirstIntersection(const SignedRasterLocation origin,
 }
 
 inline std::pair<TerrainHeight, bool>
-RasterTileCache::GetFieldDirect(const unsigned px, const unsigned py) const
+RasterTileCache::GetFieldDirect(const unsigned px, const unsigned py,
+                                TileCursor &cursor) const
 {
   assert(px < width);
   assert(py < height);
 
-  const RasterTile &tile = tiles.Get(px / tile_width, py / tile_height);
-  if (tile.IsEnabled())
-    return std::make_pair(tile.GetHeight(px, py), true);
+  if (cursor.tile == nullptr ||
+      /* unsigned wraparound checks both sides of the cell */
+      px - cursor.x >= tile_width || py - cursor.y >= tile_height) {
+    const unsigned column = px / tile_width, row = py / tile_height;
+    cursor.tile = &tiles.Get(column, row);
+    cursor.data = cursor.tile->GetBuffer();
+    cursor.x = column * tile_width;
+    cursor.y = row * tile_height;
+  }
+
+  if (cursor.data != nullptr)
+    return std::make_pair(cursor.tile->GetHeight(*cursor.data, px, py),
+                          true);
 
   // still not found, so go to overview
 
@@ -257,6 +329,32 @@ RasterTileCache::Intersection(const SignedRasterLocation origin,
                               const int h_origin,
                               const int slope_fact,
                               const int height_floor) const
+{
+  TileCursor cursor;
+  return Intersection(origin, destination, h_origin, slope_fact,
+                      height_floor, cursor);
+}
+
+void
+RasterTileCache::Intersection(IntersectionLine *lines, unsigned n,
+                              const int height_floor) const
+{
+  TileCursor cursor;
+  for (const unsigned i : SortByOriginTile(lines, n)) {
+    IntersectionLine &line = lines[i];
+    line.location = Intersection(line.origin, line.destination,
+                                 line.h_origin, line.slope_fact,
+                                 height_floor, cursor);
+  }
+}
+
+SignedRasterLocation
+RasterTileCache::Intersection(const SignedRasterLocation origin,
+                              const SignedRasterLocation destination,
+                              const int h_origin,
+                              const int slope_fact,
+                              const int height_floor,
+                              TileCursor &cursor) const
 {
   SignedRasterLocation location = origin;
 
@@ -304,7 +402,8 @@ RasterTileCache::Intersection(const SignedRasterLocation origin,
       if (!IsInside(location))
         break;
 
-      const auto field_direct = GetFieldDirect(location.x, location.y);
+      const auto field_direct = GetFieldDirect(location.x, location.y,
+                                               cursor);
       if (field_direct.first.IsInvalid())
         break;
 
@@ -323,7 +422,7 @@ RasterTileCache::Intersection(const SignedRasterLocation origin,
 
         // refine solution
         return Intersection(last_clear_location, location,
-                            last_clear_h, slope_fact, height_floor);
+                            last_clear_h, slope_fact, height_floor, cursor);
       }
 
       if (h_int <= 0)
@@ -28,6 +28,9 @@ Copyright_License {
 #include "WorldFile.hpp"
 #include "Operation/Operation.hpp"
 #include "OS/ConvertPathName.hpp"
+#include "Thread/ThreadPool.hpp"
+#include "Util/StaticArray.hxx"
+#include "Util/AllocatedArray.hxx"
 
 extern "C" {
 #include "jasper/jp2/jp2_cod.h"
@@ -35,8 +38,66 @@ extern "C" {
 #include "jasper/jpc/jpc_t1cod.h"
 }
 
+#include <algorithm>
+
 #include <string.h>
 
+/**
+ * FileMapping refuses to map files larger than this.
+ */
+static constexpr uint64_t MAX_RAW_FILE_SIZE = 1024 * 1024 * 1024;
+
+struct RawTerrainWriter {
+  static constexpr uint64_t NO_TILE = ~uint64_t(0);
+
+  FILE *const file;
+
+  /**
+   * The file position of the first tile.
+   */
+  uint64_t base;
+
+  /**
+   * The position of each tile relative to #base; #NO_TILE if the
+   * tile is undefined or has already been written.
+   */
+  AllocatedArray<uint64_t> offsets;
+
+  /**
+   * The number of tiles which have not been written yet.
+   */
+  unsigned remaining = 0;
+
+  /**
+   * The total number of tiles to be written.
+   */
+  unsigned total = 0;
+
+  bool error = false;
+
+  explicit RawTerrainWriter(FILE *_file):file(_file) {}
+
+  bool IsPending(unsigned index) const {
+    return index < offsets.size() && offsets[index] != NO_TILE;
+  }
+};
+
+inline bool
+TerrainLoader::IsTileRequested(unsigned index) const
+{
+  if (raw_writer != nullptr)
+    return raw_writer->IsPending(index);
+
+  const auto &tile = raster_tile_cache.tiles.GetLinear(index);
+  if (!tile.IsRequested() || tile.IsEnabled())
+    /* not requested, or already loaded from the disk cache */
+    return false;
+
+  return tile_filter.IsNull() ||
+    std::find(tile_filter.begin(), tile_filter.end(),
+              index) != tile_filter.end();
+}
+
 long
 TerrainLoader::SkipMarkerSegment(long file_offset) const
 {
@@ -56,8 +117,7 @@ TerrainLoader::SkipMarkerSegment(long file_offset) const
     return 0;
 
   long skip_to = segment->file_offset;
-  while (segment->IsTileSegment() &&
-         !raster_tile_cache.tiles.GetLinear(segment->tile).IsRequested()) {
+  while (segment->IsTileSegment() && !IsTileRequested(segment->tile)) {
     ++segment;
     if (segment >= raster_tile_cache.segments.end())
       /* last segment is hidden; shouldn't happen either, because we
@@ -174,14 +234,51 @@ TerrainLoader::PutTileData(unsigned index,
                            unsigned end_x, unsigned end_y,
                            const struct jas_matrix &m)
 {
+  if (raw_writer != nullptr) {
+    WriteRawTile(index, m);
+    return;
+  }
+
   if (scan_overview)
     raster_tile_cache.PutOverviewTile(index, start_x, start_y,
                                       end_x, end_y, m);
 
   if (scan_tiles) {
-    const std::lock_guard<SharedMutex> lock(mutex);
-    raster_tile_cache.PutTileData(index, m);
+    /* convert into a new buffer, and then publish it with an
+       atomic pointer swap; readers are never blocked */
+    RasterBuffer buffer;
+    if (!raster_tile_cache.ConvertTileData(index, m, buffer))
+      return;
+
+    raster_tile_cache.disk_cache.Store(index, buffer);
+    raster_tile_cache.PutTileData(index, std::move(buffer));
+  }
+}
+
+inline void
+TerrainLoader::WriteRawTile(unsigned index, const struct jas_matrix &m)
+{
+  auto &writer = *raw_writer;
+  if (!writer.IsPending(index))
+    return;
+
+  RasterBuffer buffer;
+  if (!raster_tile_cache.tiles.GetLinear(index).ConvertFrom(m, buffer))
+    return;
+
+  const size_t size = size_t(buffer.GetWidth()) * buffer.GetHeight()
+    * sizeof(*buffer.GetData());
+  if (fseek(writer.file, writer.base + writer.offsets[index],
+            SEEK_SET) != 0 ||
+      fwrite(buffer.GetData(), 1, size, writer.file) != size) {
+    writer.error = true;
+    return;
   }
+
+  writer.offsets[index] = RawTerrainWriter::NO_TILE;
+  --writer.remaining;
+
+  env.SetProgressPosition(writer.total - writer.remaining);
 }
 
 static bool
@@ -229,8 +326,6 @@ LoadJPG2000(jas_stream_t *in, void *loader)
   /* allow really large maps, but specify a reasonable limit */
   opts.max_samples = size_t(1) << 31;
 
-  jpc_initluts();
-
   const auto dec = jpc_dec_create(&opts, in);
   if (dec == nullptr)
     return false;
@@ -245,11 +340,15 @@ LoadJPG2000(jas_stream_t *in, void *loader)
 inline bool
 TerrainLoader::LoadJPG2000(struct zzip_dir *dir, const char *path)
 {
-  const auto in = OpenJasperZzipStream(dir, path);
+  const auto in = io_mutex != nullptr
+    ? OpenJasperZzipStream(dir, path, *io_mutex)
+    : OpenJasperZzipStream(dir, path);
   if (in == nullptr)
     return false;
 
-  env.SetProgressRange(jas_stream_length(in) / 65536);
+  if (raw_writer == nullptr)
+    /* ConvertTiles() reports progress per tile */
+    env.SetProgressRange(jas_stream_length(in) / 65536);
 
   bool success = ::LoadJPG2000(in, this);
   jas_stream_close(in);
@@ -279,6 +378,8 @@ TerrainLoader::LoadOverview(struct zzip_dir *dir,
 
   raster_tile_cache.Reset();
 
+  jpc_initluts();
+
   bool success = LoadJPG2000(dir, path);
 
   /* if we loaded the JPG2000 file successfully, but no bounds were
@@ -302,16 +403,78 @@ LoadTerrainOverview(struct zzip_dir *dir,
                     bool all,
                     OperationEnvironment &env)
 {
-  /* fake a mutex - we don't need it for LoadTerrainOverview() */
-  SharedMutex mutex;
-
-  TerrainLoader loader(mutex, raster_tile_cache, true, all, env);
+  TerrainLoader loader(raster_tile_cache, true, all, env);
   return loader.LoadOverview(dir, path, world_file);
 }
 
+inline bool
+TerrainLoader::LoadTilesParallel(struct zzip_dir *dir, const char *path,
+                                 ThreadPool &pool)
+{
+  using TileList = StaticArray<uint16_t, RasterTileCache::MAX_ACTIVATE>;
+
+  TileList requested;
+  raster_tile_cache.ForEachRequestedTile([&requested](unsigned i){
+      requested.checked_append(i);
+    });
+
+  const unsigned n_threads = std::min(pool.GetConcurrency(),
+                                      unsigned(requested.size()));
+  if (n_threads < 2)
+    return LoadJPG2000(dir, path);
+
+  /* sort by file position and deal the tiles round-robin, so each
+     thread gets about the same amount of work */
+  std::sort(requested.begin(), requested.end());
+
+  StaticArray<TileList, RasterTileCache::MAX_ACTIVATE> lists;
+  lists.resize(n_threads);
+  for (unsigned i = 0; i < requested.size(); ++i)
+    lists[i % n_threads].append(requested[i]);
+
+  /* zziplib is not thread-safe; serialize all I/O with this mutex,
+     while the (expensive) decoding runs in parallel */
+  Mutex zip_mutex;
+
+  StaticArray<bool, RasterTileCache::MAX_ACTIVATE> results;
+  results.resize(n_threads);
+
+  pool.Run(n_threads, [&](unsigned i){
+      TerrainLoader loader(raster_tile_cache, false, true, env);
+      loader.tile_filter = {lists[i].begin(), lists[i].size()};
+      loader.io_mutex = &zip_mutex;
+      results[i] = loader.LoadJPG2000(dir, path);
+    });
+
+  return std::all_of(results.begin(), results.end(),
+                     [](bool b){ return b; });
+}
+
+inline bool
+TerrainLoader::LoadFromDiskCache()
+{
+  auto &disk_cache = raster_tile_cache.disk_cache;
+  if (!disk_cache.IsOpen())
+    return true;
+
+  bool need_decode = false;
+  raster_tile_cache.ForEachRequestedTile([&](unsigned i){
+      RasterBuffer buffer;
+      if (!disk_cache.Load(i, buffer)) {
+        need_decode = true;
+        return;
+      }
+
+      raster_tile_cache.PutTileData(i, std::move(buffer));
+    });
+
+  return need_decode;
+}
+
 inline bool
 TerrainLoader::UpdateTiles(struct zzip_dir *dir, const char *path,
-                           int x, int y, unsigned radius)
+                           int x, int y, unsigned radius,
+                           ThreadPool *pool)
 {
   assert(!scan_overview);
 
@@ -319,33 +482,96 @@ TerrainLoader::UpdateTiles(struct zzip_dir *dir, const char *path,
     /* nothing to do */
     return true;
 
-  bool success = LoadJPG2000(dir, path);
+  if (!LoadFromDiskCache()) {
+    /* all tiles were found in the disk cache */
+    raster_tile_cache.FinishTileUpdate();
+    return true;
+  }
+
+  jpc_initluts();
+
+  bool success = pool != nullptr && pool->GetConcurrency() > 1
+    ? LoadTilesParallel(dir, path, *pool)
+    : LoadJPG2000(dir, path);
   raster_tile_cache.FinishTileUpdate();
   return success;
 }
 
+inline bool
+TerrainLoader::ConvertTiles(struct zzip_dir *dir, const char *path,
+                            FILE *file)
+{
+  assert(!scan_overview);
+
+  const auto header = raster_tile_cache.MakeRawHeader();
+  if (fwrite(&header, sizeof(header), 1, file) != 1)
+    return false;
+
+  RawTerrainWriter writer(file);
+  writer.base = ftell(file);
+  writer.offsets.ResizeDiscard(raster_tile_cache.tiles.GetSize());
+  std::fill(writer.offsets.begin(), writer.offsets.end(),
+            RawTerrainWriter::NO_TILE);
+
+  const uint64_t size =
+    raster_tile_cache.ForEachRawTile([&writer](unsigned i, uint64_t offset){
+        writer.offsets[i] = offset;
+        ++writer.remaining;
+      });
+  if (writer.base + size > MAX_RAW_FILE_SIZE)
+    return false;
+
+  writer.total = writer.remaining;
+  env.SetProgressRange(writer.total);
+  env.SetProgressPosition(0);
+
+  jpc_initluts();
+
+  raw_writer = &writer;
+  bool success = LoadJPG2000(dir, path);
+  raw_writer = nullptr;
+
+  return success && !writer.error && writer.remaining == 0 &&
+    fflush(file) == 0;
+}
+
+bool
+ConvertTerrainTiles(struct zzip_dir *dir, const char *path,
+                    RasterTileCache &raster_tile_cache, FILE *file,
+                    OperationEnvironment &env)
+{
+  if (!raster_tile_cache.IsValid())
+    return false;
+
+  TerrainLoader loader(raster_tile_cache, false, true, env);
+  return loader.ConvertTiles(dir, path, file);
+}
+
 bool
 UpdateTerrainTiles(struct zzip_dir *dir, const char *path,
-                   RasterTileCache &raster_tile_cache, SharedMutex &mutex,
-                   int x, int y, unsigned radius)
+                   RasterTileCache &raster_tile_cache,
+                   int x, int y, unsigned radius,
+                   ThreadPool *pool)
 {
   if (!raster_tile_cache.IsValid())
     return false;
 
   NullOperationEnvironment env;
-  TerrainLoader loader(mutex, raster_tile_cache, false, true, env);
-  return loader.UpdateTiles(dir, path, x, y, radius);
+  TerrainLoader loader(raster_tile_cache, false, true, env);
+  return loader.UpdateTiles(dir, path, x, y, radius, pool);
 }
 
 bool
 UpdateTerrainTiles(struct zzip_dir *dir, const char *path,
-                   RasterTileCache &raster_tile_cache, SharedMutex &mutex,
+                   RasterTileCache &raster_tile_cache,
                    const RasterProjection &projection,
-                   const GeoPoint &location, double radius)
+                   const GeoPoint &location, double radius,
+                   ThreadPool *pool)
 {
   const auto raster_location = projection.ProjectCoarse(location);
 
-  return UpdateTerrainTiles(dir, path, raster_tile_cache, mutex,
+  return UpdateTerrainTiles(dir, path, raster_tile_cache,
                             raster_location.x, raster_location.y,
-                            projection.DistancePixelsCoarse(radius));
+                            projection.DistancePixelsCoarse(radius),
+                            pool);
 }
@@ -24,41 +24,79 @@ Copyright_License {
 #ifndef XCSOAR_TERRAIN_LOADER_HPP
 #define XCSOAR_TERRAIN_LOADER_HPP
 
-#include "Thread/SharedMutex.hpp"
+#include "Thread/Mutex.hxx"
+#include "Util/ConstBuffer.hxx"
+#include "Util/Compiler.h"
+
+#include <cstdint>
+
+#include <stdio.h>
 
 struct zzip_dir;
 struct GeoPoint;
 class RasterTileCache;
 class RasterProjection;
 class OperationEnvironment;
+class ThreadPool;
+struct RawTerrainWriter;
 
 class TerrainLoader {
-  SharedMutex &mutex;
-
   RasterTileCache &raster_tile_cache;
 
   const bool scan_overview, scan_tiles;
 
   OperationEnvironment &env;
 
+  /**
+   * If this is not nullptr, then only these tiles are decoded by
+   * this loader.  This is used to distribute the requested tiles
+   * over several threads, each one with its own loader.
+   */
+  ConstBuffer<uint16_t> tile_filter = nullptr;
+
+  /**
+   * If this is not nullptr, then all accesses to the ZIP file are
+   * serialized with this mutex, because zziplib is not thread-safe.
+   */
+  Mutex *io_mutex = nullptr;
+
+  /**
+   * If this is not nullptr, then all tiles are decoded and written
+   * to a raw terrain file instead of being loaded into the
+   * #RasterTileCache.
+   */
+  RawTerrainWriter *raw_writer = nullptr;
+
   /**
    * The number of remaining segments after the current one.
    */
   mutable unsigned remaining_segments = 0;
 
 public:
-  TerrainLoader(SharedMutex &_mutex, RasterTileCache &_rtc,
+  TerrainLoader(RasterTileCache &_rtc,
                 bool _scan_overview, bool _scan_all,
                 OperationEnvironment &_env)
-    :mutex(_mutex), raster_tile_cache(_rtc),
+    :raster_tile_cache(_rtc),
      scan_overview(_scan_overview),
      scan_tiles(!_scan_overview || _scan_all),
      env(_env) {}
 
   bool LoadOverview(struct zzip_dir *dir,
                     const char *path, const char *world_file);
+
+  /**
+   * @param pool an optional #ThreadPool which is used to decode the
+   * requested tiles in parallel
+   */
   bool UpdateTiles(struct zzip_dir *dir, const char *path,
-                   int x, int y, unsigned radius);
+                   int x, int y, unsigned radius,
+                   ThreadPool *pool=nullptr);
+
+  /**
+   * Decode all tiles and write them to the given file; see
+   * ConvertTerrainTiles().
+   */
+  bool ConvertTiles(struct zzip_dir *dir, const char *path, FILE *file);
 
   /* callback methods for libjasper (via jas_rtc.cpp) */
 
@@ -79,7 +117,30 @@ public:
                    const struct jas_matrix &m);
 
 private:
+  gcc_pure
+  bool IsTileRequested(unsigned index) const;
+
   bool LoadJPG2000(struct zzip_dir *dir, const char *path);
+
+  /**
+   * Load the requested tiles which are available in the tile disk
+   * cache.
+   *
+   * @return true if there are still requested tiles which need to
+   * be decoded
+   */
+  bool LoadFromDiskCache();
+
+  /**
+   * Decode the requested tiles with all threads of the given pool.
+   * Each thread parses the JPEG2000 file on its own and skips all
+   * tiles which were assigned to other threads.
+   */
+  bool LoadTilesParallel(struct zzip_dir *dir, const char *path,
+                         ThreadPool &pool);
+
+  void WriteRawTile(unsigned index, const struct jas_matrix &m);
+
   void ParseBounds(const char *data);
 };
 
@@ -106,32 +167,60 @@ LoadTerrainOverview(struct zzip_dir *dir,
 
 bool
 UpdateTerrainTiles(struct zzip_dir *dir, const char *path,
-                   RasterTileCache &raster_tile_cache, SharedMutex &mutex,
-                   int x, int y, unsigned radius);
+                   RasterTileCache &raster_tile_cache,
+                   int x, int y, unsigned radius,
+                   ThreadPool *pool=nullptr);
 
 static inline bool
 UpdateTerrainTiles(struct zzip_dir *dir,
-                   RasterTileCache &tile_cache, SharedMutex &mutex,
+                   RasterTileCache &tile_cache,
                    int x, int y, unsigned radius)
 {
-  return UpdateTerrainTiles(dir, "terrain.jp2", tile_cache, mutex,
+  return UpdateTerrainTiles(dir, "terrain.jp2", tile_cache,
                             x, y, radius);
 }
 
 bool
 UpdateTerrainTiles(struct zzip_dir *dir, const char *path,
-                   RasterTileCache &raster_tile_cache, SharedMutex &mutex,
+                   RasterTileCache &raster_tile_cache,
                    const RasterProjection &projection,
-                   const GeoPoint &location, double radius);
+                   const GeoPoint &location, double radius,
+                   ThreadPool *pool=nullptr);
 
 static inline bool
 UpdateTerrainTiles(struct zzip_dir *dir,
-                   RasterTileCache &tile_cache, SharedMutex &mutex,
+                   RasterTileCache &tile_cache,
                    const RasterProjection &projection,
-                   const GeoPoint &location, double radius)
+                   const GeoPoint &location, double radius,
+                   ThreadPool *pool=nullptr)
+{
+  return UpdateTerrainTiles(dir, "terrain.jp2", tile_cache,
+                            projection, location, radius, pool);
+}
+
+/**
+ * Decode all tiles of the JPEG2000 file and write them to a "raw"
+ * terrain file: a #RasterTileCache::RawHeader followed by the
+ * uncompressed tiles.  The file can later be mapped with
+ * RasterTileCache::OpenRawFile().  The overview must have been
+ * loaded already.
+ *
+ * @param file the destination file; the data is written starting
+ * at the current position
+ * @return false on error, or if the terrain is too large to be
+ * mapped into memory
+ */
+bool
+ConvertTerrainTiles(struct zzip_dir *dir, const char *path,
+                    RasterTileCache &raster_tile_cache, FILE *file,
+                    OperationEnvironment &env);
+
+static inline bool
+ConvertTerrainTiles(struct zzip_dir *dir,
+                    RasterTileCache &tile_cache, FILE *file,
+                    OperationEnvironment &env)
 {
-  return UpdateTerrainTiles(dir, "terrain.jp2", tile_cache, mutex,
-                            projection, location, radius);
+  return ConvertTerrainTiles(dir, "terrain.jp2", tile_cache, file, env);
 }
 
 #endif
@@ -0,0 +1,125 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_TERRAIN_NEON_HPP
+#define XCSOAR_TERRAIN_NEON_HPP
+
+#include "Height.hpp"
+#include "Util/Compiler.h"
+
+#ifndef __ARM_NEON__
+#error ARM NEON required
+#endif
+
+#include <arm_neon.h>
+
+#include <cstdint>
+
+/**
+ * Implementation of the bilinear height interpolation using ARM NEON
+ * instructions.  It processes 8 samples at a time.
+ */
+class NEONHeightInterpolation {
+  /**
+   * Calculate "r0 * w0 + r1 * w1" for 4 lanes of 32 bit integers.
+   */
+  gcc_always_inline
+  static int32x4_t MultiplyAdd(int32x4_t r0, int32x4_t r1,
+                               int16x4_t w0, int16x4_t w1) {
+    return vmlaq_s32(vmulq_s32(r0, vmovl_s16(w0)), r1, vmovl_s16(w1));
+  }
+
+  /**
+   * Calculate "v0 * w0 + v1 * w1" for 4 lanes of 16 bit integers,
+   * widening the result to 32 bit.
+   */
+  gcc_always_inline
+  static int32x4_t MultiplyAdd(int16x4_t v0, int16x4_t v1,
+                               int16x4_t w0, int16x4_t w1) {
+    return vmlal_s16(vmull_s16(v0, w0), v1, w1);
+  }
+
+public:
+  /**
+   * Interpolate 8 samples.  See SSE2HeightInterpolation::Interpolate8().
+   */
+  gcc_hot gcc_always_inline
+  static void Interpolate8(const int16_t *gcc_restrict a,
+                           const int16_t *gcc_restrict b,
+                           const int16_t *gcc_restrict c,
+                           const int16_t *gcc_restrict d,
+                           const uint16_t *gcc_restrict ix,
+                           const uint16_t *gcc_restrict iy,
+                           TerrainHeight *gcc_restrict dest) {
+    const int16x8_t va = vld1q_s16(a), vb = vld1q_s16(b);
+    const int16x8_t vc = vld1q_s16(c), vd = vld1q_s16(d);
+
+    const int16x8_t v256 = vdupq_n_s16(0x100);
+    const int16x8_t vix = vreinterpretq_s16_u16(vld1q_u16(ix));
+    const int16x8_t viy = vreinterpretq_s16_u16(vld1q_u16(iy));
+    const int16x8_t vkx = vsubq_s16(v256, vix);
+    const int16x8_t vky = vsubq_s16(v256, viy);
+
+    /* horizontal pass */
+    const int32x4_t row0_lo = MultiplyAdd(vget_low_s16(va), vget_low_s16(vb),
+                                          vget_low_s16(vkx), vget_low_s16(vix));
+    const int32x4_t row0_hi = MultiplyAdd(vget_high_s16(va), vget_high_s16(vb),
+                                          vget_high_s16(vkx), vget_high_s16(vix));
+    const int32x4_t row1_lo = MultiplyAdd(vget_low_s16(vc), vget_low_s16(vd),
+                                          vget_low_s16(vkx), vget_low_s16(vix));
+    const int32x4_t row1_hi = MultiplyAdd(vget_high_s16(vc), vget_high_s16(vd),
+                                          vget_high_s16(vkx), vget_high_s16(vix));
+
+    /* vertical pass */
+    const int32x4_t sum_lo = MultiplyAdd(row0_lo, row1_lo,
+                                         vget_low_s16(vky), vget_low_s16(viy));
+    const int32x4_t sum_hi = MultiplyAdd(row0_hi, row1_hi,
+                                         vget_high_s16(vky), vget_high_s16(viy));
+
+    const int16x8_t result = vcombine_s16(vshrn_n_s32(sum_lo, 16),
+                                          vshrn_n_s32(sum_hi, 16));
+
+    /* if one of the neighbours is "special", use the top left one
+       without interpolation */
+    const int16x8_t threshold = vdupq_n_s16(-30000);
+    const uint16x8_t special =
+      vorrq_u16(vorrq_u16(vcleq_s16(va, threshold), vcleq_s16(vb, threshold)),
+                vorrq_u16(vcleq_s16(vc, threshold), vcleq_s16(vd, threshold)));
+
+    vst1q_s16((int16_t *)dest, vbslq_s16(special, va, result));
+  }
+
+  gcc_hot gcc_flatten
+  static void Interpolate(const int16_t *gcc_restrict a,
+                          const int16_t *gcc_restrict b,
+                          const int16_t *gcc_restrict c,
+                          const int16_t *gcc_restrict d,
+                          const uint16_t *gcc_restrict ix,
+                          const uint16_t *gcc_restrict iy,
+                          TerrainHeight *gcc_restrict dest, unsigned n) {
+    for (unsigned i = 0; i < n; i += 8)
+      Interpolate8(a + i, b + i, c + i, d + i, ix + i, iy + i, dest + i);
+  }
+};
+
+#endif
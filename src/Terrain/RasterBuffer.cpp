@@ -22,18 +22,29 @@ Copyright_License {
 */
 
 #include "Terrain/RasterBuffer.hpp"
+#include "Terrain/RasterLocation.hpp"
+#include "Terrain/Interpolate.hpp"
 #include "Math/FastMath.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <stdlib.h>
 
+/**
+ * The number of samples which are collected on the stack and then
+ * passed to the (SIMD) interpolation kernel.
+ */
+static constexpr unsigned INTERPOLATE_CHUNK = 64;
+
 void
 RasterBuffer::Resize(unsigned _width, unsigned _height)
 {
   assert(_width > 0 && _height > 0);
 
-  data.GrowDiscard(_width, _height);
+  storage.GrowDiscard(_width * _height);
+  data = storage.begin();
+  width = _width;
+  height = _height;
 }
 
 TerrainHeight
@@ -80,6 +91,44 @@ RasterBuffer::GetInterpolated(unsigned lx, unsigned ly) const
   return GetInterpolated(lx, ly, ix, iy);
 }
 
+void
+RasterBuffer::GetInterpolated(const RasterLocation *gcc_restrict locations,
+                              TerrainHeight *gcc_restrict dest,
+                              unsigned n) const
+{
+  assert(IsDefined());
+
+  alignas(16) int16_t a[INTERPOLATE_CHUNK], b[INTERPOLATE_CHUNK];
+  alignas(16) int16_t c[INTERPOLATE_CHUNK], d[INTERPOLATE_CHUNK];
+  alignas(16) uint16_t ix[INTERPOLATE_CHUNK], iy[INTERPOLATE_CHUNK];
+
+  while (n > 0) {
+    const unsigned chunk = std::min(n, INTERPOLATE_CHUNK);
+
+    /* gather the four neighbours of each sample */
+    for (unsigned i = 0; i < chunk; ++i) {
+      unsigned lx = locations[i].x, ly = locations[i].y;
+      ix[i] = CombinedDivAndMod(lx);
+      iy[i] = CombinedDivAndMod(ly);
+
+      const unsigned int dx = (lx == GetWidth() - 1) ? 0 : 1;
+      const unsigned int dy = (ly == GetHeight() - 1) ? 0 : GetWidth();
+      const TerrainHeight *tm = GetDataAt(lx, ly);
+
+      a[i] = tm->GetValue();
+      b[i] = tm[dx].GetValue();
+      c[i] = tm[dy].GetValue();
+      d[i] = tm[dx + dy].GetValue();
+    }
+
+    HeightInterpolation::Interpolate(a, b, c, d, ix, iy, dest, chunk);
+
+    locations += chunk;
+    dest += chunk;
+    n -= chunk;
+  }
+}
+
 /**
  * This class implements an algorithm to traverse pixels quickly with
  * only integer addition, no multiplication and division.
@@ -143,15 +192,16 @@ RasterBuffer::ScanHorizontalLine(unsigned ax, unsigned bx, unsigned y,
       (unsigned)abs(dx) < (2 * size << RasterTraits::SUBPIXEL_BITS)) {
     /* interpolate */
 
-    unsigned cy = y;
-    const unsigned int iy = CombinedDivAndMod(cy);
+    RasterLocation locations[INTERPOLATE_CHUNK];
 
     --size;
-    for (int i = 0; (unsigned)i <= size; ++i) {
-      unsigned cx = ax + (i * dx) / (int)size;
-      const unsigned int ix = CombinedDivAndMod(cx);
+    for (int i = 0; (unsigned)i <= size;) {
+      const unsigned chunk = std::min(size + 1 - i, INTERPOLATE_CHUNK);
+      for (unsigned j = 0; j < chunk; ++j, ++i)
+        locations[j] = RasterLocation(ax + (i * dx) / (int)size, y);
 
-      *buffer++ = GetInterpolated(cx, cy, ix, iy);
+      GetInterpolated(locations, buffer, chunk);
+      buffer += chunk;
     }
   } else if (gcc_likely(dx > 0)) {
     /* no interpolation needed, forward scan */
@@ -216,14 +266,16 @@ RasterBuffer::ScanLine(unsigned ax, unsigned ay, unsigned bx, unsigned by,
       (unsigned)(abs(dx) + abs(dy)) < (2 * size << RasterTraits::SUBPIXEL_BITS)) {
     /* interpolate */
 
-    for (int i = 0; (unsigned)i <= size; ++i) {
-      unsigned cx = ax + (i * dx) / (int)size;
-      unsigned cy = ay + (i * dy) / (int)size;
+    RasterLocation locations[INTERPOLATE_CHUNK];
 
-      const unsigned int ix = CombinedDivAndMod(cx);
-      const unsigned int iy = CombinedDivAndMod(cy);
+    for (int i = 0; (unsigned)i <= size;) {
+      const unsigned chunk = std::min(size + 1 - i, INTERPOLATE_CHUNK);
+      for (unsigned j = 0; j < chunk; ++j, ++i)
+        locations[j] = RasterLocation(ax + (i * dx) / (int)size,
+                                      ay + (i * dy) / (int)size);
 
-      *buffer++ = GetInterpolated(cx, cy, ix, iy);
+      GetInterpolated(locations, buffer, chunk);
+      buffer += chunk;
     }
   } else {
     /* no interpolation needed */
@@ -263,7 +315,7 @@ TerrainHeight
 RasterBuffer::GetMaximum() const
 {
   return IsDefined()
-    ? *std::max_element(data.begin(), data.end(),
+    ? *std::max_element(data, data + width * height,
                         [](TerrainHeight a, TerrainHeight b) {
                           return a.GetValue() < b.GetValue();
                         })
@@ -26,32 +26,68 @@ Copyright_License {
 
 #include "RasterTraits.hpp"
 #include "Height.hpp"
-#include "Util/AllocatedGrid.hxx"
+#include "Util/AllocatedArray.hxx"
 #include "Util/Compiler.h"
 
+#include <utility>
+#include <cassert>
 #include <cstdint>
 
+struct RasterLocation;
+
 class RasterBuffer {
-  AllocatedGrid<TerrainHeight> data;
+  /**
+   * The memory owned by this object.  It is empty if #data points
+   * to external memory (see SetExternal()).
+   */
+  AllocatedArray<TerrainHeight> storage;
+
+  /**
+   * Points to the first value, either inside #storage or inside
+   * external memory which is owned by somebody else.
+   */
+  const TerrainHeight *data = nullptr;
+
+  unsigned width = 0, height = 0;
 
 public:
   RasterBuffer() = default;
   RasterBuffer(unsigned _width, unsigned _height)
-    :data(_width, _height) {}
-
-  RasterBuffer(const RasterBuffer &) = delete;
-  RasterBuffer &operator=(const RasterBuffer &) = delete;
+    :storage(_width * _height), data(storage.begin()),
+     width(_width), height(_height) {}
+
+  RasterBuffer(RasterBuffer &&src)
+    :storage(std::move(src.storage)),
+     data(std::exchange(src.data, nullptr)),
+     width(std::exchange(src.width, 0)),
+     height(std::exchange(src.height, 0)) {}
+
+  RasterBuffer &operator=(RasterBuffer &&src) {
+    using std::swap;
+    storage = std::move(src.storage);
+    swap(data, src.data);
+    swap(width, src.width);
+    swap(height, src.height);
+    return *this;
+  }
 
   bool IsDefined() const {
-    return data.IsDefined();
+    return data != nullptr;
+  }
+
+  /**
+   * Does this object refer to memory it does not own?
+   */
+  bool IsExternal() const {
+    return data != nullptr && data != storage.begin();
   }
 
   unsigned GetWidth() const {
-    return data.GetWidth();
+    return width;
   }
 
   unsigned GetHeight() const {
-    return data.GetHeight();
+    return height;
   }
 
   unsigned GetFineWidth() const {
@@ -63,23 +99,46 @@ public:
   }
 
   TerrainHeight *GetData() {
-    return data.begin();
+    assert(!IsExternal());
+
+    return storage.begin();
   }
 
   const TerrainHeight *GetData() const {
-    return data.begin();
+    return data;
   }
 
   const TerrainHeight *GetDataAt(unsigned x, unsigned y) const {
-    return data.GetPointerAt(x, y);
+    assert(x < width);
+    assert(y < height);
+
+    return data + y * width + x;
   }
 
   void Reset() {
-    data.Reset();
+    storage.ResizeDiscard(0);
+    data = nullptr;
+    width = height = 0;
   }
 
   void Resize(unsigned _width, unsigned _height);
 
+  /**
+   * Let this object refer to memory owned by somebody else, e.g. a
+   * memory-mapped file.  The memory must be valid until Reset() is
+   * called.
+   */
+  void SetExternal(const TerrainHeight *_data,
+                   unsigned _width, unsigned _height) {
+    assert(_data != nullptr);
+    assert(_width > 0 && _height > 0);
+
+    storage.ResizeDiscard(0);
+    data = _data;
+    width = _width;
+    height = _height;
+  }
+
   gcc_pure
   TerrainHeight GetInterpolated(unsigned lx, unsigned ly,
                                 unsigned ix, unsigned iy) const;
@@ -87,6 +146,16 @@ public:
   gcc_pure
   TerrainHeight GetInterpolated(unsigned lx, unsigned ly) const;
 
+  /**
+   * Batch version of GetInterpolated(), which calculates several
+   * samples at a time with SIMD instructions (if available).
+   *
+   * @param locations the sub-pixel locations; all of them must be
+   * inside the buffer
+   */
+  void GetInterpolated(const RasterLocation *locations,
+                       TerrainHeight *dest, unsigned n) const;
+
   gcc_pure
   TerrainHeight Get(unsigned x, unsigned y) const {
     return *GetDataAt(x, y);
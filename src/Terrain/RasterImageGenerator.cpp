@@ -0,0 +1,512 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+#include "Terrain/RasterImageGenerator.hpp"
+#include "Terrain/HeightMatrix.hpp"
+#include "Thread/ThreadPool.hpp"
+#include "Math/Angle.hpp"
+#include "Math/FastMath.hpp"
+#include "Util/Clamp.hpp"
+#include "Screen/Ramp.hpp"
+#include "Screen/RawBitmap.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include <math.h>
+
+/**
+ * The contour state of a column below a "special" cell (water or
+ * outside of the map).  It never draws a contour line, therefore
+ * there is no contour line along the border of water.
+ */
+static constexpr unsigned char NO_CONTOUR = 0xff;
+
+/**
+ * Interpolate between x and y with i/128, i.e. i/(1 << 7).
+ *
+ * i must be below or equal to 128.
+ */
+constexpr
+static inline unsigned
+MIX(unsigned x, unsigned y, unsigned i)
+{
+  return (x * i + y * ((1 << 7) - i)) >> 7;
+}
+
+/**
+ * Shade the given color according to the illumination value.
+ *
+ * illum = 64: Contour, mixed with 50% brown
+ * illum < 0:  Shadow, mixed with up to 50% dark blue
+ * illum > 0:  Highlight, mixed with up to 25% yellow
+ * illum = 0:  No shading
+ */
+gcc_const
+inline RawColor
+TerrainShading(const int illum, RGB8Color color)
+{
+  if (illum == -64) {
+    // brown color mixed in for contours
+    return RawColor(MIX(100, color.Red(), 64),
+                    MIX(70, color.Green(), 64),
+                    MIX(26, color.Blue(), 64));
+  } else if (illum < 0) {
+    // shadow to blue
+    int x = std::min(63, -illum);
+    return RawColor(MIX(0, color.Red(), x),
+                    MIX(0, color.Green(), x),
+                    MIX(64, color.Blue(), x));
+  } else if (illum > 0) {
+    // highlight to yellow
+    int x = std::min(32, illum / 2);
+    return RawColor(MIX(255, color.Red(), x),
+                    MIX(255, color.Green(), x),
+                    MIX(16, color.Blue(), x));
+  } else
+    return RawColor(color.Red(), color.Green(), color.Blue());
+}
+
+gcc_const
+static unsigned
+ContourInterval(const unsigned h, const unsigned contour_height_scale)
+{
+  return std::min(254u, h >> contour_height_scale);
+}
+
+gcc_const
+static unsigned
+ContourInterval(const TerrainHeight h, const unsigned contour_height_scale)
+{
+  if (gcc_unlikely(h.IsSpecial()) || h.GetValue() <= 0)
+    return 0;
+
+  return ContourInterval(h.GetValue(), contour_height_scale);
+}
+
+/**
+ * Does this cell need a contour pixel, i.e. has its contour interval
+ * changed from the cell to the left or from the cell above?
+ */
+gcc_const
+static inline bool
+IsContour(unsigned contour_interval, unsigned row_base,
+          unsigned char column_base)
+{
+  return contour_interval != row_base ||
+    (contour_interval != column_base && column_base != NO_CONTOUR);
+}
+
+RasterImageGenerator::~RasterImageGenerator()
+{
+  delete[] color_table;
+}
+
+inline RawColor *
+RasterImageGenerator::GetDestRow(unsigned y) const
+{
+  return dest + int(y) * dest_pitch;
+}
+
+void
+RasterImageGenerator::Generate(const HeightMatrix &_height_matrix,
+                               RawColor *_dest, int _dest_pitch,
+                               ThreadPool &_pool, unsigned _n_bands,
+                               unsigned _quantisation_effective,
+                               double _pixel_size,
+                               bool do_shading,
+                               unsigned height_scale,
+                               int contrast, int brightness,
+                               const Angle sunazimuth,
+                               bool do_contour)
+{
+  assert(color_table != nullptr);
+  assert(_n_bands > 0);
+
+  height_matrix = &_height_matrix;
+  dest = _dest;
+  dest_pitch = _dest_pitch;
+  pool = &_pool;
+  n_bands = std::min(_n_bands, height_matrix->GetHeight());
+  quantisation_effective = _quantisation_effective;
+  pixel_size = _pixel_size;
+
+  if (n_bands == 0)
+    return;
+
+  contour_column_base.GrowDiscard(height_matrix->GetWidth() * n_bands);
+
+  if (quantisation_effective == 0) {
+    do_shading = false;
+    do_contour = false;
+  }
+
+  const unsigned contour_height_scale = do_contour? height_scale * 2 : 16;
+
+  if (do_shading)
+    GenerateSlopeImage(height_scale, contrast, brightness,
+                       sunazimuth, contour_height_scale);
+  else
+    GenerateUnshadedImage(height_scale, contour_height_scale);
+}
+
+/**
+ * Split the rows [0, n_rows) into #n_bands bands, and invoke the
+ * function f(band, y0, y1) for each of them in parallel.
+ */
+template<typename F>
+static void
+ForEachBand(ThreadPool &pool, unsigned n_rows, unsigned n_bands, F &&f)
+{
+  pool.Run(n_bands, [n_rows, n_bands, &f](unsigned i){
+      f(i, i * n_rows / n_bands, (i + 1) * n_rows / n_bands);
+    });
+}
+
+void
+RasterImageGenerator::GenerateUnshadedImage(unsigned height_scale,
+                                            const unsigned contour_height_scale)
+{
+  const unsigned width = height_matrix->GetWidth();
+
+  ForEachBand(*pool, height_matrix->GetHeight(), n_bands,
+              [&](unsigned band, unsigned y0, unsigned y1){
+                unsigned char *column_base =
+                  contour_column_base.begin() + band * width;
+                ContourStart(column_base,
+                             height_matrix->GetRow(y0 > 0 ? y0 - 1 : 0),
+                             contour_height_scale);
+                GenerateUnshadedRows(y0, y1, column_base,
+                                     height_scale, contour_height_scale);
+              });
+}
+
+void
+RasterImageGenerator::GenerateUnshadedRows(unsigned y0, unsigned y1,
+                                           unsigned char *column_base,
+                                           unsigned height_scale,
+                                           const unsigned contour_height_scale)
+{
+  const auto *src = height_matrix->GetRow(y0);
+  const RawColor *oColorBuf = color_table + 64 * 256;
+
+  for (unsigned y = y0; y < y1; ++y) {
+    RawColor *p = GetDestRow(y);
+
+    unsigned contour_row_base = ContourInterval(*src, contour_height_scale);
+    unsigned char *contour_this_column_base = column_base;
+
+    for (unsigned x = height_matrix->GetWidth(); x > 0; --x) {
+      const auto e = *src++;
+      if (gcc_likely(!e.IsSpecial())) {
+        unsigned h = std::max(0, (int)e.GetValue());
+
+        const unsigned contour_interval =
+          ContourInterval(h, contour_height_scale);
+
+        h = std::min(254u, h >> height_scale);
+        if (gcc_unlikely(IsContour(contour_interval, contour_row_base,
+                                   *contour_this_column_base))) {
+          *p++ = oColorBuf[(int)h - 64 * 256];
+          contour_row_base = contour_interval;
+        } else {
+          *p++ = oColorBuf[h];
+        }
+
+        *contour_this_column_base = contour_interval;
+      } else if (e.IsWater()) {
+        // we're in the water, so look up the color for water
+        *p++ = oColorBuf[255];
+        *contour_this_column_base = NO_CONTOUR;
+      } else {
+        /* outside the terrain file bounds: white background */
+        *p++ = RawColor(0xff, 0xff, 0xff);
+        *contour_this_column_base = NO_CONTOUR;
+      }
+      contour_this_column_base++;
+
+    }
+  }
+}
+
+/**
+ * Clip the difference between two adjacent terrain height values to
+ * sane bounds.  This works around integer overflows in the
+ * GenerateSlopeImage() formula when the map file is broken, avoiding
+ * the sqrt() call with a negative argument.
+ */
+gcc_const
+static int
+ClipHeightDelta(int d)
+{
+  return Clamp(d, -512, 512);
+}
+
+gcc_const
+static int
+ClipHeightDelta(TerrainHeight a, TerrainHeight b)
+{
+  return ClipHeightDelta(a.GetValue() - b.GetValue());
+}
+
+/**
+ * Returns the distance of the neighbour in "plus" direction (right
+ * or below) used for the slope calculation.  It is clipped at the
+ * border of the height matrix.
+ */
+gcc_const
+static unsigned
+SlopePlusIndex(unsigned i, unsigned size, unsigned quantisation_effective)
+{
+  return i < size - quantisation_effective
+    ? quantisation_effective
+    : size - 1 - i;
+}
+
+/**
+ * Returns the distance of the neighbour in "minus" direction (left or
+ * above) used for the slope calculation.
+ */
+gcc_const
+static unsigned
+SlopeMinusIndex(unsigned i, unsigned quantisation_effective)
+{
+  return i >= quantisation_effective ? quantisation_effective : i;
+}
+
+// JMW: if zoomed right in (e.g. one unit is larger than terrain
+// grid), then increase the step size to be equal to the terrain
+// grid for purposes of calculating slope, to avoid shading problems
+// (gridding of display) This is why quantisation_effective is used instead of 1
+// previously.  for large zoom levels, quantisation_effective=1
+void
+RasterImageGenerator::GenerateSlopeImage(unsigned height_scale,
+                                         int contrast,
+                                         const int sx, const int sy, const int sz,
+                                         const unsigned contour_height_scale)
+{
+  assert(quantisation_effective > 0);
+
+  const unsigned height_slope_factor =
+    Clamp((unsigned)pixel_size, 1u,
+          /* this upper limit avoids integer overflows in the "mag"
+             formula; it effectively limits "dd2" so calculating its
+             square will not overflow */
+          8192u / (quantisation_effective * quantisation_effective));
+
+  const unsigned width = height_matrix->GetWidth();
+
+  ForEachBand(*pool, height_matrix->GetHeight(), n_bands,
+              [&](unsigned band, unsigned y0, unsigned y1){
+                unsigned char *column_base =
+                  contour_column_base.begin() + band * width;
+                ContourStart(column_base,
+                             height_matrix->GetRow(y0 > 0 ? y0 - 1 : 0),
+                             contour_height_scale);
+                GenerateSlopeRows(y0, y1, column_base,
+                                  height_scale, contrast, sx, sy, sz,
+                                  height_slope_factor,
+                                  contour_height_scale);
+              });
+}
+
+void
+RasterImageGenerator::GenerateSlopeRows(unsigned y0, unsigned y1,
+                                        unsigned char *column_base,
+                                        unsigned height_scale, int contrast,
+                                        const int sx, const int sy, const int sz,
+                                        const unsigned height_slope_factor,
+                                        const unsigned contour_height_scale)
+{
+  const auto *src = height_matrix->GetRow(y0);
+  const RawColor *oColorBuf = color_table + 64 * 256;
+
+  for (unsigned y = y0; y < y1; ++y) {
+    const unsigned row_plus_index =
+      SlopePlusIndex(y, height_matrix->GetHeight(), quantisation_effective);
+    const unsigned row_plus_offset = height_matrix->GetWidth() * row_plus_index;
+
+    const unsigned row_minus_index =
+      SlopeMinusIndex(y, quantisation_effective);
+    const unsigned row_minus_offset = height_matrix->GetWidth() * row_minus_index;
+
+    const unsigned p31 = row_plus_index + row_minus_index;
+
+    RawColor *p = GetDestRow(y);
+
+    unsigned contour_row_base = ContourInterval(*src, contour_height_scale);
+    unsigned char *contour_this_column_base = column_base;
+
+    for (unsigned x = 0; x < height_matrix->GetWidth(); ++x, ++src) {
+      const auto e = *src;
+      if (gcc_likely(!e.IsSpecial())) {
+        unsigned h = std::max(0, (int)e.GetValue());
+
+        const unsigned contour_interval =
+          ContourInterval(h, contour_height_scale);
+
+        h = std::min(254u, h >> height_scale);
+
+        // no need to calculate slope if undefined height or sea level
+
+        // Y direction
+        assert(src - row_minus_offset >= height_matrix->GetData());
+        assert(src + row_plus_offset >= height_matrix->GetData());
+        assert(src - row_minus_offset < height_matrix->GetDataEnd());
+        assert(src + row_plus_offset < height_matrix->GetDataEnd());
+
+        // X direction
+
+        const unsigned column_plus_index =
+          SlopePlusIndex(x, height_matrix->GetWidth(), quantisation_effective);
+        const unsigned column_minus_index =
+          SlopeMinusIndex(x, quantisation_effective);
+
+        assert(src - column_minus_index >= height_matrix->GetData());
+        assert(src + column_plus_index >= height_matrix->GetData());
+        assert(src - column_minus_index < height_matrix->GetDataEnd());
+        assert(src + column_plus_index < height_matrix->GetDataEnd());
+
+        const auto h_above = src[-(int)row_minus_offset];
+        const auto h_below = src[row_plus_offset];
+        const auto h_left = src[-(int)column_minus_index];
+        const auto h_right = src[column_plus_index];
+
+        if (gcc_unlikely(h_above.IsSpecial() ||
+                         h_below.IsSpecial() ||
+                         h_left.IsSpecial() ||
+                         h_right.IsSpecial())) {
+          /* some "special" terrain value surrounding us (water or
+             invalid), skip slope calculation */
+          *p++ = oColorBuf[h];
+          *contour_this_column_base++ = contour_interval;
+          continue;
+        }
+
+        if (gcc_unlikely(IsContour(contour_interval, contour_row_base,
+                                   *contour_this_column_base))) {
+          *contour_this_column_base++ = contour_row_base = contour_interval;
+          *p++ = oColorBuf[int(h) - 64 * 256];
+          continue;
+        }
+
+        *contour_this_column_base = contour_interval;
+
+        const int p32 = ClipHeightDelta(h_above, h_below);
+        const int p22 = ClipHeightDelta(h_right, h_left);
+
+        const unsigned p20 = column_plus_index + column_minus_index;
+
+        const int dd0 = p22 * int(p31);
+        const int dd1 = int(p20) * p32;
+        const unsigned dd2 = p20 * p31 * height_slope_factor;
+        const int num = (int(dd2) * sz + dd0 * sx + dd1 * sy);
+        const unsigned square_mag = dd0 * dd0 + dd1 * dd1 + dd2 * dd2;
+        const unsigned mag = (unsigned)sqrt(square_mag);
+        /* this is a workaround for a SIGFPE (division by zero)
+           observed by our users on some Android devices (e.g. Nexus
+           7), even though we did our best to make sure that the
+           integer arithmetics above can't overflow */
+        /* TODO: debug this problem and replace this workaround */
+        const int sval = num / int(mag|1);
+        const int sindex = (sval - sz) * contrast / 128;
+        *p++ = oColorBuf[int(h) + 256 * Clamp(sindex, -63, 63)];
+      } else if (e.IsWater()) {
+        // we're in the water, so look up the color for water
+        *p++ = oColorBuf[255];
+        *contour_this_column_base = NO_CONTOUR;
+      } else {
+        /* outside the terrain file bounds: white background */
+        *p++ = RawColor(0xff, 0xff, 0xff);
+        *contour_this_column_base = NO_CONTOUR;
+      }
+      contour_this_column_base++;
+
+    }
+  }
+}
+
+void
+RasterImageGenerator::GenerateSlopeImage(unsigned height_scale,
+                                         int contrast, int brightness,
+                                         const Angle sunazimuth,
+                                         const unsigned contour_height_scale)
+{
+  const Angle fudgeelevation = Angle::Degrees(10) +
+    Angle::Degrees(80.0 / 255.0) * brightness;
+
+  const int sx = (int)(255 * fudgeelevation.fastcosine() * -sunazimuth.fastsine());
+  const int sy = (int)(255 * fudgeelevation.fastcosine() * -sunazimuth.fastcosine());
+  const int sz = (int)(255 * fudgeelevation.fastsine());
+
+  GenerateSlopeImage(height_scale, contrast,
+                     sx, sy, sz, contour_height_scale);
+}
+
+void
+RasterImageGenerator::PrepareColorTable(const ColorRamp *color_ramp,
+                                        bool do_water, unsigned height_scale,
+                                        int interp_levels)
+{
+  if (color_table == nullptr)
+    color_table = new RawColor[256 * 128];
+
+  for (int i = 0; i < 256; i++) {
+    for (int mag = -64; mag < 64; mag++) {
+      RawColor color;
+
+      if (i == 255) {
+        if (do_water) {
+          // water colours
+          color = RawColor(85, 160, 255);
+        } else {
+          color = RawColor(255, 255, 255);
+
+          // ColorRampLookup(0, r, g, b,
+          // Color_ramp, NUM_COLOR_RAMP_LEVELS, interp_levels);
+        }
+      } else {
+        const RGB8Color color2 =
+          ColorRampLookup(i << height_scale, color_ramp,
+                          NUM_COLOR_RAMP_LEVELS, interp_levels);
+
+        color = TerrainShading(mag, color2);
+      }
+
+      color_table[i + (mag + 64) * 256] = color;
+    }
+  }
+}
+
+void
+RasterImageGenerator::ContourStart(unsigned char *column_base,
+                                   const TerrainHeight *row,
+                                   const unsigned contour_height_scale) const
+{
+  /* the image generator leaves the interval of each regular cell in
+     the column state, and #NO_CONTOUR below special cells; therefore
+     the row above the band is all that is needed to continue */
+  for (unsigned x = 0, width = height_matrix->GetWidth(); x < width; ++x)
+    column_base[x] = row[x].IsSpecial()
+      ? NO_CONTOUR
+      : ContourInterval(row[x], contour_height_scale);
+}
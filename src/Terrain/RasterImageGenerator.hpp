@@ -0,0 +1,175 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+#ifndef XCSOAR_RASTER_IMAGE_GENERATOR_HPP
+#define XCSOAR_RASTER_IMAGE_GENERATOR_HPP
+
+#include "Util/AllocatedArray.hxx"
+#include "Util/Compiler.h"
+
+#define NUM_COLOR_RAMP_LEVELS 13
+
+class Angle;
+class HeightMatrix;
+class TerrainHeight;
+class ThreadPool;
+struct RawColor;
+struct ColorRamp;
+
+/**
+ * Converts a #HeightMatrix into colors, with optional slope shading
+ * and contour lines.  The image is split into bands of rows which are
+ * converted in parallel; the result does not depend on the number of
+ * bands.
+ */
+class RasterImageGenerator {
+  const HeightMatrix *height_matrix;
+
+  /**
+   * The top row of the destination image.
+   */
+  RawColor *dest;
+
+  /**
+   * The distance between two rows of #dest [RawColor]; negative if
+   * the rows are stored bottom-up.
+   */
+  int dest_pitch;
+
+  ThreadPool *pool;
+  unsigned n_bands;
+
+  /**
+   * Step size used for slope calculations.
+   */
+  unsigned quantisation_effective;
+
+  double pixel_size;
+
+  /**
+   * The contour state of each column, one array of
+   * #HeightMatrix::GetWidth() elements per band of rows.
+   */
+  AllocatedArray<unsigned char> contour_column_base;
+
+  RawColor *color_table = nullptr;
+
+public:
+  RasterImageGenerator() = default;
+  ~RasterImageGenerator();
+
+  RasterImageGenerator(const RasterImageGenerator &) = delete;
+  RasterImageGenerator &operator=(const RasterImageGenerator &) = delete;
+
+  /**
+   * Fills the color_table array with precomputed colors for 256 height and
+   * 64 illumination levels. This is used to speed up the rendering by
+   * preventing the same color calculations over and over again.
+   */
+  void PrepareColorTable(const ColorRamp *color_ramp, bool do_water,
+                         unsigned height_scale, int interp_levels);
+
+  /**
+   * Convert the height matrix into the image.  PrepareColorTable()
+   * must have been called before.
+   *
+   * @param dest the top row of the image, which must have at least
+   * as many columns and rows as the #HeightMatrix
+   * @param dest_pitch the distance between two rows of the image
+   * [RawColor]; negative if the rows are stored bottom-up
+   * @param n_bands the number of bands of rows which are converted
+   * in parallel
+   * @param quantisation_effective the step size used for slope
+   * calculations; 0 disables slope shading and contour lines
+   * @param pixel_size the geographic size of one cell [m]
+   */
+  void Generate(const HeightMatrix &height_matrix,
+                RawColor *dest, int dest_pitch,
+                ThreadPool &pool, unsigned n_bands,
+                unsigned quantisation_effective, double pixel_size,
+                bool do_shading,
+                unsigned height_scale, int contrast, int brightness,
+                const Angle sunazimuth,
+                bool do_contour);
+
+protected:
+  gcc_pure
+  RawColor *GetDestRow(unsigned y) const;
+
+  /**
+   * Convert the height matrix into the image, without shading.
+   */
+  void GenerateUnshadedImage(unsigned height_scale,
+                             const unsigned contour_height_scale);
+
+  /**
+   * Convert the rows [y0, y1) of the height matrix into the image,
+   * without shading.
+   *
+   * @param column_base the contour state of this band, initialised
+   * by ContourStart()
+   */
+  void GenerateUnshadedRows(unsigned y0, unsigned y1,
+                            unsigned char *column_base,
+                            unsigned height_scale,
+                            const unsigned contour_height_scale);
+
+  /**
+   * Convert the height matrix into the image, with slope shading.
+   */
+  void GenerateSlopeImage(unsigned height_scale, int contrast,
+                          const int sx, const int sy, const int sz,
+                          const unsigned contour_height_scale);
+
+  /**
+   * Convert the rows [y0, y1) of the height matrix into the image,
+   * with slope shading.
+   *
+   * @param column_base the contour state of this band, initialised
+   * by ContourStart()
+   */
+  void GenerateSlopeRows(unsigned y0, unsigned y1,
+                         unsigned char *column_base,
+                         unsigned height_scale, int contrast,
+                         const int sx, const int sy, const int sz,
+                         unsigned height_slope_factor,
+                         const unsigned contour_height_scale);
+
+  /**
+   * Convert the height matrix into the image, with slope shading.
+   */
+  void GenerateSlopeImage(unsigned height_scale,
+                          int contrast, int brightness,
+                          const Angle sunazimuth,
+                          const unsigned contour_height_scale);
+
+private:
+  /**
+   * Initialise the contour state for a band from the row right above
+   * it (or from the first row for the first band).  This is the state
+   * the image generator leaves after that row.
+   */
+  void ContourStart(unsigned char *column_base, const TerrainHeight *row,
+                    const unsigned contour_height_scale) const;
+};
+
+#endif
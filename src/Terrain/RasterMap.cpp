@@ -26,6 +26,7 @@ Copyright_License {
 #include "Math/Util.hpp"
 
 #include <algorithm>
+#include <vector>
 #include <cassert>
 
 void
@@ -174,6 +175,61 @@ RasterMap::FirstIntersection(const GeoPoint &origin, const int h_origin,
   }
 }
 
+void
+RasterMap::FirstIntersection(FirstIntersectionLine *lines, const unsigned n,
+                             const int h_ceiling, const int h_safety) const
+{
+  std::vector<RasterTileCache::FirstIntersectionLine> raster_lines;
+  std::vector<unsigned> indices;
+  raster_lines.reserve(n);
+  indices.reserve(n);
+
+  for (unsigned i = 0; i < n; ++i) {
+    FirstIntersectionLine &line = lines[i];
+    line.intersecting = false;
+    line.intx = line.destination;
+    line.h = line.h_destination; // fallback, pass
+
+    const auto c_origin = projection.ProjectCoarseRound(line.origin);
+    const auto c_destination = projection.ProjectCoarseRound(line.destination);
+    const int c_diff = ManhattanDistance(c_origin, c_destination);
+    if (c_diff == 0)
+      continue; // no distance
+
+    const int slope_fact = (((int)line.h_virt) << RASTER_SLOPE_FACT) / c_diff;
+    const int vh_origin = std::max(line.h_origin,
+                                   line.h_destination
+                                   - ((c_diff * slope_fact) >> RASTER_SLOPE_FACT));
+
+    RasterTileCache::FirstIntersectionLine r;
+    r.origin = c_origin;
+    r.destination = c_destination;
+    r.h_origin = vh_origin;
+    r.h_dest = line.h_destination;
+    r.slope_fact = slope_fact;
+    r.can_climb = line.h_destination < line.h_virt;
+    raster_lines.push_back(r);
+    indices.push_back(i);
+  }
+
+  raster_tile_cache.FirstIntersection(raster_lines.data(),
+                                      raster_lines.size(),
+                                      h_ceiling, h_safety);
+
+  for (unsigned i = 0; i < raster_lines.size(); ++i) {
+    const auto &r = raster_lines[i];
+    if (!r.intersecting)
+      continue;
+
+    FirstIntersectionLine &line = lines[indices[i]];
+    line.h = r.h;
+    line.intersecting = r.location != r.destination ||
+      (r.h > line.h_destination && r.location == r.destination);
+    if (line.intersecting)
+      line.intx = projection.UnprojectCoarse(r.location);
+  }
+}
+
 GeoPoint
 RasterMap::Intersection(const GeoPoint& origin,
                         const int h_origin, const int h_glide,
@@ -196,3 +252,41 @@ RasterMap::Intersection(const GeoPoint& origin,
 
   return projection.UnprojectCoarse(c_int);
 }
+
+void
+RasterMap::Intersection(IntersectionLine *lines, const unsigned n,
+                        const int height_floor) const
+{
+  std::vector<RasterTileCache::IntersectionLine> raster_lines;
+  std::vector<unsigned> indices;
+  raster_lines.reserve(n);
+  indices.reserve(n);
+
+  for (unsigned i = 0; i < n; ++i) {
+    IntersectionLine &line = lines[i];
+    line.intx = GeoPoint::Invalid();
+
+    const auto c_origin = projection.ProjectCoarseRound(line.origin);
+    const auto c_destination = projection.ProjectCoarseRound(line.destination);
+    const int c_diff = ManhattanDistance(c_origin, c_destination);
+    if (c_diff == 0)
+      continue;
+
+    RasterTileCache::IntersectionLine r;
+    r.origin = c_origin;
+    r.destination = c_destination;
+    r.h_origin = line.h_origin;
+    r.slope_fact = (((int)line.h_glide) << RASTER_SLOPE_FACT) / c_diff;
+    raster_lines.push_back(r);
+    indices.push_back(i);
+  }
+
+  raster_tile_cache.Intersection(raster_lines.data(), raster_lines.size(),
+                                 height_floor);
+
+  for (unsigned i = 0; i < raster_lines.size(); ++i) {
+    const auto &r = raster_lines[i];
+    if (r.location.x >= 0)
+      lines[indices[i]].intx = projection.UnprojectCoarse(r.location);
+  }
+}
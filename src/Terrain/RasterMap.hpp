@@ -45,6 +45,10 @@ public:
     return raster_tile_cache;
   }
 
+  const RasterTileCache &GetTileCache() const {
+    return raster_tile_cache;
+  }
+
   void UpdateProjection();
 
   bool SaveCache(FILE *file) const {
@@ -80,6 +84,14 @@ public:
     return raster_tile_cache.IsDirty();
   }
 
+  /**
+   * Returns the domain which concurrent readers must hold a read
+   * lease on; see RasterTileCache::GetRcu().
+   */
+  RcuDomain &GetRcu() const {
+    return raster_tile_cache.GetRcu();
+  }
+
   const Serial &GetSerial() const {
     return raster_tile_cache.GetSerial();
   }
@@ -124,6 +136,30 @@ public:
                          int h_virt, int h_ceiling, int h_safety,
                          GeoPoint& intx, int &h) const;
 
+  /**
+   * The parameters and the result of one line for the batched
+   * FirstIntersection().
+   */
+  struct FirstIntersectionLine {
+    GeoPoint origin, destination;
+    int h_origin, h_destination, h_virt;
+
+    /**
+     * The return value of FirstIntersection().
+     */
+    bool intersecting;
+
+    GeoPoint intx;
+    int h;
+  };
+
+  /**
+   * Batched version of FirstIntersection(), which walks the lines in
+   * the order of the terrain tiles containing their origins.
+   */
+  void FirstIntersection(FirstIntersectionLine *lines, unsigned n,
+                         int h_ceiling, int h_safety) const;
+
   /**
    * Find location where aircraft hits the ground or height_floor
    * @todo margin
@@ -144,6 +180,30 @@ public:
                         const GeoPoint& destination,
                         const int height_floor) const;
 
+  /**
+   * The parameters and the result of one line for the batched
+   * Intersection().
+   */
+  struct IntersectionLine {
+    GeoPoint origin, destination;
+    int h_origin, h_glide;
+
+    /**
+     * The return value of Intersection(), i.e. GeoPoint::Invalid()
+     * if none was found.
+     */
+    GeoPoint intx;
+  };
+
+  /**
+   * Batched version of Intersection(), e.g. for the radials of a
+   * reach fan.  The lines are walked in the order of the terrain
+   * tiles containing their origins, like the batched
+   * FirstIntersection().
+   */
+  void Intersection(IntersectionLine *lines, unsigned n,
+                    int height_floor) const;
+
 };
 
 
@@ -24,8 +24,6 @@ Copyright_License {
 #include "Terrain/RasterRenderer.hpp"
 #include "Terrain/RasterMap.hpp"
 #include "Math/FastMath.hpp"
-#include "Util/Clamp.hpp"
-#include "Screen/Ramp.hpp"
 #include "Screen/Layout.hpp"
 #include "Screen/Color.hpp"
 #include "Screen/RawBitmap.hpp"
@@ -34,72 +32,14 @@ Copyright_License {
 #include "Asset.hpp"
 #include "Event/Idle.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 
-/**
- * Interpolate between x and y with i/128, i.e. i/(1 << 7).
- *
- * i must be below or equal to 128.
- */
-constexpr
-static inline unsigned
-MIX(unsigned x, unsigned y, unsigned i)
-{
-  return (x * i + y * ((1 << 7) - i)) >> 7;
-}
-
-/**
- * Shade the given color according to the illumination value.
- *
- * illum = 64: Contour, mixed with 50% brown
- * illum < 0:  Shadow, mixed with up to 50% dark blue
- * illum > 0:  Highlight, mixed with up to 25% yellow
- * illum = 0:  No shading
- */
-gcc_const
-inline RawColor
-TerrainShading(const int illum, RGB8Color color)
-{
-  if (illum == -64) {
-    // brown color mixed in for contours
-    return RawColor(MIX(100, color.Red(), 64),
-                    MIX(70, color.Green(), 64),
-                    MIX(26, color.Blue(), 64));
-  } else if (illum < 0) {
-    // shadow to blue
-    int x = std::min(63, -illum);
-    return RawColor(MIX(0, color.Red(), x),
-                    MIX(0, color.Green(), x),
-                    MIX(64, color.Blue(), x));
-  } else if (illum > 0) {
-    // highlight to yellow
-    int x = std::min(32, illum / 2);
-    return RawColor(MIX(255, color.Red(), x),
-                    MIX(255, color.Green(), x),
-                    MIX(16, color.Blue(), x));
-  } else
-    return RawColor(color.Red(), color.Green(), color.Blue());
-}
-
-gcc_const
-static unsigned
-ContourInterval(const unsigned h, const unsigned contour_height_scale)
-{
-  return std::min(254u, h >> contour_height_scale);
-}
-
-gcc_const
-static unsigned
-ContourInterval(const TerrainHeight h, const unsigned contour_height_scale)
-{
-  if (gcc_unlikely(h.IsSpecial()) || h.GetValue() <= 0)
-    return 0;
-
-  return ContourInterval(h.GetValue(), contour_height_scale);
-}
+#include <stdlib.h>
 
 RasterRenderer::RasterRenderer()
+  :render_pool("TerrainRender", 3)
 {
   // scale quantisation_pixels so resolution is not too high on old hardware
   // with large displays
@@ -110,9 +50,7 @@ RasterRenderer::RasterRenderer()
 
 RasterRenderer::~RasterRenderer()
 {
-  delete[] color_table;
   delete image;
-  delete[] contour_column_base;
 }
 
 #ifdef ENABLE_OPENGL
@@ -149,7 +87,8 @@ RasterRenderer::BindAndGetTexture() const
 #endif
 
 void
-RasterRenderer::ScanMap(const RasterMap &map, const WindowProjection &projection)
+RasterRenderer::UpdateQuantisationEffective(const RasterMap &map,
+                                            const WindowProjection &projection)
 {
   // Coordinates of the MapWindow center
   unsigned x = projection.GetScreenWidth() / 2;
@@ -184,6 +123,12 @@ RasterRenderer::ScanMap(const RasterMap &map, const WindowProjection &projection
   } else
     /* disable slope shading when zoomed out very far (too tiny) */
     quantisation_effective = 0;
+}
+
+void
+RasterRenderer::ScanMap(const RasterMap &map, const WindowProjection &projection)
+{
+  UpdateQuantisationEffective(map, projection);
 
 #ifdef ENABLE_OPENGL
   bounds = projection.GetScreenBounds().Scale(1.5);
@@ -192,309 +137,237 @@ RasterRenderer::ScanMap(const RasterMap &map, const WindowProjection &projection
   height_matrix.Fill(map, bounds,
                      projection.GetScreenWidth() / quantisation_pixels,
                      projection.GetScreenHeight() / quantisation_pixels,
-                     true);
+                     true, &render_pool);
 
   last_quantisation_pixels = quantisation_pixels;
 #else
-  height_matrix.Fill(map, projection, quantisation_pixels, true);
-#endif
-}
+  /* before scanning, so tiles which get loaded meanwhile will be
+     picked up by the next UpdateTiles() call */
+  SaveTiles(map);
 
-void
-RasterRenderer::GenerateImage(bool do_shading,
-                              unsigned height_scale,
-                              int contrast, int brightness,
-                              const Angle sunazimuth,
-                              bool do_contour)
-{
-  if (image == nullptr ||
-      height_matrix.GetWidth() > image->GetWidth() ||
-      height_matrix.GetHeight() > image->GetHeight()) {
-    delete image;
-    image = new RawBitmap(height_matrix.GetWidth(), height_matrix.GetHeight());
-
-    delete[] contour_column_base;
-    contour_column_base = new unsigned char[height_matrix.GetWidth()];
-  }
-
-  if (quantisation_effective == 0) {
-    do_shading = false;
-    do_contour = false;
-  }
+  height_matrix.Fill(map, projection, quantisation_pixels, true,
+                     &render_pool);
 
-  const unsigned contour_height_scale = do_contour? height_scale * 2 : 16;
-
-  ContourStart(contour_height_scale);
-
-  if (do_shading)
-    GenerateSlopeImage(height_scale, contrast, brightness,
-                       sunazimuth, contour_height_scale);
-  else
-    GenerateUnshadedImage(height_scale, contour_height_scale);
-
-  image->SetDirty();
+  scanned_projection = projection;
+  scanned_origin = PixelPoint(0, 0);
+  scanned_shift = 0;
+  scanned = true;
+#endif
 }
 
-void
-RasterRenderer::GenerateUnshadedImage(unsigned height_scale,
-                                      const unsigned contour_height_scale)
-{
-  const auto *src = height_matrix.GetData();
-  const RawColor *oColorBuf = color_table + 64 * 256;
-  RawColor *dest = image->GetTopRow();
-
-  for (unsigned y = height_matrix.GetHeight(); y > 0; --y) {
-    RawColor *p = dest;
-    dest = image->GetNextRow(dest);
-
-    unsigned contour_row_base = ContourInterval(*src, contour_height_scale);
-    unsigned char *contour_this_column_base = contour_column_base;
-
-    for (unsigned x = height_matrix.GetWidth(); x > 0; --x) {
-      const auto e = *src++;
-      if (gcc_likely(!e.IsSpecial())) {
-        unsigned h = std::max(0, (int)e.GetValue());
-
-        const unsigned contour_interval =
-          ContourInterval(h, contour_height_scale);
-
-        h = std::min(254u, h >> height_scale);
-        if (gcc_unlikely((contour_interval != contour_row_base)
-                         || (contour_interval != *contour_this_column_base))) {
-
-          *p++ = oColorBuf[(int)h - 64 * 256];
-          *contour_this_column_base = contour_row_base = contour_interval;
-        } else {
-          *p++ = oColorBuf[h];
-        }
-      } else if (e.IsWater()) {
-        // we're in the water, so look up the color for water
-        *p++ = oColorBuf[255];
-      } else {
-        /* outside the terrain file bounds: white background */
-        *p++ = RawColor(0xff, 0xff, 0xff);
-      }
-      contour_this_column_base++;
-
-    }
-  }
-}
+#ifndef ENABLE_OPENGL
 
 /**
- * Clip the difference between two adjacent terrain height values to
- * sane bounds.  This works around integer overflows in the
- * GenerateSlopeImage() formula when the map file is broken, avoiding
- * the sqrt() call with a negative argument.
+ * Divide and round to the nearest integer, also for negative values.
  */
 gcc_const
 static int
-ClipHeightDelta(int d)
+RoundingDivide(int a, int b)
 {
-  return Clamp(d, -512, 512);
+  assert(b > 0);
+
+  return a >= 0
+    ? (a + b / 2) / b
+    : -((-a + b / 2) / b);
 }
 
-gcc_const
-static int
-ClipHeightDelta(TerrainHeight a, TerrainHeight b)
+gcc_pure
+static bool
+IsNear(PixelPoint a, PixelPoint b)
 {
-  return ClipHeightDelta(a.GetValue() - b.GetValue());
+  return abs(a.x - b.x) <= 1 && abs(a.y - b.y) <= 1;
 }
 
-// JMW: if zoomed right in (e.g. one unit is larger than terrain
-// grid), then increase the step size to be equal to the terrain
-// grid for purposes of calculating slope, to avoid shading problems
-// (gridding of display) This is why quantisation_effective is used instead of 1
-// previously.  for large zoom levels, quantisation_effective=1
-void
-RasterRenderer::GenerateSlopeImage(unsigned height_scale,
-                                   int contrast,
-                                   const int sx, const int sy, const int sz,
-                                   const unsigned contour_height_scale)
+inline bool
+RasterRenderer::ShiftMap(const RasterMap &map,
+                         const WindowProjection &projection)
 {
-  assert(quantisation_effective > 0);
-
-  PixelRect border;
-  border.left = quantisation_effective;
-  border.top = quantisation_effective;
-  border.right = height_matrix.GetWidth() - quantisation_effective;
-  border.bottom = height_matrix.GetHeight() - quantisation_effective;
-
-  const unsigned height_slope_factor =
-    Clamp((unsigned)pixel_size, 1u,
-          /* this upper limit avoids integer overflows in the "mag"
-             formula; it effectively limits "dd2" so calculating its
-             square will not overflow */
-          8192u / (quantisation_effective * quantisation_effective));
-
-  const auto *src = height_matrix.GetData();
-  const RawColor *oColorBuf = color_table + 64 * 256;
-
-  RawColor *dest = image->GetTopRow();
-
-  for (unsigned y = 0; y < height_matrix.GetHeight(); ++y) {
-    const unsigned row_plus_index = y < (unsigned)border.bottom
-      ? quantisation_effective
-      : height_matrix.GetHeight() - 1 - y;
-    const unsigned row_plus_offset = height_matrix.GetWidth() * row_plus_index;
-
-    const unsigned row_minus_index = y >= quantisation_effective
-      ? quantisation_effective : y;
-    const unsigned row_minus_offset = height_matrix.GetWidth() * row_minus_index;
-
-    const unsigned p31 = row_plus_index + row_minus_index;
-
-    RawColor *p = dest;
-    dest = image->GetNextRow(dest);
-
-    unsigned contour_row_base = ContourInterval(*src, contour_height_scale);
-    unsigned char *contour_this_column_base = contour_column_base;
-
-    for (unsigned x = 0; x < height_matrix.GetWidth(); ++x, ++src) {
-      const auto e = *src;
-      if (gcc_likely(!e.IsSpecial())) {
-        unsigned h = std::max(0, (int)e.GetValue());
-
-        const unsigned contour_interval =
-          ContourInterval(h, contour_height_scale);
-
-        h = std::min(254u, h >> height_scale);
-
-        // no need to calculate slope if undefined height or sea level
-
-        // Y direction
-        assert(src - row_minus_offset >= height_matrix.GetData());
-        assert(src + row_plus_offset >= height_matrix.GetData());
-        assert(src - row_minus_offset < height_matrix.GetDataEnd());
-        assert(src + row_plus_offset < height_matrix.GetDataEnd());
-
-        // X direction
-
-        const unsigned column_plus_index = x < (unsigned)border.right
-          ? quantisation_effective
-          : height_matrix.GetWidth() - 1 - x;
-        const unsigned column_minus_index = x >= (unsigned)border.left
-          ? quantisation_effective : x;
-
-        assert(src - column_minus_index >= height_matrix.GetData());
-        assert(src + column_plus_index >= height_matrix.GetData());
-        assert(src - column_minus_index < height_matrix.GetDataEnd());
-        assert(src + column_plus_index < height_matrix.GetDataEnd());
-
-        const auto h_above = src[-(int)row_minus_offset];
-        const auto h_below = src[row_plus_offset];
-        const auto h_left = src[-(int)column_minus_index];
-        const auto h_right = src[column_plus_index];
-
-        if (gcc_unlikely(h_above.IsSpecial() ||
-                         h_below.IsSpecial() ||
-                         h_left.IsSpecial() ||
-                         h_right.IsSpecial())) {
-          /* some "special" terrain value surrounding us (water or
-             invalid), skip slope calculation */
-          *p++ = oColorBuf[h];
-          contour_this_column_base++;
-          continue;
-        }
-
-        if (gcc_unlikely((contour_interval != contour_row_base)
-                         || (contour_interval != *contour_this_column_base))) {
-
-          *contour_this_column_base++ = contour_row_base = contour_interval;
-          *p++ = oColorBuf[int(h) - 64 * 256];
-          continue;
-        }
-
-        const int p32 = ClipHeightDelta(h_above, h_below);
-        const int p22 = ClipHeightDelta(h_right, h_left);
-
-        const unsigned p20 = column_plus_index + column_minus_index;
-
-        const int dd0 = p22 * int(p31);
-        const int dd1 = int(p20) * p32;
-        const unsigned dd2 = p20 * p31 * height_slope_factor;
-        const int num = (int(dd2) * sz + dd0 * sx + dd1 * sy);
-        const unsigned square_mag = dd0 * dd0 + dd1 * dd1 + dd2 * dd2;
-        const unsigned mag = (unsigned)sqrt(square_mag);
-        /* this is a workaround for a SIGFPE (division by zero)
-           observed by our users on some Android devices (e.g. Nexus
-           7), even though we did our best to make sure that the
-           integer arithmetics above can't overflow */
-        /* TODO: debug this problem and replace this workaround */
-        const int sval = num / int(mag|1);
-        const int sindex = (sval - sz) * contrast / 128;
-        *p++ = oColorBuf[int(h) + 256 * Clamp(sindex, -63, 63)];
-      } else if (e.IsWater()) {
-        // we're in the water, so look up the color for water
-        *p++ = oColorBuf[255];
-      } else {
-        /* outside the terrain file bounds: white background */
-        *p++ = RawColor(0xff, 0xff, 0xff);
-      }
-      contour_this_column_base++;
+  if (!scanned)
+    return false;
+
+  const WindowProjection &old = scanned_projection;
+  const int screen_width = projection.GetScreenWidth();
+  const int screen_height = projection.GetScreenHeight();
+  if (screen_width != int(old.GetScreenWidth()) ||
+      screen_height != int(old.GetScreenHeight()))
+    return false;
+
+  /* where is the new screen within the old one?  If all four corners
+     are moved by the same offset, then this is a pure translation */
+  const PixelPoint delta = old.GeoToScreen(projection.ScreenToGeo(0, 0));
+  if (!IsNear(old.GeoToScreen(projection.ScreenToGeo(screen_width, 0)),
+              PixelPoint(delta.x + screen_width, delta.y)) ||
+      !IsNear(old.GeoToScreen(projection.ScreenToGeo(0, screen_height)),
+              PixelPoint(delta.x, delta.y + screen_height)) ||
+      !IsNear(old.GeoToScreen(projection.ScreenToGeo(screen_width,
+                                                     screen_height)),
+              PixelPoint(delta.x + screen_width, delta.y + screen_height)))
+    /* zoomed or rotated */
+    return false;
+
+  scanned_shift += abs(delta.x) + abs(delta.y);
+  if (scanned_shift > unsigned(std::min(screen_width, screen_height)) / 2)
+    /* too much accumulated error; start from scratch */
+    return false;
+
+  /* the position of the old cell (0,0) on the new screen */
+  const int q = quantisation_pixels;
+  const PixelPoint old_origin(scanned_origin.x - delta.x,
+                              scanned_origin.y - delta.y);
+
+  /* shift by whole cells, so that the new cell (0,0) is as near as
+     possible to the screen origin */
+  const int dx = RoundingDivide(-old_origin.x, q);
+  const int dy = RoundingDivide(-old_origin.y, q);
+
+  const unsigned width = height_matrix.GetWidth();
+  const unsigned height = height_matrix.GetHeight();
+  if (unsigned(abs(dx)) >= width || unsigned(abs(dy)) >= height)
+    /* no overlap */
+    return false;
+
+  const PixelPoint origin(old_origin.x + dx * q, old_origin.y + dy * q);
+
+  height_matrix.Shift(map, projection, origin, q, dx, dy, true,
+                      &render_pool);
+
+  scanned_projection = projection;
+  scanned_origin = origin;
+  return true;
+}
 
-    }
-  }
+void
+RasterRenderer::SaveTiles(const RasterMap &map)
+{
+  const RasterTileCache &tile_cache = map.GetTileCache();
+  scanned_tiles.assign(tile_cache.GetTileCount(), false);
+  tile_cache.ForEachTile([this](unsigned i, unsigned, unsigned,
+                                unsigned, unsigned, bool enabled){
+      scanned_tiles[i] = enabled;
+    });
 }
 
 void
-RasterRenderer::GenerateSlopeImage(unsigned height_scale,
-                                   int contrast, int brightness,
-                                   const Angle sunazimuth,
-                                   const unsigned contour_height_scale)
+RasterRenderer::UpdateTiles(const RasterMap &map)
 {
-  const Angle fudgeelevation = Angle::Degrees(10) +
-    Angle::Degrees(80.0 / 255.0) * brightness;
+  if (!scanned)
+    return;
+
+  const RasterTileCache &tile_cache = map.GetTileCache();
+  if (tile_cache.GetTileCount() != scanned_tiles.size()) {
+    /* a different map */
+    scanned = false;
+    return;
+  }
 
-  const int sx = (int)(255 * fudgeelevation.fastcosine() * -sunazimuth.fastsine());
-  const int sy = (int)(255 * fudgeelevation.fastcosine() * -sunazimuth.fastcosine());
-  const int sz = (int)(255 * fudgeelevation.fastsine());
+  const RasterProjection &raster_projection = map.GetProjection();
+  const WindowProjection &projection = scanned_projection;
+  const int screen_width = projection.GetScreenWidth();
+  const int screen_height = projection.GetScreenHeight();
+
+  /* find the screen rows covered by the tiles which have been loaded
+     or discarded since the last scan */
+
+  int top = screen_height, bottom = -1;
+  tile_cache.ForEachTile([&](unsigned i,
+                             unsigned xstart, unsigned ystart,
+                             unsigned xend, unsigned yend,
+                             bool enabled){
+      if (enabled == scanned_tiles[i])
+        return;
+
+      scanned_tiles[i] = enabled;
+
+      int min_x = screen_width, max_x = -1;
+      int min_y = screen_height, max_y = -1;
+      for (const auto corner : {
+          SignedRasterLocation(xstart, ystart),
+          SignedRasterLocation(xend, ystart),
+          SignedRasterLocation(xstart, yend),
+          SignedRasterLocation(xend, yend),
+        }) {
+        const auto p =
+          projection.GeoToScreen(raster_projection.UnprojectCoarse(corner));
+        min_x = std::min(min_x, p.x);
+        max_x = std::max(max_x, p.x);
+        min_y = std::min(min_y, p.y);
+        max_y = std::max(max_y, p.y);
+      }
 
-  GenerateSlopeImage(height_scale, contrast,
-                     sx, sy, sz, contour_height_scale);
+      if (max_x < 0 || min_x >= screen_width)
+        /* not visible */
+        return;
+
+      top = std::min(top, min_y);
+      bottom = std::max(bottom, max_y);
+    });
+
+  if (bottom < top)
+    /* no visible change */
+    return;
+
+  const int q = quantisation_pixels;
+  const int height = height_matrix.GetHeight();
+
+  /* one extra row on each side, because interpolation near the tile
+     border reads pixels from the neighbouring cell */
+  const int y0 = std::max((top - scanned_origin.y) / q - 1, 0);
+  const int y1 = std::min((bottom - scanned_origin.y) / q + 2, height);
+  if (y0 >= y1)
+    return;
+
+  /* scan whole rows, so the result is exactly the same as a full
+     scan */
+  height_matrix.FillRect(map, projection, scanned_origin, q,
+                         0, height_matrix.GetWidth(), y0, y1, true,
+                         &render_pool);
 }
 
 void
-RasterRenderer::PrepareColorTable(const ColorRamp *color_ramp, bool do_water,
-                                  unsigned height_scale, int interp_levels)
+RasterRenderer::ScanMapIncremental(const RasterMap &map,
+                                   const WindowProjection &projection)
 {
-  if (color_table == nullptr)
-    color_table = new RawColor[256 * 128];
-
-  for (int i = 0; i < 256; i++) {
-    for (int mag = -64; mag < 64; mag++) {
-      RawColor color;
-
-      if (i == 255) {
-        if (do_water) {
-          // water colours
-          color = RawColor(85, 160, 255);
-        } else {
-          color = RawColor(255, 255, 255);
-
-          // ColorRampLookup(0, r, g, b,
-          // Color_ramp, NUM_COLOR_RAMP_LEVELS, interp_levels);
-        }
-      } else {
-        const RGB8Color color2 =
-          ColorRampLookup(i << height_scale, color_ramp,
-                          NUM_COLOR_RAMP_LEVELS, interp_levels);
-
-        color = TerrainShading(mag, color2);
-      }
+  if (ShiftMap(map, projection))
+    UpdateQuantisationEffective(map, projection);
+  else
+    ScanMap(map, projection);
+}
+
+#endif
 
-      color_table[i + (mag + 64) * 256] = color;
-    }
+void
+RasterRenderer::GenerateImage(bool do_shading,
+                              unsigned height_scale,
+                              int contrast, int brightness,
+                              const Angle sunazimuth,
+                              bool do_contour)
+{
+  if (image == nullptr ||
+      height_matrix.GetWidth() > image->GetWidth() ||
+      height_matrix.GetHeight() > image->GetHeight()) {
+    delete image;
+    image = new RawBitmap(height_matrix.GetWidth(), height_matrix.GetHeight());
   }
+
+  RawColor *const top_row = image->GetTopRow();
+  image_generator.Generate(height_matrix,
+                           top_row, int(image->GetNextRow(top_row) - top_row),
+                           render_pool, GetBandCount(),
+                           quantisation_effective, pixel_size,
+                           do_shading, height_scale, contrast, brightness,
+                           sunazimuth, do_contour);
+
+  image->SetDirty();
 }
 
-void
-RasterRenderer::ContourStart(const unsigned contour_height_scale)
+unsigned
+RasterRenderer::GetBandCount() const
 {
-  // initialise column to first row
-  const auto *src = height_matrix.GetData();
-  unsigned char *col_base = contour_column_base;
-  for (unsigned x = height_matrix.GetWidth(); x > 0; --x)
-    *col_base++ = ContourInterval(*src++, contour_height_scale);
+  /* a few more bands than threads, because some rows (e.g. those
+     outside of the map) are much cheaper than others */
+  return std::max(std::min(height_matrix.GetHeight(),
+                           render_pool.GetConcurrency() * 2),
+                  1u);
 }
 
 void
@@ -25,19 +25,22 @@ Copyright_License {
 #define XCSOAR_RASTER_RENDERER_HPP
 
 #include "Terrain/HeightMatrix.hpp"
+#include "Terrain/RasterImageGenerator.hpp"
+#include "Thread/ThreadPool.hpp"
 
 #ifdef ENABLE_OPENGL
 #include "Geo/GeoBounds.hpp"
-#endif
+#else
+#include "Projection/WindowProjection.hpp"
 
-#define NUM_COLOR_RAMP_LEVELS 13
+#include <vector>
+#endif
 
 class Angle;
 class Canvas;
 class RasterMap;
 class WindowProjection;
 class RawBitmap;
-struct RawColor;
 struct ColorRamp;
 
 #ifdef ENABLE_OPENGL
@@ -69,16 +72,53 @@ class RasterRenderer {
    * texture has to be redrawn.
    */
   GeoBounds bounds = GeoBounds::Invalid();
+#else
+  /**
+   * The projection which was used for the last ScanMap() call.  This
+   * is used by ScanMapIncremental() to detect a pure translation.
+   */
+  WindowProjection scanned_projection;
+
+  /**
+   * The screen position of the #HeightMatrix cell (0,0) within
+   * #scanned_projection.
+   */
+  PixelPoint scanned_origin;
+
+  /**
+   * The accumulated translation [pixels] since the last full scan.
+   * Since the projection is not exactly linear, the reused part of
+   * the #HeightMatrix becomes more and more inaccurate, and this
+   * attribute is used to limit the error.
+   */
+  unsigned scanned_shift;
+
+  /**
+   * Is #scanned_projection valid, i.e. can the #HeightMatrix be
+   * reused by ScanMapIncremental()?
+   */
+  bool scanned = false;
+
+  /**
+   * Which tiles were loaded when the #HeightMatrix was scanned?  This
+   * is used by UpdateTiles() to find the cells which need to be
+   * scanned again.
+   */
+  std::vector<bool> scanned_tiles;
 #endif
 
   HeightMatrix height_matrix;
   RawBitmap *image = nullptr;
 
-  unsigned char *contour_column_base = nullptr;
+  /**
+   * Worker threads which scan the map and generate the image in
+   * bands of rows.
+   */
+  ThreadPool render_pool;
 
   double pixel_size;
 
-  RawColor *color_table = nullptr;
+  RasterImageGenerator image_generator;
 
 public:
   RasterRenderer();
@@ -103,6 +143,17 @@ public:
   void Invalidate() {
     bounds.SetInvalid();
   }
+#else
+  /**
+   * Discard the #HeightMatrix contents, e.g. because the map has
+   * changed.  The next ScanMapIncremental() call will do a full scan.
+   */
+  void Invalidate() {
+    scanned = false;
+  }
+#endif
+
+#ifdef ENABLE_OPENGL
 
   /**
    * Calculate a new #quantisation_pixels value.
@@ -125,13 +176,33 @@ public:
    * preventing the same color calculations over and over again.
    */
   void PrepareColorTable(const ColorRamp *color_ramp, bool do_water,
-                         unsigned height_scale, int interp_levels);
+                         unsigned height_scale, int interp_levels) {
+    image_generator.PrepareColorTable(color_ramp, do_water,
+                                      height_scale, interp_levels);
+  }
 
   /**
    * Scan the map and fill the height matrix.
    */
   void ScanMap(const RasterMap &map, const WindowProjection &projection);
 
+#ifndef ENABLE_OPENGL
+  /**
+   * Like ScanMap(), but if the projection has only been moved since
+   * the previous call (no zoom, no rotation), then shift the existing
+   * height matrix and scan only the newly exposed strips.
+   */
+  void ScanMapIncremental(const RasterMap &map,
+                          const WindowProjection &projection);
+
+  /**
+   * Tiles have been loaded or discarded since the #HeightMatrix was
+   * scanned: scan the rows they cover again.  Call this before
+   * ScanMapIncremental().
+   */
+  void UpdateTiles(const RasterMap &map);
+#endif
+
   /**
    * Convert the height matrix into the image.
    */
@@ -147,31 +218,33 @@ public:
   void Draw(Canvas &canvas, const WindowProjection &projection,
             bool transparent_white=false) const;
 
-protected:
+private:
   /**
-   * Convert the height matrix into the image, without shading.
+   * Calculate #pixel_size and #quantisation_effective for the given
+   * projection.
    */
-  void GenerateUnshadedImage(unsigned height_scale,
-                             const unsigned contour_height_scale);
+  void UpdateQuantisationEffective(const RasterMap &map,
+                                   const WindowProjection &projection);
 
+#ifndef ENABLE_OPENGL
   /**
-   * Convert the height matrix into the image, with slope shading.
+   * Attempt to reuse the #HeightMatrix after a pure translation.
+   *
+   * @return false if a full scan is needed
    */
-  void GenerateSlopeImage(unsigned height_scale, int contrast,
-                          const int sx, const int sy, const int sz,
-                          const unsigned contour_height_scale);
+  bool ShiftMap(const RasterMap &map, const WindowProjection &projection);
 
   /**
-   * Convert the height matrix into the image, with slope shading.
+   * Remember which tiles are loaded right now, see #scanned_tiles.
    */
-  void GenerateSlopeImage(unsigned height_scale,
-                          int contrast, int brightness,
-                          const Angle sunazimuth,
-                          const unsigned contour_height_scale);
-
-private:
+  void SaveTiles(const RasterMap &map);
+#endif
 
-  void ContourStart(const unsigned contour_height_scale);
+  /**
+   * Returns the number of bands the image is split into.
+   */
+  gcc_pure
+  unsigned GetBandCount() const;
 };
 
 #endif
@@ -31,6 +31,8 @@ Copyright_License {
 #include "Util/ConvertString.hpp"
 
 static const TCHAR *const terrain_cache_name = _T("terrain");
+static const TCHAR *const terrain_tile_cache_name = _T("terrain-tiles");
+static const TCHAR *const terrain_raw_name = _T("terrain-raw");
 
 inline bool
 RasterTerrain::LoadCache(FileCache &cache, Path path)
@@ -63,20 +65,77 @@ RasterTerrain::SaveCache(FileCache &cache, Path path) const
   return success;
 }
 
+inline bool
+RasterTerrain::OpenRawFile(FileCache &cache, Path path,
+                           OperationEnvironment &operation)
+{
+  auto &tile_cache = map.GetTileCache();
+
+  FILE *file = cache.Load(terrain_raw_name, path);
+  if (file != nullptr) {
+    const long offset = ftell(file);
+    fclose(file);
+
+    if (tile_cache.OpenRawFile(cache.MakeCachePath(terrain_raw_name),
+                               offset))
+      return true;
+  }
+
+  /* no usable raw file: decode the whole JPEG2000 file once */
+
+  file = cache.Save(terrain_raw_name, path);
+  if (file == nullptr)
+    return false;
+
+  const long offset = ftell(file);
+  if (!ConvertTerrainTiles(archive.get(), tile_cache, file, operation)) {
+    cache.Cancel(terrain_raw_name, file);
+    return false;
+  }
+
+  return cache.Commit(terrain_raw_name, file) &&
+    tile_cache.OpenRawFile(cache.MakeCachePath(terrain_raw_name), offset);
+}
+
+inline void
+RasterTerrain::OpenTileCache(FileCache &cache, Path path, bool flush,
+                             OperationEnvironment &operation)
+{
+  unsigned size_mb = DEFAULT_TILE_CACHE_SIZE;
+  Profile::Get(ProfileKeys::TerrainTileCacheSize, size_mb);
+
+  if (flush || size_mb == 0)
+    cache.Flush(terrain_tile_cache_name);
+
+  bool mapped = false;
+  Profile::Get(ProfileKeys::TerrainMapped, mapped);
+  if (!mapped)
+    cache.Flush(terrain_raw_name);
+  else if (OpenRawFile(cache, path, operation))
+    /* all tiles are available; no need for the tile cache */
+    return;
+
+  if (size_mb > 0)
+    map.GetTileCache().OpenDiskCache(cache.MakeCachePath(terrain_tile_cache_name),
+                                     uint64_t(size_mb) << 20);
+}
+
 inline bool
 RasterTerrain::Load(Path path, FileCache *cache,
                     OperationEnvironment &operation)
 {
-  if (LoadCache(cache, path))
+  if (LoadCache(cache, path)) {
+    OpenTileCache(*cache, path, false, operation);
     return true;
+  }
 
   if (!LoadTerrainOverview(archive.get(), map.GetTileCache(), operation))
     return false;
 
   map.UpdateProjection();
 
-  if (cache != nullptr)
-    SaveCache(*cache, path);
+  if (cache != nullptr && SaveCache(*cache, path))
+    OpenTileCache(*cache, path, true, operation);
 
   return true;
 }
@@ -107,7 +166,8 @@ RasterTerrain::UpdateTiles(const GeoPoint &location, double radius)
   if (!tile_cache.IsValid())
     return false;
 
-  UpdateTerrainTiles(archive.get(), tile_cache, mutex,
-                     map.GetProjection(), location, radius);
+  UpdateTerrainTiles(archive.get(), tile_cache,
+                     map.GetProjection(), location, radius,
+                     &decoder_pool);
   return map.IsDirty();
 }
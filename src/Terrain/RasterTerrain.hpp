@@ -26,7 +26,8 @@ Copyright_License {
 
 #include "RasterMap.hpp"
 #include "Geo/GeoPoint.hpp"
-#include "Thread/Guard.hpp"
+#include "Thread/RcuDomain.hpp"
+#include "Thread/ThreadPool.hpp"
 #include "OS/Path.hpp"
 #include "IO/ZipArchive.hpp"
 #include "Util/Compiler.h"
@@ -38,23 +39,65 @@ class OperationEnvironment;
  * Class to manage raster terrain database, potentially with caching
  * or demand-loading.
  */
-class RasterTerrain : public Guard<RasterMap> {
+class RasterTerrain {
 public:
   friend class RoutePlannerGlue; // for route planning
   friend class ProtectedTaskManager; // for intersection
   friend class WaypointVisitorMap; // for intersection rendering
 
+  /**
+   * The default size of the decoded tile cache [MB], see
+   * ProfileKeys::TerrainTileCacheSize.  It is disabled by default on
+   * devices with small and slow flash storage.
+   */
+#if defined(ANDROID) || defined(KOBO)
+  static constexpr unsigned DEFAULT_TILE_CACHE_SIZE = 0;
+#else
+  static constexpr unsigned DEFAULT_TILE_CACHE_SIZE = 256;
+#endif
+
+  /**
+   * A read-only lease on the #RasterMap.  Obtaining it never blocks:
+   * the terrain loader publishes new tiles with atomic pointer swaps,
+   * and frees unloaded tiles only after all leases which might still
+   * see them have been released.
+   */
+  class Lease {
+    const RasterMap &map;
+    RcuDomain::ReadLease rcu;
+
+  public:
+    explicit Lease(const RasterTerrain &terrain) noexcept
+      :map(terrain.map), rcu(terrain.map.GetRcu()) {}
+
+    Lease(const Lease &) = delete;
+
+    operator const RasterMap&() const noexcept {
+      return map;
+    }
+
+    const RasterMap *operator->() const noexcept {
+      return &map;
+    }
+  };
+
 private:
   ZipArchive archive;
 
   RasterMap map;
 
+  /**
+   * Worker threads which decode JPEG2000 tiles in parallel.
+   */
+  ThreadPool decoder_pool;
+
 private:
   /**
    * Constructor.  Returns uninitialised object.
    */
   explicit RasterTerrain(ZipArchive &&_archive)
-    :Guard<RasterMap>(map), archive(std::move(_archive)) {}
+    :archive(std::move(_archive)),
+     decoder_pool("TerrainDecoder", 7, true) {}
 
 public:
   const Serial &GetSerial() const {
@@ -91,6 +134,25 @@ private:
 
   bool SaveCache(FileCache &cache, Path path) const;
 
+  /**
+   * Map the raw terrain file, converting the JPEG2000 file first if
+   * necessary.
+   *
+   * @return true if all tiles are now available
+   */
+  bool OpenRawFile(FileCache &cache, Path path,
+                   OperationEnvironment &operation);
+
+  /**
+   * Enable the raw terrain file (if configured) or the on-disk
+   * cache of decoded tiles.
+   *
+   * @param flush discard the existing tile cache, because the
+   * terrain cache has just been rebuilt
+   */
+  void OpenTileCache(FileCache &cache, Path path, bool flush,
+                     OperationEnvironment &operation);
+
   bool Load(Path path, FileCache *cache,
             OperationEnvironment &operation);
 };
@@ -52,15 +52,15 @@ RasterTile::LoadCache(FILE *file)
   return true;
 }
 
-void
-RasterTile::CopyFrom(const struct jas_matrix &m)
+bool
+RasterTile::ConvertFrom(const struct jas_matrix &m, RasterBuffer &result) const
 {
   if (!IsDefined())
-    return;
+    return false;
 
-  buffer.Resize(width, height);
+  result.Resize(width, height);
 
-  auto *gcc_restrict dest = buffer.GetData();
+  auto *gcc_restrict dest = result.GetData();
   assert(dest != nullptr);
 
   const unsigned width = m.numcols_, height = m.numrows_;
@@ -71,28 +71,28 @@ RasterTile::CopyFrom(const struct jas_matrix &m)
     for (unsigned i = 0; i < width; ++i)
       *dest++ = TerrainHeight(src[i]);
   }
+
+  return true;
 }
 
 TerrainHeight
-RasterTile::GetHeight(unsigned x, unsigned y) const
+RasterTile::GetHeight(const RasterBuffer &data,
+                      unsigned x, unsigned y) const
 {
-  assert(IsEnabled());
-
   x -= xstart;
   y -= ystart;
 
   assert(x < width);
   assert(y < height);
 
-  return buffer.Get(x, y);
+  return data.Get(x, y);
 }
 
 TerrainHeight
-RasterTile::GetInterpolatedHeight(unsigned lx, unsigned ly,
+RasterTile::GetInterpolatedHeight(const RasterBuffer &data,
+                                  unsigned lx, unsigned ly,
                                   unsigned ix, unsigned iy) const
 {
-  assert(IsEnabled());
-
   // we want to exit out of this function as soon as possible
   // if we have the wrong tile
 
@@ -104,7 +104,7 @@ RasterTile::GetInterpolatedHeight(unsigned lx, unsigned ly,
   if ((ly -= ystart) >= height)
     return TerrainHeight::Invalid();
 
-  return buffer.GetInterpolated(lx, ly, ix, iy);
+  return data.GetInterpolated(lx, ly, ix, iy);
 }
 
 inline unsigned
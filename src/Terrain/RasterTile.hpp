@@ -27,6 +27,9 @@ Copyright_License {
 #include "RasterTraits.hpp"
 #include "RasterBuffer.hpp"
 
+#include <atomic>
+#include <memory>
+
 #include <stdio.h>
 
 struct jas_matrix;
@@ -48,10 +51,21 @@ public:
 
   bool request;
 
-  RasterBuffer buffer;
+  /**
+   * The decoded tile data, or nullptr if this tile is not loaded.
+   * A buffer is never modified after it has been published here; it
+   * gets replaced with an atomic pointer swap, and the old one must
+   * be retired (see #RasterTileCache::Retire()), because readers may
+   * still be using it.
+   */
+  std::atomic<RasterBuffer *> buffer;
 
 public:
-  RasterTile() = default;
+  RasterTile():buffer(nullptr) {}
+
+  ~RasterTile() {
+    delete buffer.load(std::memory_order_relaxed);
+  }
 
   RasterTile(const RasterTile &) = delete;
   RasterTile &operator=(const RasterTile &) = delete;
@@ -102,51 +116,89 @@ public:
 
   bool CheckTileVisibility(int view_x, int view_y, unsigned view_radius);
 
-  void Disable() {
-    buffer.Reset();
+  /**
+   * Unload this tile.
+   *
+   * @return the old buffer, which may still be in use by readers
+   */
+  std::unique_ptr<RasterBuffer> Disable() {
+    return std::unique_ptr<RasterBuffer>(buffer.exchange(nullptr));
+  }
+
+  /**
+   * Returns the current buffer, or nullptr if the tile is not
+   * loaded.  The caller must hold a read lease on the
+   * #RasterTileCache's #RcuDomain, and should load the pointer only
+   * once per operation, because it may be replaced at any time.
+   */
+  const RasterBuffer *GetBuffer() const {
+    return buffer.load(std::memory_order_acquire);
   }
 
   bool IsEnabled() const {
-    return buffer.IsDefined();
+    return GetBuffer() != nullptr;
   }
   bool IsDisabled() const {
-    return !buffer.IsDefined();
+    return !IsEnabled();
   }
 
-  void CopyFrom(const struct jas_matrix &m);
+  /**
+   * Convert decoded JPEG2000 data into a new buffer suitable for
+   * SetBuffer().  This does not modify the tile, and may therefore
+   * be called without holding the lock.
+   *
+   * @return false if this tile is not defined
+   */
+  bool ConvertFrom(const struct jas_matrix &m, RasterBuffer &dest) const;
+
+  /**
+   * Enable this tile with the given buffer, previously filled by
+   * ConvertFrom().  It is published with an atomic pointer swap.
+   *
+   * @return the old buffer, which may still be in use by readers
+   */
+  std::unique_ptr<RasterBuffer>
+  SetBuffer(std::unique_ptr<RasterBuffer> &&_buffer) {
+    return std::unique_ptr<RasterBuffer>(buffer.exchange(_buffer.release()));
+  }
 
   /**
    * Determine the non-interpolated height at the specified pixel
    * location.
    *
+   * @param data the value returned by GetBuffer()
    * @param x the pixel column within the tile; may be out of range
    * @param y the pixel row within the tile; may be out of range
    */
   gcc_pure
-  TerrainHeight GetHeight(unsigned x, unsigned y) const;
+  TerrainHeight GetHeight(const RasterBuffer &data,
+                          unsigned x, unsigned y) const;
 
   /**
    * Determine the interpolated height at the specified sub-pixel
    * location.
    *
+   * @param data the value returned by GetBuffer()
    * @param x the pixel column within the tile; may be out of range
    * @param y the pixel row within the tile; may be out of range
    * @param ix the sub-pixel column for interpolation (0..255)
    * @param iy the sub-pixel row for interpolation (0..255)
    */
   gcc_pure
-  TerrainHeight GetInterpolatedHeight(unsigned x, unsigned y,
+  TerrainHeight GetInterpolatedHeight(const RasterBuffer &data,
+                                      unsigned x, unsigned y,
                                       unsigned ix, unsigned iy) const;
 
   bool VisibilityChanged(int view_x, int view_y, unsigned view_radius);
 
-  void ScanLine(unsigned ax, unsigned ay, unsigned bx, unsigned by,
+  void ScanLine(const RasterBuffer &data,
+                unsigned ax, unsigned ay, unsigned bx, unsigned by,
                 TerrainHeight *dest, unsigned size, bool interpolate) const {
-    buffer.ScanLine(ax - (xstart << RasterTraits::SUBPIXEL_BITS),
-                    ay - (ystart << RasterTraits::SUBPIXEL_BITS),
-                    bx - (xstart << RasterTraits::SUBPIXEL_BITS),
-                    by - (ystart << RasterTraits::SUBPIXEL_BITS),
-                    dest, size, interpolate);
+    data.ScanLine(ax - (xstart << RasterTraits::SUBPIXEL_BITS),
+                  ay - (ystart << RasterTraits::SUBPIXEL_BITS),
+                  bx - (xstart << RasterTraits::SUBPIXEL_BITS),
+                  by - (ystart << RasterTraits::SUBPIXEL_BITS),
+                  dest, size, interpolate);
   }
 };
 
@@ -24,6 +24,7 @@ Copyright_License {
 #include "RasterTileCache.hpp"
 #include "Math/Angle.hpp"
 #include "Math/FastMath.hpp"
+#include "OS/FileMapping.hpp"
 
 extern "C" {
 #include "jasper/jas_seq.h"
@@ -31,6 +32,14 @@ extern "C" {
 
 #include <string.h>
 #include <algorithm>
+#include <vector>
+
+RasterTileCache::RasterTileCache()
+{
+  Reset();
+}
+
+RasterTileCache::~RasterTileCache() = default;
 
 static void
 CopyOverviewRow(TerrainHeight *gcc_restrict dest, const jas_seqent_t *gcc_restrict src,
@@ -41,32 +50,42 @@ CopyOverviewRow(TerrainHeight *gcc_restrict dest, const jas_seqent_t *gcc_restri
     *dest++ = TerrainHeight(*src);
 }
 
-void
-RasterTileCache::PutOverviewTile(unsigned index,
-                                 unsigned start_x, unsigned start_y,
-                                 unsigned end_x, unsigned end_y,
-                                 const struct jas_matrix &m)
+/**
+ * Shift a pixel size by the given number of bits, rounding up.
+ */
+static constexpr unsigned
+ShiftCeil(unsigned x, unsigned shift)
 {
-  tiles.GetLinear(index).Set(start_x, start_y, end_x, end_y);
+  return (x + (1u << shift) - 1) >> shift;
+}
 
-  const unsigned dest_pitch = overview.GetWidth();
+/**
+ * Copy every (1 << shift)th pixel of a decoded tile into the
+ * overview.
+ */
+static void
+PutReducedTile(RasterBuffer &buffer, unsigned shift,
+               unsigned start_x, unsigned start_y,
+               const struct jas_matrix &m)
+{
+  const unsigned dest_pitch = buffer.GetWidth();
 
-  start_x = RasterTraits::ToOverview(start_x);
-  start_y = RasterTraits::ToOverview(start_y);
+  start_x >>= shift;
+  start_y >>= shift;
 
-  if (start_x >= overview.GetWidth() || start_y >= overview.GetHeight())
+  if (start_x >= buffer.GetWidth() || start_y >= buffer.GetHeight())
     return;
 
-  unsigned width = RasterTraits::ToOverviewCeil(m.numcols_);
-  if (start_x + width > overview.GetWidth())
-    width = overview.GetWidth() - start_x;
-  unsigned height = RasterTraits::ToOverviewCeil(m.numrows_);
-  if (start_y + height > overview.GetHeight())
-    height = overview.GetHeight() - start_y;
+  unsigned width = ShiftCeil(m.numcols_, shift);
+  if (start_x + width > buffer.GetWidth())
+    width = buffer.GetWidth() - start_x;
+  unsigned height = ShiftCeil(m.numrows_, shift);
+  if (start_y + height > buffer.GetHeight())
+    height = buffer.GetHeight() - start_y;
 
-  const unsigned skip = 1 << OVERVIEW_BITS;
+  const unsigned skip = 1 << shift;
 
-  auto *gcc_restrict dest = overview.GetData()
+  auto *gcc_restrict dest = buffer.GetData()
     + start_y * dest_pitch + start_x;
 
   /* note: this loop rounds up */
@@ -74,15 +93,181 @@ RasterTileCache::PutOverviewTile(unsigned index,
     CopyOverviewRow(dest, m.rows_[y], width, skip);
 }
 
+/**
+ * Accumulates the pixels of one block for the box filter.  Special
+ * values (invalid or water) are not mixed with heights: the block
+ * becomes special only if most of its pixels are.
+ */
+class BoxSum {
+  int sum = 0;
+  unsigned n_heights = 0, n_special = 0;
+  TerrainHeight special = TerrainHeight::Invalid();
+
+public:
+  void Add(TerrainHeight h) {
+    if (h.IsSpecial()) {
+      if (n_special++ == 0)
+        special = h;
+    } else {
+      sum += h.GetValue();
+      ++n_heights;
+    }
+  }
+
+  TerrainHeight Get() const {
+    return n_special > n_heights
+      ? special
+      : TerrainHeight(int16_t(sum / int(n_heights)));
+  }
+};
+
+/**
+ * Halve the resolution of an image by averaging each 2x2 block of
+ * pixels.  Blocks in the last row/column of an image with an odd
+ * size are averaged over the pixels which exist.
+ *
+ * @param get a function returning the pixel at the given position
+ */
+template<typename F>
+static void
+ReduceBox(TerrainHeight *gcc_restrict dest,
+          unsigned src_width, unsigned src_height, F &&get)
+{
+  for (unsigned y = 0; y < src_height; y += 2) {
+    const bool has_next_row = y + 1 < src_height;
+
+    for (unsigned x = 0; x < src_width; x += 2) {
+      const bool has_next_column = x + 1 < src_width;
+
+      BoxSum box;
+      box.Add(get(x, y));
+      if (has_next_column)
+        box.Add(get(x + 1, y));
+      if (has_next_row) {
+        box.Add(get(x, y + 1));
+        if (has_next_column)
+          box.Add(get(x + 1, y + 1));
+      }
+
+      *dest++ = box.Get();
+    }
+  }
+}
+
+/**
+ * Copy a reduced tile into a pyramid level.
+ */
+static void
+PutReducedTile(RasterBuffer &buffer, unsigned shift,
+               unsigned start_x, unsigned start_y,
+               const TerrainHeight *src, unsigned width, unsigned height)
+{
+  const unsigned dest_pitch = buffer.GetWidth(), src_pitch = width;
+
+  start_x >>= shift;
+  start_y >>= shift;
+
+  if (start_x >= buffer.GetWidth() || start_y >= buffer.GetHeight())
+    return;
+
+  if (start_x + width > buffer.GetWidth())
+    width = buffer.GetWidth() - start_x;
+  if (start_y + height > buffer.GetHeight())
+    height = buffer.GetHeight() - start_y;
+
+  auto *gcc_restrict dest = buffer.GetData()
+    + start_y * dest_pitch + start_x;
+
+  for (unsigned i = 0; i < height; ++i, src += src_pitch, dest += dest_pitch)
+    std::copy_n(src, width, dest);
+}
+
 void
-RasterTileCache::PutTileData(unsigned index,
-                             const struct jas_matrix &m)
+RasterTileCache::PutPyramidTile(unsigned start_x, unsigned start_y,
+                                const struct jas_matrix &m)
+{
+  /* the first level is box-filtered from the decoded tile, and each
+     following level from the one below */
+  unsigned width = ShiftCeil(m.numcols_, 1);
+  unsigned height = ShiftCeil(m.numrows_, 1);
+  std::vector<TerrainHeight> level(width * height), next;
+  ReduceBox(level.data(), m.numcols_, m.numrows_,
+            [&m](unsigned x, unsigned y){
+              return TerrainHeight(m.rows_[y][x]);
+            });
+
+  for (unsigned i = 0;; ++i) {
+    if (pyramid[i].IsDefined())
+      PutReducedTile(pyramid[i], i + 1, start_x, start_y,
+                     level.data(), width, height);
+
+    if (i + 1 == PYRAMID_LEVELS)
+      break;
+
+    next.resize(ShiftCeil(width, 1) * ShiftCeil(height, 1));
+    ReduceBox(next.data(), width, height,
+              [&level, width](unsigned x, unsigned y){
+                return level[y * width + x];
+              });
+
+    level.swap(next);
+    width = ShiftCeil(width, 1);
+    height = ShiftCeil(height, 1);
+  }
+}
+
+void
+RasterTileCache::PutOverviewTile(unsigned index,
+                                 unsigned start_x, unsigned start_y,
+                                 unsigned end_x, unsigned end_y,
+                                 const struct jas_matrix &m)
+{
+  tiles.GetLinear(index).Set(start_x, start_y, end_x, end_y);
+
+  PutReducedTile(overview, OVERVIEW_BITS, start_x, start_y, m);
+
+  PutPyramidTile(start_x, start_y, m);
+}
+
+bool
+RasterTileCache::ConvertTileData(unsigned index, const struct jas_matrix &m,
+                                 RasterBuffer &buffer) const
+{
+  const auto &tile = tiles.GetLinear(index);
+  return tile.IsRequested() && tile.ConvertFrom(m, buffer);
+}
+
+void
+RasterTileCache::PutTileData(unsigned index, RasterBuffer &&buffer)
 {
   auto &tile = tiles.GetLinear(index);
   if (!tile.IsRequested())
     return;
 
-  tile.CopyFrom(m);
+  std::unique_ptr<RasterBuffer> p(new RasterBuffer(std::move(buffer)));
+  Retire(tile.SetBuffer(std::move(p)));
+}
+
+void
+RasterTileCache::Retire(std::unique_ptr<RasterBuffer> &&buffer)
+{
+  if (buffer == nullptr)
+    return;
+
+  const std::lock_guard<Mutex> lock(retire_mutex);
+  retired.emplace_back(std::move(buffer));
+}
+
+void
+RasterTileCache::Reclaim()
+{
+  const std::lock_guard<Mutex> lock(retire_mutex);
+  if (!rcu.TryFlip())
+    /* readers from the previous epoch are still active */
+    return;
+
+  expired.clear();
+  expired.swap(retired);
 }
 
 struct RTDistanceSort {
@@ -101,20 +286,20 @@ struct RTDistanceSort {
 bool
 RasterTileCache::PollTiles(int x, int y, unsigned radius)
 {
+  if (IsMapped()) {
+    /* all tiles are always available */
+    dirty = false;
+    return false;
+  }
+
+  Reclaim();
+
   /* tiles are usually 256 pixels wide; with a radius smaller than
      that, the (optimized) tile distance calculations may fail;
      additionally, this ensures that tiles which are slightly out of
      the screen will be loaded in advance */
   radius += 256;
 
-  /**
-   * Maximum number of tiles loaded at a time, to reduce system load
-   * peaks.
-   */
-  constexpr unsigned MAX_ACTIVATE = MAX_ACTIVE_TILES > 32
-    ? 16
-    : MAX_ACTIVE_TILES / 2;
-
   /* query all tiles; all tiles which are either in range or already
      loaded are added to RequestTiles */
 
@@ -133,7 +318,7 @@ RasterTileCache::PollTiles(int x, int y, unsigned radius)
     /* dispose all tiles which are out of range */
     for (unsigned i = MAX_ACTIVE_TILES; i < request_tiles.size(); ++i) {
       RasterTile &tile = tiles.GetLinear(request_tiles[i]);
-      tile.Disable();
+      Retire(tile.Disable());
     }
 
     request_tiles.shrink(MAX_ACTIVE_TILES);
@@ -168,8 +353,9 @@ RasterTileCache::GetHeight(unsigned px, unsigned py) const
     return TerrainHeight::Invalid();
 
   const RasterTile &tile = tiles.Get(px / tile_width, py / tile_height);
-  if (tile.IsEnabled())
-    return tile.GetHeight(px, py);
+  const RasterBuffer *data = tile.GetBuffer();
+  if (data != nullptr)
+    return tile.GetHeight(*data, px, py);
 
   // still not found, so go to overview
   return overview.GetInterpolated(px << (RasterTraits::SUBPIXEL_BITS - RasterTraits::OVERVIEW_BITS),
@@ -188,8 +374,9 @@ RasterTileCache::GetInterpolatedHeight(unsigned int lx, unsigned int ly) const
   const unsigned int iy = CombinedDivAndMod(py);
 
   const RasterTile &tile = tiles.Get(px / tile_width, py / tile_height);
-  if (tile.IsEnabled())
-    return tile.GetInterpolatedHeight(px, py, ix, iy);
+  const RasterBuffer *data = tile.GetBuffer();
+  if (data != nullptr)
+    return tile.GetInterpolatedHeight(*data, px, py, ix, iy);
 
   // still not found, so go to overview
   return overview.GetInterpolated(RasterTraits::ToOverview(lx),
@@ -213,6 +400,20 @@ RasterTileCache::SetSize(unsigned _width, unsigned _height,
   overview_width_fine = width << RasterTraits::SUBPIXEL_BITS;
   overview_height_fine = height << RasterTraits::SUBPIXEL_BITS;
 
+  /* the coarsest level is always allocated; MAX_PYRAMID_PIXELS only
+     limits how fine the finest level may be */
+  fallback_shift = OVERVIEW_BITS;
+  for (unsigned i = PYRAMID_LEVELS; i-- > 0;) {
+    const unsigned level_width = ShiftCeil(width, i + 1);
+    const unsigned level_height = ShiftCeil(height, i + 1);
+    if (i + 1 == PYRAMID_LEVELS ||
+        uint64_t(level_width) * level_height <= MAX_PYRAMID_PIXELS) {
+      pyramid[i].Resize(level_width, level_height);
+      fallback_shift = i + 1;
+    } else
+      pyramid[i].Reset();
+  }
+
   tiles.GrowDiscard(tile_columns, tile_rows);
 }
 
@@ -240,9 +441,22 @@ RasterTileCache::Reset()
   segments.clear();
 
   overview.Reset();
+  for (auto &level : pyramid)
+    level.Reset();
+  fallback_shift = OVERVIEW_BITS;
 
+  /* this must not be called while there are readers, so the tile
+     buffers can be freed right away */
   for (auto it = tiles.begin(), end = tiles.end(); it != end; ++it)
     it->Disable();
+
+  retired.clear();
+  expired.clear();
+
+  /* the tiles don't refer to the mapping anymore */
+  raw_mapping.reset();
+
+  disk_cache.Close();
 }
 
 const RasterTileCache::MarkerSegmentInfo *
@@ -271,6 +485,78 @@ RasterTileCache::FinishTileUpdate()
   ++serial;
 }
 
+bool
+RasterTileCache::OpenDiskCache(Path path, uint64_t budget)
+{
+  if (!IsValid())
+    return false;
+
+  return disk_cache.Open(path, width, height, tile_width, tile_height,
+                         tiles.GetSize(), budget);
+}
+
+RasterTileCache::RawHeader
+RasterTileCache::MakeRawHeader() const
+{
+  RawHeader header;
+
+  /* zero-fill all implicit padding bytes, to allow comparing with
+     memcmp() */
+  memset(&header, 0, sizeof(header));
+
+  header.magic = RawHeader::MAGIC;
+  header.version = RawHeader::VERSION;
+  header.width = width;
+  header.height = height;
+  header.tile_width = tile_width;
+  header.tile_height = tile_height;
+  header.tile_columns = tiles.GetWidth();
+  header.tile_rows = tiles.GetHeight();
+  header.bounds = bounds;
+  return header;
+}
+
+bool
+RasterTileCache::OpenRawFile(Path path, uint64_t offset)
+{
+  if (!IsValid())
+    return false;
+
+  std::unique_ptr<FileMapping> mapping(new FileMapping(path));
+  if (mapping->error())
+    return false;
+
+  const RawHeader header = MakeRawHeader();
+  const uint64_t data_offset = offset + sizeof(header);
+  const uint64_t data_size = ForEachRawTile([](unsigned, uint64_t){});
+  if (data_offset + data_size > mapping->size() ||
+      memcmp(mapping->at(offset), &header, sizeof(header)) != 0)
+    return false;
+
+  const auto *data = (const uint8_t *)mapping->at(data_offset);
+  if (uintptr_t(data) % alignof(TerrainHeight) != 0)
+    return false;
+
+  raw_mapping = std::move(mapping);
+
+  ForEachRawTile([this, data](unsigned i, uint64_t tile_offset){
+      RasterTile &tile = tiles.GetLinear(i);
+      std::unique_ptr<RasterBuffer> buffer(new RasterBuffer());
+      buffer->SetExternal((const TerrainHeight *)(data + tile_offset),
+                          tile.width, tile.height);
+      Retire(tile.SetBuffer(std::move(buffer)));
+      tile.ClearRequest();
+    });
+
+  /* there are no more tiles to be loaded */
+  dirty = false;
+  request_tiles.clear();
+  disk_cache.Close();
+
+  ++serial;
+  return true;
+}
+
 bool
 RasterTileCache::SaveCache(FILE *file) const
 {
@@ -318,6 +604,18 @@ RasterTileCache::SaveCache(FILE *file) const
              overview_size, file) != overview_size)
     return false;
 
+  /* save pyramid levels; which of them exist is determined by the
+     header */
+  for (const auto &level : pyramid) {
+    if (!level.IsDefined())
+      continue;
+
+    const size_t level_size = level.GetWidth() * level.GetHeight();
+    if (fwrite(level.GetData(), sizeof(*level.GetData()),
+               level_size, file) != level_size)
+      return false;
+  }
+
   /* done */
   return true;
 }
@@ -378,5 +676,16 @@ RasterTileCache::LoadCache(FILE *file)
             overview_size, file) != overview_size)
     return false;
 
+  /* load pyramid levels */
+  for (auto &level : pyramid) {
+    if (!level.IsDefined())
+      continue;
+
+    const size_t level_size = level.GetWidth() * level.GetHeight();
+    if (fread(level.GetData(), sizeof(*level.GetData()),
+              level_size, file) != level_size)
+      return false;
+  }
+
   return true;
 }
@@ -27,10 +27,16 @@ Copyright_License {
 #include "RasterTraits.hpp"
 #include "RasterTile.hpp"
 #include "RasterLocation.hpp"
+#include "TileDiskCache.hpp"
 #include "Geo/GeoBounds.hpp"
+#include "Thread/RcuDomain.hpp"
+#include "Thread/Mutex.hxx"
 #include "Util/StaticArray.hxx"
+#include "Util/AllocatedGrid.hxx"
 #include "Util/Serial.hpp"
 
+#include <memory>
+#include <vector>
 #include <cassert>
 #include <stdio.h>
 #include <cstdint>
@@ -39,6 +45,7 @@ Copyright_License {
 
 struct jas_matrix;
 struct GridLocation;
+class FileMapping;
 
 class RasterTileCache {
   static constexpr unsigned MAX_RTC_TILES = 4096;
@@ -54,6 +61,16 @@ class RasterTileCache {
   static constexpr unsigned MAX_ACTIVE_TILES = 512;
 #endif
 
+public:
+  /**
+   * Maximum number of tiles loaded at a time, to reduce system load
+   * peaks.
+   */
+  static constexpr unsigned MAX_ACTIVATE = MAX_ACTIVE_TILES > 32
+    ? 16
+    : MAX_ACTIVE_TILES / 2;
+
+private:
   /**
    * The width and height of the terrain bitmap is shifted by this
    * number of bits to determine the overview size.
@@ -62,6 +79,24 @@ class RasterTileCache {
 
   static constexpr unsigned OVERVIEW_MASK = (~0u) << OVERVIEW_BITS;
 
+  /**
+   * The number of intermediate resolutions between the tiles and the
+   * overview.  Level i is the terrain bitmap shifted by i+1 bits.
+   */
+  static constexpr unsigned PYRAMID_LEVELS = OVERVIEW_BITS - 1;
+
+  /**
+   * Pyramid levels with more pixels than this are not allocated,
+   * because the amount of memory is finite.  This caps only the
+   * finest level: the coarsest one is always allocated, because it
+   * is just four times as large as the #overview.
+   */
+#if defined(ANDROID) || defined(KOBO)
+  static constexpr unsigned MAX_PYRAMID_PIXELS = 1024 * 1024;
+#else
+  static constexpr unsigned MAX_PYRAMID_PIXELS = 4 * 1024 * 1024;
+#endif
+
   /**
    * Target number of steps in intersection searches; total distance
    * is shifted by this number of bits
@@ -101,7 +136,7 @@ protected:
   };
 
   struct CacheHeader {
-    static constexpr unsigned VERSION = 0xb;
+    static constexpr unsigned VERSION = 0xd;
 
     unsigned version;
     unsigned width, height;
@@ -111,6 +146,23 @@ protected:
     GeoBounds bounds;
   };
 
+  /**
+   * The header of a "raw" terrain file, which contains all tiles as
+   * uncompressed rows of #TerrainHeight values, in tile index order.
+   * It describes the same raster geometry as #CacheHeader, and is
+   * compared with the current geometry before the file is used.
+   */
+  struct RawHeader {
+    static constexpr unsigned MAGIC = 0x52415754;
+    static constexpr unsigned VERSION = 1;
+
+    unsigned magic, version;
+    unsigned width, height;
+    unsigned short tile_width, tile_height;
+    unsigned tile_columns, tile_rows;
+    GeoBounds bounds;
+  };
+
   bool dirty;
 
   /**
@@ -126,10 +178,37 @@ protected:
   unsigned int width, height;
   unsigned int overview_width_fine, overview_height_fine;
 
+  /**
+   * Reduced-resolution copies of the whole terrain (like a mipmap),
+   * box-filtered while the overview is loaded.  They are used to
+   * render zoomed-out views and as a finer fallback than the
+   * #overview for tiles which are not loaded.  Levels (except the
+   * coarsest) which would exceed #MAX_PYRAMID_PIXELS are undefined.
+   */
+  RasterBuffer pyramid[PYRAMID_LEVELS];
+
+  /**
+   * The number of bits of the finest available reduced resolution
+   * (a pyramid level or the overview).
+   */
+  unsigned fallback_shift;
+
   GeoBounds bounds;
 
   StaticArray<MarkerSegmentInfo, 8192> segments;
 
+  /**
+   * An optional on-disk cache of decoded tiles.  It is consulted
+   * before decoding a tile from the JPEG2000 file.
+   */
+  TileDiskCache disk_cache;
+
+  /**
+   * If this is set, then all tiles refer to this mapping of a raw
+   * terrain file, and there is no need to load tiles on demand.
+   */
+  std::unique_ptr<FileMapping> raw_mapping;
+
   /**
    * An array that is used to sort the requested tiles by distance.
    * This is only used by PollTiles() internally, but is stored in the
@@ -137,10 +216,33 @@ protected:
    */
   StaticArray<uint16_t, MAX_RTC_TILES> request_tiles;
 
+  /**
+   * Readers of the tile buffers hold a read lease on this domain.
+   * Tiles are published and unloaded with atomic pointer swaps
+   * instead of an exclusive lock, so readers never wait for the
+   * loader.
+   */
+  mutable RcuDomain rcu;
+
+  /**
+   * Protects #retired and #expired.
+   */
+  Mutex retire_mutex;
+
+  /**
+   * Buffers which were unloaded during the current epoch of #rcu.
+   */
+  std::vector<std::unique_ptr<RasterBuffer>> retired;
+
+  /**
+   * Buffers which were unloaded during the previous epoch of #rcu;
+   * they are freed when the next epoch begins.
+   */
+  std::vector<std::unique_ptr<RasterBuffer>> expired;
+
 public:
-  RasterTileCache() {
-    Reset();
-  }
+  RasterTileCache();
+  ~RasterTileCache();
 
   RasterTileCache(const RasterTileCache &) = delete;
   RasterTileCache &operator=(const RasterTileCache &) = delete;
@@ -152,6 +254,38 @@ public:
   }
 
 protected:
+  /**
+   * Box-filter a decoded tile into the defined #pyramid levels.
+   */
+  void PutPyramidTile(unsigned start_x, unsigned start_y,
+                      const struct jas_matrix &m);
+
+  /**
+   * Returns the reduced resolution buffer with the given number of
+   * bits (1 to #OVERVIEW_BITS), or nullptr if that pyramid level is
+   * not available.
+   */
+  gcc_pure
+  const RasterBuffer *GetLevel(unsigned shift) const {
+    assert(shift > 0 && shift <= OVERVIEW_BITS);
+
+    const RasterBuffer &level = shift < OVERVIEW_BITS
+      ? pyramid[shift - 1]
+      : overview;
+    return level.IsDefined() ? &level : nullptr;
+  }
+
+  /**
+   * Returns the coarsest available pyramid level whose resolution
+   * is still at least as fine as the given sample distance.
+   *
+   * @param step the distance between two samples [sub-pixels]
+   * @return the number of bits of the level, or 0 for full
+   * resolution
+   */
+  gcc_pure
+  unsigned FindLevel(unsigned step) const;
+
   void ScanTileLine(GridLocation start, GridLocation end,
                     TerrainHeight *buffer, unsigned size,
                     bool interpolate) const;
@@ -197,6 +331,34 @@ public:
                          RasterLocation &_location, int &h_int,
                          const bool can_climb) const;
 
+  /**
+   * The parameters and the result of one line for the batched
+   * FirstIntersection().
+   */
+  struct FirstIntersectionLine {
+    SignedRasterLocation origin, destination;
+    int h_origin, h_dest, slope_fact;
+    bool can_climb;
+
+    /**
+     * The return value of FirstIntersection().
+     */
+    bool intersecting;
+
+    RasterLocation location;
+    int h;
+  };
+
+  /**
+   * Batched version of FirstIntersection() for many unrelated lines,
+   * e.g. the pending links of the route planner.  The lines are
+   * sorted by the tile containing their origin, and are walked in
+   * that order sharing one tile cursor, so most lookups hit the tile
+   * used by the previous line.
+   */
+  void FirstIntersection(FirstIntersectionLine *lines, unsigned n,
+                         int h_ceiling, int h_safety) const;
+
   /**
    * @return {-1,-1} if no intersection was found
    */
@@ -205,22 +367,163 @@ public:
                int h_origin, const int slope_fact,
                const int height_floor) const;
 
+  /**
+   * The parameters and the result of one line for the batched
+   * Intersection().
+   */
+  struct IntersectionLine {
+    SignedRasterLocation origin, destination;
+    int h_origin, slope_fact;
+
+    /**
+     * The return value of Intersection(), i.e. {-1,-1} if no
+     * intersection was found.
+     */
+    SignedRasterLocation location;
+  };
+
+  /**
+   * Batched version of Intersection(), e.g. for the radials of a
+   * reach fan.  The lines are walked in the same order as the
+   * batched FirstIntersection().
+   */
+  void Intersection(IntersectionLine *lines, unsigned n,
+                    int height_floor) const;
+
 private:
+  /**
+   * Remembers the tile which was looked up by the previous
+   * GetFieldDirect() call.  Walking along a line usually stays in
+   * the same tile for many steps, and this avoids looking it up
+   * again for each step.
+   */
+  struct TileCursor {
+    const RasterTile *tile = nullptr;
+
+    /**
+     * The buffer of #tile at the time it was looked up.
+     */
+    const RasterBuffer *data;
+
+    /**
+     * The top left pixel of the #tiles cell which contains #tile.
+     */
+    unsigned x, y;
+  };
+
   /**
    * Get field (not interpolated) directly, without bringing tiles to front.
    * @param px X position/256
    * @param px Y position/256
-   * @param tile_index Remember position of active tile, or -1 for overview
+   * @param cursor remembers the tile for the next call
    * @return the terrain altitude and a flag that is true when the
    * value was loaded from a "fine" tile
    */
-  gcc_pure
-  std::pair<TerrainHeight, bool> GetFieldDirect(unsigned px, unsigned py) const;
+  std::pair<TerrainHeight, bool> GetFieldDirect(unsigned px, unsigned py,
+                                                TileCursor &cursor) const;
+
+  /**
+   * Determine the order in which the batched FirstIntersection() and
+   * Intersection() walk their lines: sorted by the tile containing
+   * the origin, lines starting outside the map last.
+   *
+   * @return the line indices in walking order
+   */
+  template<typename L>
+  std::vector<unsigned> SortByOriginTile(const L *lines, unsigned n) const;
+
+  bool FirstIntersection(SignedRasterLocation origin,
+                         SignedRasterLocation destination,
+                         int h_origin, int h_dest,
+                         int slope_fact, int h_ceiling, int h_safety,
+                         RasterLocation &_location, int &h_int,
+                         bool can_climb, TileCursor &cursor) const;
+
+  SignedRasterLocation
+  Intersection(SignedRasterLocation origin, SignedRasterLocation destination,
+               int h_origin, const int slope_fact,
+               const int height_floor, TileCursor &cursor) const;
 
 public:
   bool SaveCache(FILE *file) const;
   bool LoadCache(FILE *file);
 
+  /**
+   * Enable the on-disk cache of decoded tiles.  Call this after the
+   * overview has been loaded.
+   *
+   * @param budget the maximum size of the cache file [bytes]
+   */
+  bool OpenDiskCache(Path path, uint64_t budget);
+
+  /**
+   * Are all tiles backed by a memory-mapped raw terrain file?
+   */
+  bool IsMapped() const {
+    return raw_mapping != nullptr;
+  }
+
+  /**
+   * Generate the header of a raw terrain file for the current
+   * raster geometry.
+   */
+  gcc_pure
+  RawHeader MakeRawHeader() const;
+
+  /**
+   * Invoke the function for each defined tile with the position of
+   * its data in a raw terrain file (relative to the end of the
+   * #RawHeader).
+   *
+   * @return the total size of the tile data [bytes]
+   */
+  template<typename F>
+  uint64_t ForEachRawTile(F &&f) const {
+    uint64_t offset = 0;
+    for (unsigned i = 0, n = tiles.GetSize(); i < n; ++i) {
+      const RasterTile &tile = tiles.GetLinear(i);
+      if (!tile.IsDefined())
+        continue;
+
+      f(i, offset);
+      offset += uint64_t(tile.width) * tile.height * sizeof(TerrainHeight);
+    }
+
+    return offset;
+  }
+
+  unsigned GetTileCount() const {
+    return tiles.GetSize();
+  }
+
+  /**
+   * Invoke the function f(i, xstart, ystart, xend, yend, enabled) for
+   * each defined tile with its index, its rectangle [coarse pixels]
+   * and whether its data is currently loaded.  The loader may
+   * change the "enabled" flag at any time.
+   */
+  template<typename F>
+  void ForEachTile(F &&f) const {
+    for (unsigned i = 0, n = tiles.GetSize(); i < n; ++i) {
+      const RasterTile &tile = tiles.GetLinear(i);
+      if (tile.IsDefined())
+        f(i, tile.xstart, tile.ystart, tile.xend, tile.yend,
+          tile.IsEnabled());
+    }
+  }
+
+  /**
+   * Map a raw terrain file (see ConvertTerrainTiles()) and let all
+   * tiles refer to it.  After that, heights can be read from all
+   * tiles without decoding anything, and PollTiles() does nothing.
+   * Call this after the overview has been loaded.
+   *
+   * @param offset the position of the #RawHeader within the file
+   * @return false if the file could not be mapped or does not match
+   * the current raster geometry
+   */
+  bool OpenRawFile(Path path, uint64_t offset);
+
   /**
    * Determines if there are still tiles scheduled to be loaded.  Call
    * this after UpdateTiles() to determine if UpdateTiles() should be
@@ -238,6 +541,14 @@ public:
     return serial;
   }
 
+  /**
+   * Returns the domain which readers must hold a read lease on while
+   * they access this object concurrently with the loader.
+   */
+  RcuDomain &GetRcu() const {
+    return rcu;
+  }
+
   void Reset();
 
   const GeoBounds &GetBounds() const {
@@ -274,12 +585,55 @@ public:
                        unsigned end_x, unsigned end_y,
                        const struct jas_matrix &m);
 
+  /**
+   * Mark tiles near the given location as requested.
+   *
+   * @return true if at least one tile was requested
+   */
   bool PollTiles(int x, int y, unsigned radius);
 
-  void PutTileData(unsigned index, const struct jas_matrix &m);
+  /**
+   * Collect the tiles which were requested by the last PollTiles()
+   * call and are not yet loaded.
+   */
+  template<typename F>
+  void ForEachRequestedTile(F &&f) const {
+    for (const auto i : request_tiles) {
+      const RasterTile &tile = tiles.GetLinear(i);
+      if (tile.IsRequested() && !tile.IsEnabled())
+        f(i);
+    }
+  }
+
+  /**
+   * Convert decoded tile data into a #RasterBuffer.  This does not
+   * modify the cache and may be called without holding the lock.
+   *
+   * @return false if the tile was not requested
+   */
+  bool ConvertTileData(unsigned index, const struct jas_matrix &m,
+                       RasterBuffer &buffer) const;
+
+  /**
+   * Publish a tile buffer previously filled by ConvertTileData().
+   * This may be called from several loader threads at a time, and
+   * does not block readers.
+   */
+  void PutTileData(unsigned index, RasterBuffer &&buffer);
 
   void FinishTileUpdate();
 
+private:
+  /**
+   * Free the given buffer as soon as no reader can see it anymore.
+   */
+  void Retire(std::unique_ptr<RasterBuffer> &&buffer);
+
+  /**
+   * Free retired buffers which are not used by readers anymore.
+   */
+  void Reclaim();
+
 public:
   TerrainHeight GetMaxElevation() const {
     return overview.GetMaximum();
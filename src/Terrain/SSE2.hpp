@@ -0,0 +1,150 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_TERRAIN_SSE2_HPP
+#define XCSOAR_TERRAIN_SSE2_HPP
+
+#include "Height.hpp"
+#include "Util/Compiler.h"
+
+#ifndef __SSE2__
+#error SSE2 required
+#endif
+
+#include <emmintrin.h>
+
+#include <cstdint>
+
+#if CLANG_OR_GCC_VERSION(4,8)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-align"
+#endif
+
+/**
+ * Implementation of the bilinear height interpolation using Intel
+ * SSE2 instructions.  It processes 8 samples at a time.
+ */
+class SSE2HeightInterpolation {
+  gcc_always_inline
+  static __m128i Load(const void *p) {
+    return _mm_loadu_si128((const __m128i *)p);
+  }
+
+  /**
+   * Calculate "v0 * w0 + v1 * w1" for 8 pairs of 16 bit integers,
+   * returning two vectors of 4 32 bit integers.
+   */
+  gcc_always_inline
+  static void MultiplyAdd(__m128i v0, __m128i v1, __m128i w0, __m128i w1,
+                          __m128i &lo, __m128i &hi) {
+    lo = _mm_madd_epi16(_mm_unpacklo_epi16(v0, v1),
+                        _mm_unpacklo_epi16(w0, w1));
+    hi = _mm_madd_epi16(_mm_unpackhi_epi16(v0, v1),
+                        _mm_unpackhi_epi16(w0, w1));
+  }
+
+public:
+  /**
+   * Interpolate 8 samples.
+   *
+   * @param a the top left neighbours
+   * @param b the top right neighbours
+   * @param c the bottom left neighbours
+   * @param d the bottom right neighbours
+   * @param ix the horizontal sub-pixel positions (0..255)
+   * @param iy the vertical sub-pixel positions (0..255)
+   */
+  gcc_hot gcc_always_inline
+  static void Interpolate8(const int16_t *gcc_restrict a,
+                           const int16_t *gcc_restrict b,
+                           const int16_t *gcc_restrict c,
+                           const int16_t *gcc_restrict d,
+                           const uint16_t *gcc_restrict ix,
+                           const uint16_t *gcc_restrict iy,
+                           TerrainHeight *gcc_restrict dest) {
+    const __m128i va = Load(a), vb = Load(b), vc = Load(c), vd = Load(d);
+
+    const __m128i v256 = _mm_set1_epi16(0x100);
+    const __m128i vix = Load(ix), viy = Load(iy);
+    const __m128i vkx = _mm_sub_epi16(v256, vix);
+    const __m128i vky = _mm_sub_epi16(v256, viy);
+
+    /* horizontal pass: 32 bit rows "a*kx + b*ix" and "c*kx + d*ix" */
+    __m128i row0_lo, row0_hi, row1_lo, row1_hi;
+    MultiplyAdd(va, vb, vkx, vix, row0_lo, row0_hi);
+    MultiplyAdd(vc, vd, vkx, vix, row1_lo, row1_hi);
+
+    /* vertical pass: SSE2 can't multiply 32 bit integers, therefore
+       split each row into its upper bits and its lower 8 bits, which
+       both fit into 16 bit, and multiply those separately */
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i row0_h = _mm_packs_epi32(_mm_srai_epi32(row0_lo, 8),
+                                           _mm_srai_epi32(row0_hi, 8));
+    const __m128i row1_h = _mm_packs_epi32(_mm_srai_epi32(row1_lo, 8),
+                                           _mm_srai_epi32(row1_hi, 8));
+    const __m128i row0_l = _mm_packs_epi32(_mm_and_si128(row0_lo, mask),
+                                           _mm_and_si128(row0_hi, mask));
+    const __m128i row1_l = _mm_packs_epi32(_mm_and_si128(row1_lo, mask),
+                                           _mm_and_si128(row1_hi, mask));
+
+    __m128i h_lo, h_hi, l_lo, l_hi;
+    MultiplyAdd(row0_h, row1_h, vky, viy, h_lo, h_hi);
+    MultiplyAdd(row0_l, row1_l, vky, viy, l_lo, l_hi);
+
+    const __m128i sum_lo = _mm_add_epi32(_mm_slli_epi32(h_lo, 8), l_lo);
+    const __m128i sum_hi = _mm_add_epi32(_mm_slli_epi32(h_hi, 8), l_hi);
+    const __m128i result = _mm_packs_epi32(_mm_srai_epi32(sum_lo, 16),
+                                           _mm_srai_epi32(sum_hi, 16));
+
+    /* if one of the neighbours is "special", use the top left one
+       without interpolation */
+    const __m128i threshold = _mm_set1_epi16(-29999);
+    const __m128i special =
+      _mm_or_si128(_mm_or_si128(_mm_cmplt_epi16(va, threshold),
+                                _mm_cmplt_epi16(vb, threshold)),
+                   _mm_or_si128(_mm_cmplt_epi16(vc, threshold),
+                                _mm_cmplt_epi16(vd, threshold)));
+
+    _mm_storeu_si128((__m128i *)dest,
+                     _mm_or_si128(_mm_and_si128(special, va),
+                                  _mm_andnot_si128(special, result)));
+  }
+
+  gcc_hot gcc_flatten
+  static void Interpolate(const int16_t *gcc_restrict a,
+                          const int16_t *gcc_restrict b,
+                          const int16_t *gcc_restrict c,
+                          const int16_t *gcc_restrict d,
+                          const uint16_t *gcc_restrict ix,
+                          const uint16_t *gcc_restrict iy,
+                          TerrainHeight *gcc_restrict dest, unsigned n) {
+    for (unsigned i = 0; i < n; i += 8)
+      Interpolate8(a + i, b + i, c + i, d + i, ix + i, iy + i, dest + i);
+  }
+};
+
+#if CLANG_OR_GCC_VERSION(4,8)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -24,6 +24,8 @@ Copyright_License {
 #include "Terrain/RasterTileCache.hpp"
 #include "Terrain/RasterLocation.hpp"
 
+#include <algorithm>
+
 #include <stdlib.h>
 
 struct GridLocation : public RasterLocation {
@@ -297,19 +299,32 @@ RasterTileCache::ScanTileLine(GridLocation start, GridLocation end,
   }
 
   const RasterTile &tile = tiles.Get(start.tile_x, start.tile_y);
-  if (tile.IsEnabled())
-    tile.ScanLine(start.x, start.y, end.x, end.y,
+  const RasterBuffer *data = tile.GetBuffer();
+  if (data != nullptr)
+    tile.ScanLine(*data, start.x, start.y, end.x, end.y,
                   buffer + start.index, end.index - start.index,
                   interpolate);
   else
-    /* need range checking in the overview buffer because its size may
+    /* need range checking in the reduced buffer because its size may
        be rounded down, and then the "fine" location may exceed its
        bounds */
-    overview.ScanLineChecked(start.x >> OVERVIEW_BITS,
-                             start.y >> OVERVIEW_BITS,
-                             end.x >> OVERVIEW_BITS, end.y >> OVERVIEW_BITS,
-                             buffer + start.index, end.index - start.index,
-                             interpolate);
+    GetLevel(fallback_shift)
+      ->ScanLineChecked(start.x >> fallback_shift,
+                        start.y >> fallback_shift,
+                        end.x >> fallback_shift, end.y >> fallback_shift,
+                        buffer + start.index, end.index - start.index,
+                        interpolate);
+}
+
+unsigned
+RasterTileCache::FindLevel(unsigned step) const
+{
+  for (unsigned shift = OVERVIEW_BITS; shift > 0; --shift)
+    if (step >= (1u << (shift + RasterTraits::SUBPIXEL_BITS)) &&
+        GetLevel(shift) != nullptr)
+      return shift;
+
+  return 0;
 }
 
 void
@@ -324,6 +339,21 @@ RasterTileCache::ScanLine(const RasterLocation _start,
   assert(_end.y < GetFineHeight());
   assert(size >= 2);
 
+  /* when the samples are far apart, scan a pyramid level which
+     matches the sample distance, instead of the tiles; this needs
+     less memory bandwidth and works even if the tiles are not
+     loaded */
+  const unsigned step =
+    std::max(abs(int(_end.x - _start.x)), abs(int(_end.y - _start.y)))
+    / (size - 1);
+  const unsigned shift = FindLevel(step);
+  if (shift > 0) {
+    GetLevel(shift)->ScanLineChecked(_start.x >> shift, _start.y >> shift,
+                                     _end.x >> shift, _end.y >> shift,
+                                     buffer, size, interpolate);
+    return;
+  }
+
   const GridRay ray(GetFineTileWidth(), GetFineTileHeight(),
                     _start, _end, size);
   assert(ray.size == size);
@@ -330,6 +330,8 @@ TerrainRenderer::Generate(const WindowProjection &map_projection,
     return true;
 
   compare_projection = CompareProjection(map_projection);
+
+  const bool tiles_changed = terrain_serial != terrain.GetSerial();
 #endif
 
   terrain_serial = terrain.GetSerial();
@@ -354,7 +356,15 @@ TerrainRenderer::Generate(const WindowProjection &map_projection,
 
   {
     RasterTerrain::Lease map(terrain);
+#ifdef ENABLE_OPENGL
     raster_renderer.ScanMap(map, map_projection);
+#else
+    if (tiles_changed)
+      /* new tiles have been loaded: scan the area they cover again */
+      raster_renderer.UpdateTiles(map);
+
+    raster_renderer.ScanMapIncremental(map, map_projection);
+#endif
   }
 
   raster_renderer.GenerateImage(do_shading, height_scale,
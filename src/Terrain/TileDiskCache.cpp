@@ -0,0 +1,228 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "TileDiskCache.hpp"
+#include "RasterBuffer.hpp"
+#include "OS/FileMapping.hpp"
+
+#include <algorithm>
+
+#include <string.h>
+#include <tchar.h>
+
+/**
+ * FileMapping refuses to map files larger than this.
+ */
+static constexpr uint64_t MAX_CACHE_SIZE = 1024 * 1024 * 1024 - 1;
+
+inline size_t
+TileDiskCache::Entry::GetDataSize() const
+{
+  return size_t(width) * size_t(height) * sizeof(TerrainHeight);
+}
+
+TileDiskCache::TileDiskCache() = default;
+
+TileDiskCache::~TileDiskCache()
+{
+  Close();
+}
+
+inline bool
+TileDiskCache::Create(const Header &header)
+{
+  file = _tfopen(path.c_str(), _T("w+b"));
+  if (file == nullptr)
+    return false;
+
+  if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+      fwrite(entries.begin(), sizeof(Entry), entries.size(),
+             file) != entries.size() ||
+      fflush(file) != 0) {
+    fclose(file);
+    file = nullptr;
+    return false;
+  }
+
+  file_size = EntryPosition(entries.size());
+  return true;
+}
+
+inline bool
+TileDiskCache::LoadIndex(const Header &expected)
+{
+  file = _tfopen(path.c_str(), _T("r+b"));
+  if (file == nullptr)
+    return false;
+
+  Header header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(&header, &expected, sizeof(header)) != 0 ||
+      fread(entries.begin(), sizeof(Entry), entries.size(),
+            file) != entries.size() ||
+      fseek(file, 0, SEEK_END) != 0) {
+    fclose(file);
+    file = nullptr;
+    return false;
+  }
+
+  file_size = ftell(file);
+
+  /* verify that all entries point inside the file */
+  for (const auto &entry : entries)
+    if (entry.offset != 0 &&
+        entry.offset + entry.GetDataSize() > file_size) {
+      fclose(file);
+      file = nullptr;
+      return false;
+    }
+
+  return true;
+}
+
+bool
+TileDiskCache::Open(Path _path,
+                    unsigned width, unsigned height,
+                    unsigned tile_width, unsigned tile_height,
+                    unsigned n_tiles, uint64_t _budget)
+{
+  Close();
+
+  const std::lock_guard<Mutex> lock(mutex);
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  header.magic = Header::MAGIC;
+  header.version = Header::VERSION;
+  header.width = width;
+  header.height = height;
+  header.tile_width = tile_width;
+  header.tile_height = tile_height;
+  header.n_tiles = n_tiles;
+
+  path = _path;
+  budget = std::min(_budget, MAX_CACHE_SIZE);
+  entries.ResizeDiscard(n_tiles);
+
+  if (LoadIndex(header))
+    return true;
+
+  /* no usable cache file yet: start from scratch */
+  std::fill(entries.begin(), entries.end(), Entry{0, 0, 0});
+  if (Create(header))
+    return true;
+
+  path = nullptr;
+  return false;
+}
+
+void
+TileDiskCache::Close()
+{
+  const std::lock_guard<Mutex> lock(mutex);
+
+  if (file == nullptr)
+    return;
+
+  mapping.reset();
+  fclose(file);
+  file = nullptr;
+  path = nullptr;
+}
+
+inline bool
+TileDiskCache::Remap() const
+{
+  mapping.reset();
+
+  fflush(file);
+
+  mapping.reset(new FileMapping(path));
+  if (mapping->error()) {
+    mapping.reset();
+    return false;
+  }
+
+  return true;
+}
+
+bool
+TileDiskCache::Load(unsigned index, RasterBuffer &buffer) const
+{
+  const std::lock_guard<Mutex> lock(mutex);
+
+  if (file == nullptr || index >= entries.size())
+    return false;
+
+  const Entry &entry = entries[index];
+  if (entry.offset == 0)
+    return false;
+
+  const size_t size = entry.GetDataSize();
+  buffer.Resize(entry.width, entry.height);
+
+  if ((mapping != nullptr && entry.offset + size <= mapping->size()) ||
+      Remap()) {
+    memcpy(buffer.GetData(), mapping->at(entry.offset), size);
+    return true;
+  }
+
+  /* the file could not be mapped; fall back to reading it */
+  if (fseek(file, entry.offset, SEEK_SET) != 0 ||
+      fread(buffer.GetData(), 1, size, file) != size) {
+    buffer.Reset();
+    return false;
+  }
+
+  return true;
+}
+
+void
+TileDiskCache::Store(unsigned index, const RasterBuffer &buffer)
+{
+  const std::lock_guard<Mutex> lock(mutex);
+
+  if (file == nullptr || index >= entries.size() ||
+      entries[index].offset != 0)
+    return;
+
+  Entry entry;
+  entry.offset = file_size;
+  entry.width = buffer.GetWidth();
+  entry.height = buffer.GetHeight();
+
+  const size_t size = entry.GetDataSize();
+  if (file_size + size > budget)
+    /* cache is full */
+    return;
+
+  /* write the data first, and then publish it in the index */
+  if (fseek(file, file_size, SEEK_SET) != 0 ||
+      fwrite(buffer.GetData(), 1, size, file) != size ||
+      fseek(file, EntryPosition(index), SEEK_SET) != 0 ||
+      fwrite(&entry, sizeof(entry), 1, file) != 1)
+    return;
+
+  file_size += size;
+  entries[index] = entry;
+}
@@ -0,0 +1,140 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_TERRAIN_TILE_DISK_CACHE_HPP
+#define XCSOAR_TERRAIN_TILE_DISK_CACHE_HPP
+
+#include "OS/Path.hpp"
+#include "Thread/Mutex.hxx"
+#include "Util/AllocatedArray.hxx"
+
+#include <memory>
+#include <cstdint>
+
+#include <stdio.h>
+
+class FileMapping;
+class RasterBuffer;
+
+/**
+ * An on-disk cache of decoded terrain tiles.  Each tile is stored as
+ * a raw block of #TerrainHeight values, and is read back through a
+ * #FileMapping, which makes reloading an evicted tile much cheaper
+ * than decoding it again from the JPEG2000 file.
+ *
+ * The file grows until it reaches the configured byte budget; after
+ * that, no more tiles are added.
+ *
+ * All methods are thread-safe.
+ */
+class TileDiskCache {
+  struct Header {
+    static constexpr uint32_t MAGIC = 0x54494c45;
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic, version;
+    uint32_t width, height;
+    uint32_t tile_width, tile_height;
+    uint32_t n_tiles;
+  };
+
+  struct Entry {
+    /**
+     * The position of the tile data within the file; 0 means this
+     * tile is not cached.
+     */
+    uint32_t offset;
+
+    uint16_t width, height;
+
+    size_t GetDataSize() const;
+  };
+
+  static constexpr long EntryPosition(unsigned index) {
+    return sizeof(Header) + index * sizeof(Entry);
+  }
+
+  mutable Mutex mutex;
+
+  AllocatedPath path = nullptr;
+
+  FILE *file = nullptr;
+
+  /**
+   * The current mapping of the file.  It may be older than the file,
+   * and gets recreated when a tile beyond its end is needed.
+   */
+  mutable std::unique_ptr<FileMapping> mapping;
+
+  AllocatedArray<Entry> entries;
+
+  uint64_t file_size;
+
+  uint64_t budget;
+
+public:
+  TileDiskCache();
+  ~TileDiskCache();
+
+  TileDiskCache(const TileDiskCache &) = delete;
+  TileDiskCache &operator=(const TileDiskCache &) = delete;
+
+  bool IsOpen() const {
+    return file != nullptr;
+  }
+
+  /**
+   * Open (or create) the cache file.  An existing file is discarded
+   * if it was created for a different raster geometry.
+   *
+   * @param budget the maximum size of the file [bytes]
+   * @return true on success
+   */
+  bool Open(Path path,
+            unsigned width, unsigned height,
+            unsigned tile_width, unsigned tile_height,
+            unsigned n_tiles, uint64_t budget);
+
+  void Close();
+
+  /**
+   * Load a tile from the cache.
+   *
+   * @return false if the tile is not in the cache
+   */
+  bool Load(unsigned index, RasterBuffer &buffer) const;
+
+  /**
+   * Add a tile to the cache, unless it is already cached or the
+   * budget is exhausted.
+   */
+  void Store(unsigned index, const RasterBuffer &buffer);
+
+private:
+  bool Create(const Header &header);
+  bool LoadIndex(const Header &expected);
+
+  bool Remap() const;
+};
+
+#endif
@@ -62,6 +62,75 @@ static constexpr jas_stream_ops_t zzip_stream_ops = {
   jas_zzip_close
 };
 
+/**
+ * A #zzip_file with a mutex which serializes access to the
+ * underlying #zzip_dir.
+ */
+struct LockedZzipFile {
+  struct zzip_file *const file;
+  Mutex &mutex;
+
+  LockedZzipFile(struct zzip_file *_file, Mutex &_mutex)
+    :file(_file), mutex(_mutex) {}
+};
+
+static int
+jas_locked_zzip_read(jas_stream_obj_t *obj, char *buf, unsigned cnt)
+{
+  const auto &f = *(LockedZzipFile *)obj;
+
+  const std::lock_guard<Mutex> lock(f.mutex);
+  return zzip_fread(buf, 1, cnt, f.file);
+}
+
+static long
+jas_locked_zzip_seek(jas_stream_obj_t *obj, long offset, int origin)
+{
+  const auto &f = *(LockedZzipFile *)obj;
+
+  const std::lock_guard<Mutex> lock(f.mutex);
+  return zzip_seek(f.file, offset, origin);
+}
+
+static int
+jas_locked_zzip_close(jas_stream_obj_t *obj)
+{
+  const auto f = (LockedZzipFile *)obj;
+
+  int result;
+  {
+    const std::lock_guard<Mutex> lock(f->mutex);
+    result = zzip_file_close(f->file);
+  }
+
+  delete f;
+  return result;
+}
+
+static constexpr jas_stream_ops_t locked_zzip_stream_ops = {
+  jas_locked_zzip_read,
+  jas_zzip_write,
+  jas_locked_zzip_seek,
+  jas_locked_zzip_close
+};
+
+static jas_stream_t *
+CreateJasperStream(jas_stream_obj_t *obj, const jas_stream_ops_t &ops)
+{
+  jas_stream_t *stream = jas_stream_create();
+  if (stream == nullptr)
+    return nullptr;
+
+  stream->openmode_ = JAS_STREAM_READ|JAS_STREAM_BINARY;
+  stream->obj_ = obj;
+  stream->ops_ = const_cast<jas_stream_ops_t *>(&ops);
+
+  /* By default, use full buffering for this type of stream. */
+  jas_stream_initbuf(stream, JAS_STREAM_FULLBUF, 0, 0);
+
+  return stream;
+}
+
 jas_stream_t *
 OpenJasperZzipStream(struct zzip_dir *dir, const char *path)
 {
@@ -69,18 +138,30 @@ OpenJasperZzipStream(struct zzip_dir *dir, const char *path)
   if (f == nullptr)
     return nullptr;
 
-  jas_stream_t *stream = jas_stream_create();
-  if (stream == nullptr) {
+  jas_stream_t *stream = CreateJasperStream(f, zzip_stream_ops);
+  if (stream == nullptr)
     zzip_file_close(f);
-    return nullptr;
+
+  return stream;
+}
+
+jas_stream_t *
+OpenJasperZzipStream(struct zzip_dir *dir, const char *path, Mutex &mutex)
+{
+  struct zzip_file *f;
+
+  {
+    const std::lock_guard<Mutex> lock(mutex);
+    f = zzip_open_rb(dir, path);
   }
 
-  stream->openmode_ = JAS_STREAM_READ|JAS_STREAM_BINARY;
-  stream->obj_ = f;
-  stream->ops_ = const_cast<jas_stream_ops_t *>(&zzip_stream_ops);
+  if (f == nullptr)
+    return nullptr;
 
-  /* By default, use full buffering for this type of stream. */
-  jas_stream_initbuf(stream, JAS_STREAM_FULLBUF, 0, 0);
+  auto *lf = new LockedZzipFile(f, mutex);
+  jas_stream_t *stream = CreateJasperStream(lf, locked_zzip_stream_ops);
+  if (stream == nullptr)
+    jas_locked_zzip_close(lf);
 
   return stream;
 }
@@ -26,9 +26,19 @@ Copyright_License {
 
 #include "jasper/jas_stream.h"
 
+#include "Thread/Mutex.hxx"
+
 struct zzip_dir;
 
 jas_stream_t *
 OpenJasperZzipStream(struct zzip_dir *dir, const char *path);
 
+/**
+ * Like OpenJasperZzipStream(), but lock the given mutex during each
+ * zziplib call.  This allows several threads to read from the same
+ * #zzip_dir concurrently, each with its own stream.
+ */
+jas_stream_t *
+OpenJasperZzipStream(struct zzip_dir *dir, const char *path, Mutex &mutex);
+
 #endif
@@ -0,0 +1,105 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_THREAD_RCU_DOMAIN_HPP
+#define XCSOAR_THREAD_RCU_DOMAIN_HPP
+
+#include <atomic>
+
+/**
+ * A minimal read-copy-update scheme.  Readers enter a read-side
+ * section with a #ReadLease, which never blocks.  Writers never
+ * modify objects which readers may see; they publish a new version
+ * with an atomic pointer swap and "retire" the old one, which may
+ * only be freed after all readers which could still see it have
+ * left.
+ *
+ * Readers register with one of two counters, depending on the
+ * current epoch.  TryFlip() switches the epoch, but only if the
+ * counter of the new epoch has dropped to zero, i.e. all readers
+ * from two epochs ago have left.  Therefore, after a successful
+ * TryFlip(), all objects which were retired before the previous
+ * successful TryFlip() can be freed.
+ */
+class RcuDomain {
+  std::atomic<unsigned> epoch;
+  std::atomic<unsigned> readers[2];
+
+public:
+  RcuDomain() noexcept:epoch(0) {
+    readers[0] = 0;
+    readers[1] = 0;
+  }
+
+  RcuDomain(const RcuDomain &) = delete;
+  RcuDomain &operator=(const RcuDomain &) = delete;
+
+  /**
+   * A read-side section.  While it exists, objects published in this
+   * domain which the reader has seen will not be freed.
+   */
+  class ReadLease {
+    RcuDomain &domain;
+    unsigned e;
+
+  public:
+    explicit ReadLease(RcuDomain &_domain) noexcept:domain(_domain) {
+      while (true) {
+        e = domain.epoch.load();
+        ++domain.readers[e];
+
+        /* if the epoch was flipped meanwhile, the writer may not have
+           seen our registration; try again with the new epoch */
+        if (domain.epoch.load() == e)
+          break;
+
+        --domain.readers[e];
+      }
+    }
+
+    ReadLease(const ReadLease &) = delete;
+    ReadLease &operator=(const ReadLease &) = delete;
+
+    ~ReadLease() noexcept {
+      --domain.readers[e];
+    }
+  };
+
+  /**
+   * Attempt to begin a new epoch.  This must only be called by one
+   * writer at a time.
+   *
+   * @return true on success; objects which were retired before the
+   * previous successful call may now be freed
+   */
+  bool TryFlip() noexcept {
+    const unsigned next = 1 - epoch.load();
+    if (readers[next].load() != 0)
+      return false;
+
+    epoch.store(next);
+    return true;
+  }
+};
+
+#endif
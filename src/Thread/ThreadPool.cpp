@@ -0,0 +1,141 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Thread/ThreadPool.hpp"
+#include "Util.hpp"
+
+#include <algorithm>
+#include <thread>
+
+unsigned
+ThreadPool::GetCPUCount() noexcept
+{
+  const unsigned n = std::thread::hardware_concurrency();
+  return n > 0 ? n : 1;
+}
+
+ThreadPool::ThreadPool(const char *_name, unsigned max_workers,
+                       bool _idle_priority) noexcept
+  :name(_name),
+   n_workers(std::min(max_workers, GetCPUCount() - 1)),
+   idle_priority(_idle_priority)
+{
+}
+
+ThreadPool::~ThreadPool() noexcept
+{
+  {
+    const std::lock_guard<Mutex> lock(mutex);
+    stop = true;
+    work_cond.notify_all();
+  }
+
+  for (auto &worker : workers)
+    if (worker.IsDefined())
+      worker.Join();
+}
+
+void
+ThreadPool::Start() noexcept
+{
+  for (unsigned i = 0; i < n_workers; ++i) {
+    workers.emplace_back(*this, name);
+    workers.back().Start();
+  }
+}
+
+ThreadPool::Job *
+ThreadPool::FindPendingJob() const noexcept
+{
+  for (Job *job : jobs)
+    if (job->HasPendingItems())
+      return job;
+
+  return nullptr;
+}
+
+void
+ThreadPool::ProcessItems(Job &job, std::unique_lock<Mutex> &lock) noexcept
+{
+  while (job.HasPendingItems()) {
+    const unsigned i = job.next_item++;
+    ++job.n_busy;
+
+    lock.unlock();
+    job.f(i);
+    lock.lock();
+
+    if (--job.n_busy == 0 && !job.HasPendingItems())
+      done_cond.notify_all();
+  }
+}
+
+void
+ThreadPool::WorkerRun() noexcept
+{
+  if (idle_priority)
+    SetThreadIdlePriority();
+
+  std::unique_lock<Mutex> lock(mutex);
+
+  while (true) {
+    Job *job;
+    while (!stop && (job = FindPendingJob()) == nullptr)
+      work_cond.wait(lock);
+
+    if (stop)
+      break;
+
+    ProcessItems(*job, lock);
+  }
+}
+
+void
+ThreadPool::Run(unsigned n, const std::function<void(unsigned)> &f) noexcept
+{
+  if (n_workers == 0 || n < 2) {
+    /* not worth waking up the workers */
+    for (unsigned i = 0; i < n; ++i)
+      f(i);
+    return;
+  }
+
+  std::unique_lock<Mutex> lock(mutex);
+
+  if (workers.empty())
+    Start();
+
+  Job job(f, n);
+  jobs.push_back(&job);
+  work_cond.notify_all();
+
+  /* the calling thread processes only items of its own job, and then
+     waits for the workers to finish the others; a worker which waits
+     for a nested job does the same, therefore this cannot deadlock */
+  ProcessItems(job, lock);
+
+  while (job.n_busy > 0)
+    done_cond.wait(lock);
+
+  jobs.remove(&job);
+}
@@ -0,0 +1,175 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_THREAD_THREAD_POOL_HPP
+#define XCSOAR_THREAD_THREAD_POOL_HPP
+
+#include "Thread/Thread.hpp"
+#include "Thread/Mutex.hxx"
+#include "Thread/Cond.hxx"
+#include "Util/Compiler.h"
+
+#include <functional>
+#include <list>
+
+/**
+ * A small fixed set of worker threads which process a range of
+ * independent work items in parallel.  The threads are launched
+ * lazily on the first Run() call and stay alive (sleeping) until the
+ * pool is destructed.
+ *
+ * The calling thread participates in the work, therefore a pool with
+ * zero worker threads is valid and runs everything serially.
+ *
+ * Run() may be called from several threads at a time, and from
+ * inside a work item (nested parallelism); idle workers pick up the
+ * items of all pending jobs.
+ */
+class ThreadPool {
+  class Worker final : public Thread {
+    ThreadPool &pool;
+
+  public:
+    Worker(ThreadPool &_pool, const char *_name)
+      :Thread(_name), pool(_pool) {}
+
+  protected:
+    void Run() noexcept override {
+      pool.WorkerRun();
+    }
+  };
+
+  /**
+   * The state of one Run() call.
+   */
+  struct Job {
+    /**
+     * The function which processes one work item.
+     */
+    const std::function<void(unsigned)> &f;
+
+    /**
+     * The number of work items.
+     */
+    const unsigned n_items;
+
+    /**
+     * The next work item to be picked up by a thread.
+     */
+    unsigned next_item = 0;
+
+    /**
+     * The number of work items currently being processed.
+     */
+    unsigned n_busy = 0;
+
+    Job(const std::function<void(unsigned)> &_f, unsigned _n_items)
+      :f(_f), n_items(_n_items) {}
+
+    bool HasPendingItems() const {
+      return next_item < n_items;
+    }
+  };
+
+  const char *const name;
+
+  const unsigned n_workers;
+
+  const bool idle_priority;
+
+  std::list<Worker> workers;
+
+  Mutex mutex;
+  Cond work_cond, done_cond;
+
+  /**
+   * The jobs whose Run() call has not yet returned, the oldest one
+   * first.
+   */
+  std::list<Job *> jobs;
+
+  bool stop = false;
+
+public:
+  /**
+   * @param max_workers the maximum number of worker threads; the
+   * actual number is limited by the number of CPU cores (minus one
+   * for the calling thread)
+   * @param idle_priority run the worker threads at "idle" priority?
+   */
+  ThreadPool(const char *_name, unsigned max_workers,
+             bool idle_priority=false) noexcept;
+
+  ~ThreadPool() noexcept;
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * Returns the number of threads which execute work items in
+   * parallel, including the calling thread.
+   */
+  unsigned GetConcurrency() const {
+    return n_workers + 1;
+  }
+
+  /**
+   * Call the function once for each index in the range [0, n) and
+   * wait until all calls have returned.  The calls are distributed
+   * over the worker threads and the calling thread; there is no
+   * ordering guarantee.
+   *
+   * The function must not throw.
+   */
+  void Run(unsigned n, const std::function<void(unsigned)> &f) noexcept;
+
+  /**
+   * Returns the number of CPU cores available to this process.
+   */
+  gcc_const
+  static unsigned GetCPUCount() noexcept;
+
+private:
+  void Start() noexcept;
+
+  /**
+   * Returns the oldest job which has pending work items, or nullptr
+   * if there is none.
+   *
+   * Caller must lock the mutex.
+   */
+  gcc_pure
+  Job *FindPendingJob() const noexcept;
+
+  /**
+   * Pick up and process work items of the given job until there are
+   * none left.
+   *
+   * Caller must lock the mutex.
+   */
+  void ProcessItems(Job &job, std::unique_lock<Mutex> &lock) noexcept;
+
+  void WorkerRun() noexcept;
+};
+
+#endif
@@ -0,0 +1,253 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_UTIL_FLAT_HASH_MAP_HPP
+#define XCSOAR_UTIL_FLAT_HASH_MAP_HPP
+
+#include "Util/Compiler.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <assert.h>
+#include <stdint.h>
+
+/**
+ * A hash map for search algorithms such as #Dijkstra and #AStar.  It
+ * supports only insertion and lookup, but it is a lot cheaper than
+ * std::unordered_map: the entries are stored in one array (in
+ * insertion order), and an open-addressing table with linear
+ * probing refers to them by index.  Neither array shrinks; clear()
+ * keeps the memory, which is then reused by the next search.
+ *
+ * Iterators refer to an entry by its index; they remain valid when
+ * new entries are inserted.
+ */
+template<typename K, typename V,
+         typename Hash=std::hash<K>, typename Equal=std::equal_to<K>>
+class FlatHashMap {
+public:
+  typedef std::pair<K, V> value_type;
+  typedef unsigned size_type;
+
+private:
+  static constexpr unsigned EMPTY = ~0u;
+
+  /**
+   * The minimum size of #buckets.
+   */
+  static constexpr unsigned MIN_BUCKETS_BITS = 4;
+
+  std::vector<value_type> entries;
+
+  /**
+   * The open-addressing table; each element is an index into
+   * #entries or #EMPTY.  Its size is a power of two, and it is at
+   * least twice as large as #entries.
+   */
+  std::vector<unsigned> buckets;
+
+  /**
+   * The base-2 logarithm of the size of #buckets.
+   */
+  unsigned bits = 0;
+
+  Hash hash;
+  Equal equal;
+
+  template<typename M, typename T>
+  class IteratorBase {
+    friend class FlatHashMap;
+
+    M *map;
+    unsigned i;
+
+  public:
+    IteratorBase() = default;
+
+    constexpr IteratorBase(M *_map, unsigned _i) noexcept
+      :map(_map), i(_i) {}
+
+    /**
+     * Convert an "iterator" to a "const_iterator".
+     */
+    template<typename M2, typename T2>
+    constexpr IteratorBase(const IteratorBase<M2, T2> &other) noexcept
+      :map(other.map), i(other.i) {}
+
+    T &operator*() const noexcept {
+      return map->entries[i];
+    }
+
+    T *operator->() const noexcept {
+      return &map->entries[i];
+    }
+
+    IteratorBase &operator++() noexcept {
+      ++i;
+      return *this;
+    }
+
+    constexpr bool operator==(const IteratorBase &other) const noexcept {
+      return i == other.i;
+    }
+
+    constexpr bool operator!=(const IteratorBase &other) const noexcept {
+      return i != other.i;
+    }
+
+    template<typename M2, typename T2>
+    friend class IteratorBase;
+  };
+
+public:
+  typedef IteratorBase<FlatHashMap, value_type> iterator;
+  typedef IteratorBase<const FlatHashMap, const value_type> const_iterator;
+
+  gcc_pure
+  bool empty() const noexcept {
+    return entries.empty();
+  }
+
+  gcc_pure
+  size_type size() const noexcept {
+    return entries.size();
+  }
+
+  iterator begin() noexcept {
+    return iterator(this, 0);
+  }
+
+  const_iterator begin() const noexcept {
+    return const_iterator(this, 0);
+  }
+
+  iterator end() noexcept {
+    return iterator(this, size());
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator(this, size());
+  }
+
+  /**
+   * Remove all entries, but keep the allocated memory.
+   */
+  void clear() noexcept {
+    entries.clear();
+    std::fill(buckets.begin(), buckets.end(), EMPTY);
+  }
+
+  /**
+   * Allocate memory for the given number of entries.
+   */
+  void reserve(size_type n) {
+    entries.reserve(n);
+
+    unsigned new_bits = std::max(bits, MIN_BUCKETS_BITS);
+    while ((size_type(1) << new_bits) < 2 * n)
+      ++new_bits;
+
+    if (new_bits != bits)
+      Rehash(new_bits);
+  }
+
+  gcc_pure
+  iterator find(const K &key) noexcept {
+    return iterator(this, Find(key));
+  }
+
+  gcc_pure
+  const_iterator find(const K &key) const noexcept {
+    return const_iterator(this, Find(key));
+  }
+
+  /**
+   * Insert a new entry, unless one with the same key exists already.
+   *
+   * @return an iterator to the (new or existing) entry, and whether
+   * the entry was inserted
+   */
+  std::pair<iterator, bool> insert(const value_type &value) {
+    if (2 * (size() + 1) > buckets.size())
+      Rehash(std::max(bits + 1, MIN_BUCKETS_BITS));
+
+    unsigned b = GetHomeBucket(value.first);
+    while (buckets[b] != EMPTY) {
+      if (equal(entries[buckets[b]].first, value.first))
+        return std::make_pair(iterator(this, buckets[b]), false);
+
+      b = NextBucket(b);
+    }
+
+    buckets[b] = size();
+    entries.push_back(value);
+    return std::make_pair(iterator(this, buckets[b]), true);
+  }
+
+private:
+  gcc_pure
+  unsigned GetHomeBucket(const K &key) const noexcept {
+    /* Fibonacci hashing spreads keys whose hash values differ only in
+       the upper bits (e.g. the stage number of a ScanTaskPoint) over
+       the whole table */
+    return (uint64_t(hash(key)) * UINT64_C(0x9e3779b97f4a7c15))
+      >> (64 - bits);
+  }
+
+  gcc_pure
+  unsigned NextBucket(unsigned b) const noexcept {
+    return (b + 1) & (buckets.size() - 1);
+  }
+
+  gcc_pure
+  unsigned Find(const K &key) const noexcept {
+    if (buckets.empty())
+      return size();
+
+    for (unsigned b = GetHomeBucket(key); buckets[b] != EMPTY;
+         b = NextBucket(b))
+      if (equal(entries[buckets[b]].first, key))
+        return buckets[b];
+
+    return size();
+  }
+
+  void Rehash(unsigned new_bits) {
+    assert(new_bits >= MIN_BUCKETS_BITS);
+
+    bits = new_bits;
+    buckets.assign(size_type(1) << bits, EMPTY);
+
+    for (unsigned i = 0, n = size(); i < n; ++i) {
+      unsigned b = GetHomeBucket(entries[i].first);
+      while (buckets[b] != EMPTY)
+        b = NextBucket(b);
+
+      buckets[b] = i;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,221 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_UTIL_INDEXED_HEAP_HPP
+#define XCSOAR_UTIL_INDEXED_HEAP_HPP
+
+#include "Util/Compiler.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+
+/**
+ * The base class of all objects which may be managed by an
+ * #IndexedHeap.  It stores the object's position in the heap.
+ */
+class IndexedHeapHook {
+  template<typename T, typename Compare, unsigned arity>
+  friend class IndexedHeap;
+
+  static constexpr unsigned NOT_LINKED = ~0u;
+
+  unsigned heap_index = NOT_LINKED;
+
+public:
+  IndexedHeapHook() = default;
+
+  /**
+   * A copy is not linked, even if the original is.
+   */
+  IndexedHeapHook(const IndexedHeapHook &) noexcept {}
+
+  IndexedHeapHook &operator=(const IndexedHeapHook &) noexcept {
+    return *this;
+  }
+
+  /**
+   * Is this object currently in an #IndexedHeap?
+   */
+  bool IsLinked() const noexcept {
+    return heap_index != NOT_LINKED;
+  }
+};
+
+/**
+ * A d-ary min-heap of pointers to objects deriving from
+ * #IndexedHeapHook.  Because each object knows its position, it can
+ * be erased or re-ranked (after its key has changed) in O(log n),
+ * unlike with std::priority_queue.  Unlike a balanced tree, it does
+ * not need to rebalance, and all of its memory is one array which
+ * can be reserved in advance.
+ *
+ * The container does not own the objects.
+ *
+ * @param Compare a strict weak ordering; the smallest element is
+ * at the top
+ * @param arity the number of children of each node; 4 is usually
+ * faster than 2, because the tree is shallower and the children are
+ * adjacent in memory
+ */
+template<typename T, typename Compare, unsigned arity=4>
+class IndexedHeap {
+  static_assert(arity >= 2, "Invalid arity");
+
+  std::vector<T *> heap;
+
+  Compare compare;
+
+public:
+  typedef unsigned size_type;
+
+  bool empty() const noexcept {
+    return heap.empty();
+  }
+
+  size_type size() const noexcept {
+    return heap.size();
+  }
+
+  void reserve(size_type n) {
+    heap.reserve(n);
+  }
+
+  /**
+   * Remove all objects.  Their hooks are not reset; the caller must
+   * not use IndexedHeapHook::IsLinked() on them afterwards.
+   */
+  void clear() noexcept {
+    heap.clear();
+  }
+
+  gcc_pure
+  T &top() const noexcept {
+    assert(!empty());
+
+    return *heap.front();
+  }
+
+  void push(T &value) noexcept {
+    assert(!value.IsLinked());
+
+    heap.push_back(&value);
+    SiftUp(heap.size() - 1);
+  }
+
+  void pop() noexcept {
+    erase(top());
+  }
+
+  void erase(T &value) noexcept {
+    assert(Contains(value));
+
+    const unsigned i = value.heap_index;
+    value.heap_index = IndexedHeapHook::NOT_LINKED;
+
+    T *last = heap.back();
+    heap.pop_back();
+    if (i == heap.size())
+      /* it was the last one */
+      return;
+
+    Put(i, last);
+    update(*last);
+  }
+
+  /**
+   * Restore the heap order after the key of the given object has
+   * changed.
+   */
+  void update(T &value) noexcept {
+    assert(Contains(value));
+
+    const unsigned i = value.heap_index;
+    if (SiftUp(i) == i)
+      SiftDown(i);
+  }
+
+private:
+  gcc_pure
+  bool Contains(const T &value) const noexcept {
+    return value.heap_index < heap.size() && heap[value.heap_index] == &value;
+  }
+
+  void Put(unsigned i, T *value) noexcept {
+    heap[i] = value;
+    value->heap_index = i;
+  }
+
+  /**
+   * Move the element at the given position towards the top until
+   * its parent is not larger.
+   *
+   * @return the new position
+   */
+  unsigned SiftUp(unsigned i) noexcept {
+    T *const value = heap[i];
+
+    while (i > 0) {
+      const unsigned parent = (i - 1) / arity;
+      if (!compare(*value, *heap[parent]))
+        break;
+
+      Put(i, heap[parent]);
+      i = parent;
+    }
+
+    Put(i, value);
+    return i;
+  }
+
+  /**
+   * Move the element at the given position towards the bottom until
+   * none of its children is smaller.
+   */
+  void SiftDown(unsigned i) noexcept {
+    T *const value = heap[i];
+    const unsigned n = heap.size();
+
+    while (true) {
+      const unsigned first_child = i * arity + 1;
+      if (first_child >= n)
+        break;
+
+      const unsigned end_child = std::min(first_child + arity, n);
+      unsigned smallest = first_child;
+      for (unsigned child = first_child + 1; child < end_child; ++child)
+        if (compare(*heap[child], *heap[smallest]))
+          smallest = child;
+
+      if (!compare(*heap[smallest], *value))
+        break;
+
+      Put(i, heap[smallest]);
+      i = smallest;
+    }
+
+    Put(i, value);
+  }
+};
+
+#endif
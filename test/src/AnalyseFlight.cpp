@@ -32,6 +32,7 @@
 #include "JSON/GeoWriter.hpp"
 #include "FlightPhaseDetector.hpp"
 #include "FlightPhaseJSON.hpp"
+#include "ContestJSON.hpp"
 #include "Computer/Settings.hpp"
 #include "Util/StringCompare.hxx"
 
@@ -223,56 +224,6 @@ WriteResult(JSON::ObjectWriter &root, const Result &result)
   root.WriteElement("events", WriteEvents, result);
 }
 
-static void
-WritePoint(BufferedOutputStream &writer, const ContestTracePoint &point,
-           const ContestTracePoint *previous)
-{
-  JSON::ObjectWriter object(writer);
-
-  object.WriteElement("time", JSON::WriteLong, (long)point.GetTime());
-  JSON::WriteGeoPointAttributes(object, point.GetLocation());
-
-  if (previous != NULL) {
-    auto distance = point.DistanceTo(previous->GetLocation());
-    object.WriteElement("distance", JSON::WriteUnsigned, uround(distance));
-
-    unsigned duration =
-      std::max((int)point.GetTime() - (int)previous->GetTime(), 0);
-    object.WriteElement("duration", JSON::WriteUnsigned, duration);
-
-    if (duration > 0) {
-      auto speed = distance / duration;
-      object.WriteElement("speed", JSON::WriteDouble, speed);
-    }
-  }
-}
-
-static void
-WriteTrace(BufferedOutputStream &writer, const ContestTraceVector &trace)
-{
-  JSON::ArrayWriter array(writer);
-
-  const ContestTracePoint *previous = NULL;
-  for (auto i = trace.begin(), end = trace.end(); i != end; ++i) {
-    array.WriteElement(WritePoint, *i, previous);
-    previous = &*i;
-  }
-}
-
-static void
-WriteContest(BufferedOutputStream &writer,
-             const ContestResult &result, const ContestTraceVector &trace)
-{
-  JSON::ObjectWriter object(writer);
-
-  object.WriteElement("score", JSON::WriteDouble, result.score);
-  object.WriteElement("distance", JSON::WriteDouble, result.distance);
-  object.WriteElement("duration", JSON::WriteUnsigned, (unsigned)result.time);
-  object.WriteElement("speed", JSON::WriteDouble, result.GetSpeed());
-
-  object.WriteElement("turnpoints", WriteTrace, trace);
-}
-
 static void
 WriteOLCPlus(BufferedOutputStream &writer, const ContestStatistics &stats)
 {
@@ -0,0 +1,196 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+/*
+ * This program measures the performance of #TaskDijkstraMin and
+ * #TaskDijkstraMax on the tasks of the test harness, and prints the
+ * results as JSON, which allows comparing releases.
+ *
+ * Usage: BenchmarkTaskDijkstra
+ */
+
+#include "harness_task.hpp"
+#include "harness_waypoints.hpp"
+#include "Engine/Waypoint/Waypoints.hpp"
+#include "Engine/Task/Ordered/OrderedTask.hpp"
+#include "Engine/Task/Ordered/Points/OrderedTaskPoint.hpp"
+#include "Engine/Task/Factory/AbstractTaskFactory.hpp"
+#include "Engine/Task/PathSolvers/TaskDijkstraMin.hpp"
+#include "Engine/Task/PathSolvers/TaskDijkstraMax.hpp"
+#include "GlideSolvers/GlidePolar.hpp"
+#include "JSON/Writer.hpp"
+#include "JSON/GeoWriter.hpp"
+#include "IO/StdioOutputStream.hxx"
+#include "IO/BufferedOutputStream.hxx"
+
+#include <chrono>
+#include <functional>
+
+#include <stdlib.h>
+
+using std::chrono::steady_clock;
+typedef std::chrono::duration<double> Duration;
+
+/**
+ * The minimum duration of each throughput measurement.
+ */
+static constexpr Duration MIN_DURATION = std::chrono::milliseconds(500);
+
+/**
+ * Call the function repeatedly for at least #MIN_DURATION.
+ *
+ * @return the number of calls per second
+ */
+template<typename F>
+static double
+MeasureRate(F &&f)
+{
+  unsigned long n = 0;
+  const auto start = steady_clock::now();
+  Duration elapsed;
+  do {
+    f();
+    ++n;
+    elapsed = steady_clock::now() - start;
+  } while (elapsed < MIN_DURATION);
+
+  return n / elapsed.count();
+}
+
+template<typename D>
+static unsigned
+SetBoundaries(D &dijkstra, const OrderedTask &task)
+{
+  const unsigned n = task.TaskSize();
+  dijkstra.SetTaskSize(n);
+
+  unsigned n_boundary_points = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    const SearchPointVector &boundary = task.GetTaskPoint(i).GetSearchPoints();
+    dijkstra.SetBoundary(i, boundary);
+    n_boundary_points += boundary.size();
+  }
+
+  return n_boundary_points;
+}
+
+/**
+ * The length of the solution in kilometers.
+ */
+template<typename D>
+static double
+GetSolutionDistance(const D &dijkstra, unsigned n)
+{
+  double distance = 0;
+  for (unsigned i = 1; i < n; ++i)
+    distance += dijkstra.GetSolution(i - 1).GetLocation()
+      .Distance(dijkstra.GetSolution(i).GetLocation());
+
+  return distance / 1000;
+}
+
+static void
+WriteTask(BufferedOutputStream &writer, const OrderedTask &task)
+{
+  JSON::ObjectWriter object(writer);
+
+  const unsigned n = task.TaskSize();
+  object.WriteElement("task_points", JSON::WriteUnsigned, n);
+
+  TaskDijkstraMax dijkstra_max;
+  object.WriteElement("boundary_points", JSON::WriteUnsigned,
+                      SetBoundaries(dijkstra_max, task));
+
+  if (!dijkstra_max.DistanceMax()) {
+    fprintf(stderr, "DistanceMax() failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  object.WriteElement("max_km", JSON::WriteDouble,
+                      GetSolutionDistance(dijkstra_max, n));
+  object.WriteElement("max_per_s", JSON::WriteDouble,
+                      MeasureRate([&](){
+                          dijkstra_max.DistanceMax();
+                        }));
+
+  /* the aircraft is at the start point */
+  const SearchPoint location(task.GetTaskPoint(0).GetLocation(),
+                             task.GetTaskProjection());
+
+  TaskDijkstraMin dijkstra_min;
+  SetBoundaries(dijkstra_min, task);
+
+  if (!dijkstra_min.DistanceMin(location)) {
+    fprintf(stderr, "DistanceMin() failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  object.WriteElement("min_km", JSON::WriteDouble,
+                      GetSolutionDistance(dijkstra_min, n));
+  object.WriteElement("min_per_s", JSON::WriteDouble,
+                      MeasureRate([&](){
+                          dijkstra_min.DistanceMin(location);
+                        }));
+}
+
+int main(int argc, char **argv)
+{
+  GlidePolar glide_polar(2);
+
+  TaskBehaviour task_behaviour;
+  task_behaviour.SetDefaults();
+
+  Waypoints waypoints;
+  SetupWaypoints(waypoints);
+
+  StdioOutputStream os(stdout);
+  BufferedOutputStream writer(os);
+
+  {
+    JSON::ObjectWriter root(writer);
+
+    /* the deterministic tasks; the ones after these are random */
+    for (int i = 0; i < NUM_TASKS + 2; ++i) {
+      TaskManager task_manager(task_behaviour, waypoints);
+      task_manager.SetGlidePolar(glide_polar);
+      if (!test_task(task_manager, waypoints, i)) {
+        fprintf(stderr, "Failed to create task '%s'\n", task_name(i));
+        return EXIT_FAILURE;
+      }
+
+      /* not all harness tasks have calculated their OZ boundaries */
+      task_manager.GetFactory().UpdateGeometry();
+
+      const OrderedTask &task = task_manager.GetOrderedTask();
+      if (task.TaskSize() < 2)
+        continue;
+
+      root.WriteElement(task_name(i), WriteTask, std::cref(task));
+    }
+  }
+
+  writer.Write('\n');
+  writer.Flush();
+
+  return EXIT_SUCCESS;
+}
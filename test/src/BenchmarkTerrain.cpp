@@ -0,0 +1,370 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * This program measures the performance of the terrain subsystem
+ * for a number of viewports around the center of a map file, and
+ * prints the results as JSON, which allows comparing releases.
+ *
+ * Usage: BenchmarkTerrain [--disk-cache=FILE] MAP [RADIUS_KM ...]
+ *
+ * With --disk-cache, the "warm" tile loads are served from a
+ * #TileDiskCache in the given file; without it, they only benefit
+ * from the operating system's file cache.
+ */
+
+#include "Terrain/RasterMap.hpp"
+#include "Terrain/HeightMatrix.hpp"
+#include "Terrain/Loader.hpp"
+#include "Projection/WindowProjection.hpp"
+#include "Screen/Layout.hpp"
+#include "JSON/Writer.hpp"
+#include "JSON/GeoWriter.hpp"
+#include "IO/StdioOutputStream.hxx"
+#include "IO/BufferedOutputStream.hxx"
+#include "OS/Args.hpp"
+#include "OS/FileUtil.hpp"
+#include "OS/ConvertPathName.hpp"
+#include "IO/ZipArchive.hpp"
+#include "Operation/Operation.hpp"
+#include "Util/StaticArray.hxx"
+#include "Util/StringCompare.hxx"
+#include "Util/PrintException.hxx"
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+unsigned Layout::scale_1024 = 1024;
+
+using std::chrono::steady_clock;
+typedef std::chrono::duration<double> Duration;
+
+/**
+ * The minimum duration of each throughput measurement.
+ */
+static constexpr Duration MIN_DURATION = std::chrono::milliseconds(500);
+
+/**
+ * The number of random points/lines used by the query benchmarks.
+ */
+static constexpr unsigned N_SAMPLES = 4096;
+
+/**
+ * The number of samples per ScanLine() call.
+ */
+static constexpr unsigned SCAN_LINE_SIZE = 256;
+
+static constexpr unsigned SCREEN_WIDTH = 640, SCREEN_HEIGHT = 480;
+
+/**
+ * Prevents the compiler from discarding the results of gcc_pure
+ * functions.
+ */
+static volatile int sink;
+
+/**
+ * Call the function once and return its duration in milliseconds.
+ */
+template<typename F>
+static double
+MeasureOnce(F &&f)
+{
+  const auto start = steady_clock::now();
+  f();
+  const Duration elapsed = steady_clock::now() - start;
+  return elapsed.count() * 1000;
+}
+
+/**
+ * Call the function repeatedly for at least #MIN_DURATION.  It
+ * returns the number of operations it has performed.
+ *
+ * @return the number of operations per second
+ */
+template<typename F>
+static double
+MeasureRate(F &&f)
+{
+  unsigned long n = 0;
+  const auto start = steady_clock::now();
+  Duration elapsed;
+  do {
+    n += f();
+    elapsed = steady_clock::now() - start;
+  } while (elapsed < MIN_DURATION);
+
+  return n / elapsed.count();
+}
+
+static void
+LoadTiles(ZipArchive &archive, RasterMap &map, const GeoPoint &center,
+          double radius)
+{
+  do {
+    UpdateTerrainTiles(archive.get(), map.GetTileCache(),
+                       map.GetProjection(), center, radius);
+  } while (map.IsDirty());
+}
+
+/**
+ * Initialise a #RasterMap from the overview previously saved with
+ * RasterMap::SaveCache(), which is a lot faster than decoding the
+ * overview again.
+ */
+static bool
+LoadOverview(RasterMap &map, FILE *overview, Path disk_cache)
+{
+  rewind(overview);
+  if (!map.LoadCache(overview))
+    return false;
+
+  if (disk_cache != nullptr &&
+      !map.GetTileCache().OpenDiskCache(disk_cache, 512 * 1024 * 1024)) {
+    fprintf(stderr, "Failed to open the disk cache\n");
+    return false;
+  }
+
+  return true;
+}
+
+static GeoPoint
+RandomPoint(std::minstd_rand &random, const GeoBounds &bounds)
+{
+  std::uniform_real_distribution<double> r(0, 1);
+  return GeoPoint(bounds.GetWest() +
+                  bounds.GetWidth() * r(random),
+                  bounds.GetSouth() +
+                  bounds.GetHeight() * r(random));
+}
+
+static void
+WriteViewport(BufferedOutputStream &writer, ZipArchive &archive,
+              FILE *overview, Path disk_cache,
+              const GeoPoint &center, double radius)
+{
+  JSON::ObjectWriter object(writer);
+  object.WriteElement("radius", JSON::WriteDouble, radius);
+
+  /* tile loading */
+
+  /* a "cold" load must not find anything in the disk cache */
+  if (disk_cache != nullptr)
+    File::Delete(disk_cache);
+
+  {
+    RasterMap map;
+    if (!LoadOverview(map, overview, disk_cache))
+      exit(EXIT_FAILURE);
+
+    object.WriteElement("tiles_cold_ms", JSON::WriteDouble,
+                        MeasureOnce([&](){
+                            LoadTiles(archive, map, center, radius);
+                          }));
+  }
+
+  RasterMap map;
+  if (!LoadOverview(map, overview, disk_cache))
+    exit(EXIT_FAILURE);
+
+  object.WriteElement("tiles_warm_ms", JSON::WriteDouble,
+                      MeasureOnce([&](){
+                          LoadTiles(archive, map, center, radius);
+                        }));
+
+  WindowProjection projection;
+  projection.SetScreenSize({SCREEN_WIDTH, SCREEN_HEIGHT});
+  projection.SetScaleFromRadius(radius);
+  projection.SetGeoLocation(center);
+  projection.SetScreenOrigin(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+  projection.UpdateScreenBounds();
+
+  const GeoBounds &bounds = projection.GetScreenBounds();
+
+  std::minstd_rand random;
+  std::vector<GeoPoint> points;
+  points.reserve(N_SAMPLES);
+  for (unsigned i = 0; i < N_SAMPLES; ++i)
+    points.push_back(RandomPoint(random, bounds));
+
+  /* point queries */
+
+  object.WriteElement("get_height_per_s", JSON::WriteDouble,
+                      MeasureRate([&](){
+                          int sum = 0;
+                          for (const auto &p : points)
+                            sum += map.GetHeight(p).GetValue();
+                          sink = sum;
+                          return N_SAMPLES;
+                        }));
+
+  object.WriteElement("get_interpolated_height_per_s", JSON::WriteDouble,
+                      MeasureRate([&](){
+                          int sum = 0;
+                          for (const auto &p : points)
+                            sum += map.GetInterpolatedHeight(p).GetValue();
+                          sink = sum;
+                          return N_SAMPLES;
+                        }));
+
+  /* line queries; each consecutive pair of points is a line */
+
+  object.WriteElement("scan_line_samples_per_s", JSON::WriteDouble,
+                      MeasureRate([&](){
+                          TerrainHeight buffer[SCAN_LINE_SIZE];
+                          for (unsigned i = 0; i + 1 < N_SAMPLES; i += 2)
+                            map.ScanLine(points[i], points[i + 1],
+                                         buffer, SCAN_LINE_SIZE, true);
+                          sink = buffer[0].GetValue();
+                          return N_SAMPLES / 2 * SCAN_LINE_SIZE;
+                        }));
+
+  /* fly 300m above the terrain at the origin; some of the lines will
+     hit the terrain, others won't */
+  std::vector<int> altitudes;
+  altitudes.reserve(N_SAMPLES);
+  for (const auto &p : points)
+    altitudes.push_back(map.GetHeight(p).GetValueOr0() + 300);
+
+  object.WriteElement("first_intersection_per_s", JSON::WriteDouble,
+                      MeasureRate([&](){
+                          unsigned n_hits = 0;
+                          for (unsigned i = 0; i + 1 < N_SAMPLES; i += 2) {
+                            GeoPoint intx;
+                            int h;
+                            if (map.FirstIntersection(points[i],
+                                                      altitudes[i],
+                                                      points[i + 1],
+                                                      altitudes[i],
+                                                      altitudes[i],
+                                                      10000, 150,
+                                                      intx, h))
+                              ++n_hits;
+                          }
+                          sink = n_hits;
+                          return N_SAMPLES / 2;
+                        }));
+
+  /* terrain rendering */
+
+  HeightMatrix matrix;
+  const double fill_per_s = MeasureRate([&](){
+#ifdef ENABLE_OPENGL
+      matrix.Fill(map, bounds, SCREEN_WIDTH, SCREEN_HEIGHT, false);
+#else
+      matrix.Fill(map, projection, 1, false);
+#endif
+      return 1;
+    });
+  object.WriteElement("height_matrix_fill_ms", JSON::WriteDouble,
+                      1000 / fill_per_s);
+}
+
+int main(int argc, char **argv)
+try {
+  Args args(argc, argv, "[--disk-cache=FILE] PATH [RADIUS_KM ...]");
+
+  AllocatedPath disk_cache = nullptr;
+  const char *value;
+  while (!args.IsEmpty() &&
+         (value = StringAfterPrefix(args.PeekNext(),
+                                    "--disk-cache=")) != nullptr) {
+    disk_cache = Path(PathName(value));
+    args.Skip();
+  }
+
+  const auto map_path = args.ExpectNextPath();
+
+  StaticArray<double, 16> radii;
+  while (!args.IsEmpty() && !radii.full()) {
+    const char *arg = args.GetNext();
+    char *endptr;
+    const double radius = strtod(arg, &endptr);
+    if (endptr == arg || *endptr != 0 || radius <= 0)
+      args.UsageError();
+
+    radii.push_back(radius * 1000);
+  }
+
+  args.ExpectEnd();
+
+  if (radii.empty())
+    radii = {10000, 50000, 150000};
+
+  ZipArchive archive(map_path);
+
+  NullOperationEnvironment operation;
+  RasterMap map;
+  const double overview_ms = MeasureOnce([&](){
+      if (!LoadTerrainOverview(archive.get(), map.GetTileCache(),
+                               operation)) {
+        fprintf(stderr, "failed to load map\n");
+        exit(EXIT_FAILURE);
+      }
+
+      map.UpdateProjection();
+    });
+
+  FILE *overview = tmpfile();
+  if (overview == nullptr || !map.SaveCache(overview)) {
+    fprintf(stderr, "failed to save the overview\n");
+    return EXIT_FAILURE;
+  }
+
+  const GeoPoint center = map.GetMapCenter();
+
+  StdioOutputStream os(stdout);
+  BufferedOutputStream writer(os);
+
+  {
+    JSON::ObjectWriter root(writer);
+    root.WriteElement("center", JSON::WriteGeoPoint, center);
+    root.WriteElement("overview_ms", JSON::WriteDouble, overview_ms);
+
+    root.BeginElement("viewports");
+    {
+      JSON::ArrayWriter array(writer);
+      for (double radius : radii)
+        array.WriteElement(WriteViewport, std::ref(archive), overview,
+                           Path(disk_cache), center, radius);
+    }
+    root.EndElement();
+  }
+
+  writer.Write('\n');
+  writer.Flush();
+
+  fclose(overview);
+
+  if (disk_cache != nullptr)
+    File::Delete(disk_cache);
+
+  return EXIT_SUCCESS;
+} catch (const std::runtime_error &e) {
+  PrintException(e);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "ContestJSON.hpp"
+#include "Engine/Contest/ContestResult.hpp"
+#include "Engine/Contest/ContestTrace.hpp"
+#include "JSON/Writer.hpp"
+#include "JSON/GeoWriter.hpp"
+#include "Math/Util.hpp"
+
+#include <algorithm>
+
+static void
+WritePoint(BufferedOutputStream &writer, const ContestTracePoint &point,
+           const ContestTracePoint *previous)
+{
+  JSON::ObjectWriter object(writer);
+
+  object.WriteElement("time", JSON::WriteLong, (long)point.GetTime());
+  JSON::WriteGeoPointAttributes(object, point.GetLocation());
+
+  if (previous != NULL) {
+    auto distance = point.DistanceTo(previous->GetLocation());
+    object.WriteElement("distance", JSON::WriteUnsigned, uround(distance));
+
+    unsigned duration =
+      std::max((int)point.GetTime() - (int)previous->GetTime(), 0);
+    object.WriteElement("duration", JSON::WriteUnsigned, duration);
+
+    if (duration > 0) {
+      auto speed = distance / duration;
+      object.WriteElement("speed", JSON::WriteDouble, speed);
+    }
+  }
+}
+
+static void
+WriteTrace(BufferedOutputStream &writer, const ContestTraceVector &trace)
+{
+  JSON::ArrayWriter array(writer);
+
+  const ContestTracePoint *previous = NULL;
+  for (auto i = trace.begin(), end = trace.end(); i != end; ++i) {
+    array.WriteElement(WritePoint, *i, previous);
+    previous = &*i;
+  }
+}
+
+void
+WriteContest(BufferedOutputStream &writer,
+             const ContestResult &result, const ContestTraceVector &trace)
+{
+  JSON::ObjectWriter object(writer);
+
+  object.WriteElement("score", JSON::WriteDouble, result.score);
+  object.WriteElement("distance", JSON::WriteDouble, result.distance);
+  object.WriteElement("duration", JSON::WriteUnsigned, (unsigned)result.time);
+  object.WriteElement("speed", JSON::WriteDouble, result.GetSpeed());
+
+  object.WriteElement("turnpoints", WriteTrace, trace);
+}
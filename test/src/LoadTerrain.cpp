@@ -60,9 +60,8 @@ try {
          (double)bounds.GetEast().Degrees(),
          (double)bounds.GetSouth().Degrees());
 
-  SharedMutex mutex;
   do {
-    UpdateTerrainTiles(archive.get(), rtc, mutex,
+    UpdateTerrainTiles(archive.get(), rtc,
                        rtc.GetWidth() / 2, rtc.GetHeight() / 2, 1000);
   } while (rtc.IsDirty());
 
@@ -29,14 +29,67 @@ Copyright_License {
 #include "OS/Args.hpp"
 #include "IO/ZipArchive.hpp"
 #include "Operation/Operation.hpp"
+#include "Thread/ThreadPool.hpp"
+#include "Util/StaticArray.hxx"
 #include "Util/PrintException.hxx"
 
+#include <chrono>
+
 #include <stdio.h>
 #include <string.h>
 #include <tchar.h>
 
 unsigned Layout::scale_1024 = 1024;
 
+static void
+Fill(HeightMatrix &matrix, const RasterMap &map,
+     const WindowProjection &projection, ThreadPool *pool)
+{
+#ifdef ENABLE_OPENGL
+  matrix.Fill(map, projection.GetScreenBounds(),
+              projection.GetScreenWidth(), projection.GetScreenHeight(),
+              false, pool);
+#else
+  matrix.Fill(map, projection, 1, false, pool);
+#endif
+}
+
+/**
+ * Fill the #HeightMatrix repeatedly with the given number of threads
+ * and print the throughput.
+ *
+ * @return false if the result differs from the single-threaded one
+ */
+static bool
+Benchmark(const RasterMap &map, const WindowProjection &projection,
+          unsigned n_threads, const HeightMatrix &reference)
+{
+  using std::chrono::steady_clock;
+
+  ThreadPool pool("Benchmark", n_threads - 1);
+
+  HeightMatrix matrix;
+  Fill(matrix, map, projection, &pool);
+
+  unsigned n_rows = 0;
+  const auto start = steady_clock::now();
+  std::chrono::duration<double> elapsed;
+  do {
+    Fill(matrix, map, projection, &pool);
+    n_rows += matrix.GetHeight();
+    elapsed = steady_clock::now() - start;
+  } while (elapsed < std::chrono::seconds(1));
+
+  printf("threads=%u actual=%u rows/s=%.0f\n",
+         n_threads, pool.GetConcurrency(), n_rows / elapsed.count());
+
+  return matrix.GetWidth() == reference.GetWidth() &&
+    matrix.GetHeight() == reference.GetHeight() &&
+    memcmp(matrix.GetData(), reference.GetData(),
+           reference.GetWidth() * reference.GetHeight()
+           * sizeof(*reference.GetData())) == 0;
+}
+
 int main(int argc, char **argv)
 try {
   Args args(argc, argv, "PATH");
@@ -56,9 +109,8 @@ try {
 
   map.UpdateProjection();
 
-  SharedMutex mutex;
   do {
-    UpdateTerrainTiles(archive.get(), map.GetTileCache(), mutex,
+    UpdateTerrainTiles(archive.get(), map.GetTileCache(),
                        map.GetProjection(),
                        map.GetMapCenter(), 50000);
   } while (map.IsDirty());
@@ -71,16 +123,24 @@ try {
   projection.SetScreenOrigin(320, 240);
   projection.UpdateScreenBounds();
 
-  HeightMatrix matrix;
-#ifdef ENABLE_OPENGL
-  matrix.Fill(map, projection.GetScreenBounds(),
-              projection.GetScreenWidth(), projection.GetScreenHeight(),
-              false);
-#else
-  matrix.Fill(map, projection, 1, false);
-#endif
+  HeightMatrix reference;
+  Fill(reference, map, projection, nullptr);
+
+  /* 1, 2, 4 and all CPU cores */
+  const unsigned n_cpus = ThreadPool::GetCPUCount();
+  StaticArray<unsigned, 4> thread_counts{1, 2, 4};
+  if (!thread_counts.contains(n_cpus))
+    thread_counts.push_back(n_cpus);
+
+  bool success = true;
+  for (unsigned n_threads : thread_counts) {
+    if (!Benchmark(map, projection, n_threads, reference)) {
+      fprintf(stderr, "result with %u threads differs\n", n_threads);
+      success = false;
+    }
+  }
 
-  return EXIT_SUCCESS;
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
 } catch (const std::runtime_error &e) {
   PrintException(e);
   return EXIT_FAILURE;
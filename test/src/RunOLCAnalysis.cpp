@@ -25,6 +25,7 @@
 #include "Printing.hpp"
 #include "OS/Args.hpp"
 #include "DebugReplay.hpp"
+#include "Thread/ThreadPool.hpp"
 
 #include <cassert>
 #include <stdio.h>
@@ -61,6 +62,8 @@ static ContestManager sis_at(Contest::SIS_AT,
 static ContestManager olc_netcoupe(Contest::NET_COUPE,
                                    full_trace, triangle_trace, sprint_trace);
 
+static ThreadPool solver_pool("ContestSolver", 64);
+
 static int
 TestOLC(DebugReplay &replay)
 {
@@ -94,6 +97,10 @@ TestOLC(DebugReplay &replay)
     olc_league.UpdateIdle();
   }
 
+  olc_fai.SetThreadPool(&solver_pool);
+  olc_plus.SetThreadPool(&solver_pool);
+  xcontest.SetThreadPool(&solver_pool);
+
   olc_classic.SolveExhaustive();
   olc_fai.SolveExhaustive();
   olc_league.SolveExhaustive();
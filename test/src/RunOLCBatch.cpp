@@ -0,0 +1,203 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * This program solves all contests for a number of IGC files and
+ * prints the results as JSON, in the order of the command line.  The
+ * files are analysed in parallel on all CPU cores; this allows
+ * scoring a large collection of flights quickly, and comparing the
+ * results of two versions of the contest solvers.
+ *
+ * Usage: RunOLCBatch FILE.igc ...
+ */
+
+#include "Engine/Trace/Trace.hpp"
+#include "Contest/ContestManager.hpp"
+#include "DebugReplayIGC.hpp"
+#include "ContestJSON.hpp"
+#include "Thread/ThreadPool.hpp"
+#include "JSON/Writer.hpp"
+#include "IO/StdioOutputStream.hxx"
+#include "IO/BufferedOutputStream.hxx"
+#include "OS/Args.hpp"
+#include "OS/ConvertPathName.hpp"
+#include "Util/Exception.hxx"
+#include "Util/Macros.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+struct ContestInfo {
+  const char *name;
+  Contest contest;
+
+  /**
+   * The number of results in #ContestStatistics.
+   */
+  unsigned n_results;
+};
+
+static constexpr ContestInfo contests[] = {
+  { "olc_classic", Contest::OLC_CLASSIC, 1 },
+  { "olc_league", Contest::OLC_LEAGUE, 2 },
+  { "olc_fai", Contest::OLC_FAI, 1 },
+  { "olc_sprint", Contest::OLC_SPRINT, 1 },
+  { "olc_plus", Contest::OLC_PLUS, 3 },
+  { "dmst", Contest::DMST, 1 },
+  { "xcontest", Contest::XCONTEST, 2 },
+  { "sis_at", Contest::SIS_AT, 1 },
+  { "net_coupe", Contest::NET_COUPE, 1 },
+};
+
+static constexpr unsigned N_CONTESTS = ARRAY_SIZE(contests);
+
+struct FlightResult {
+  /**
+   * The error message; empty if the file was analysed successfully.
+   */
+  std::string error;
+
+  ContestStatistics stats[N_CONTESTS];
+};
+
+static void
+Replay(DebugReplay &replay,
+       Trace &full_trace, Trace &triangle_trace, Trace &sprint_trace)
+{
+  bool released = false;
+
+  while (replay.Next()) {
+    const MoreData &basic = replay.Basic();
+    if (!basic.time_available || !basic.location_available ||
+        !basic.NavAltitudeAvailable())
+      continue;
+
+    if (!released && replay.Calculated().flight.release_time >= 0) {
+      released = true;
+
+      triangle_trace.EraseEarlierThan(replay.Calculated().flight.release_time);
+      full_trace.EraseEarlierThan(replay.Calculated().flight.release_time);
+      sprint_trace.EraseEarlierThan(replay.Calculated().flight.release_time);
+    }
+
+    const TracePoint point(basic);
+    triangle_trace.push_back(point);
+    full_trace.push_back(point);
+    sprint_trace.push_back(point);
+  }
+}
+
+/**
+ * Analyse one file.  This runs in a #ThreadPool worker; the solvers
+ * use the same #ThreadPool, which lets idle workers help with the
+ * expensive triangle searches when only few files are left.
+ */
+static void
+AnalyseFlight(Path path, ThreadPool &pool, FlightResult &result) noexcept
+try {
+  const std::unique_ptr<DebugReplay> replay(DebugReplayIGC::Create(path));
+
+  /* same as RunOLCAnalysis */
+  Trace full_trace(0, Trace::null_time, 512);
+  Trace triangle_trace(0, Trace::null_time, 1024);
+  Trace sprint_trace(0, 9000, 128);
+
+  Replay(*replay, full_trace, triangle_trace, sprint_trace);
+
+  for (unsigned i = 0; i < N_CONTESTS; ++i) {
+    ContestManager manager(contests[i].contest,
+                           full_trace, triangle_trace, sprint_trace);
+    manager.SetThreadPool(&pool);
+    manager.SolveExhaustive();
+    result.stats[i] = manager.GetStats();
+  }
+} catch (const std::exception &e) {
+  result.error = GetFullMessage(e);
+}
+
+static void
+WriteResults(BufferedOutputStream &writer, const ContestStatistics &stats,
+             unsigned n_results)
+{
+  JSON::ArrayWriter array(writer);
+
+  for (unsigned i = 0; i < n_results; ++i)
+    array.WriteElement(WriteContest, stats.result[i], stats.solution[i]);
+}
+
+static void
+WriteContests(BufferedOutputStream &writer, const FlightResult &result)
+{
+  JSON::ObjectWriter object(writer);
+
+  for (unsigned i = 0; i < N_CONTESTS; ++i)
+    object.WriteElement(contests[i].name, WriteResults,
+                        result.stats[i], contests[i].n_results);
+}
+
+static void
+WriteFlight(BufferedOutputStream &writer, Path path,
+            const FlightResult &result)
+{
+  JSON::ObjectWriter object(writer);
+
+  object.WriteElement("file", JSON::WriteString, NarrowPathName(path));
+
+  if (!result.error.empty())
+    object.WriteElement("error", JSON::WriteString, result.error.c_str());
+  else
+    object.WriteElement("contests", WriteContests, result);
+}
+
+int main(int argc, char **argv)
+{
+  Args args(argc, argv, "FILE.igc ...");
+
+  std::vector<AllocatedPath> paths;
+  do {
+    paths.emplace_back(args.ExpectNextPath());
+  } while (!args.IsEmpty());
+
+  std::vector<FlightResult> results(paths.size());
+
+  ThreadPool pool("RunOLCBatch", ThreadPool::GetCPUCount());
+  pool.Run(paths.size(), [&](unsigned i){
+      AnalyseFlight(paths[i], pool, results[i]);
+    });
+
+  StdioOutputStream os(stdout);
+  BufferedOutputStream writer(os);
+
+  {
+    JSON::ArrayWriter array(writer);
+    for (unsigned i = 0; i < paths.size(); ++i)
+      array.WriteElement(WriteFlight, Path(paths[i]), results[i]);
+  }
+
+  writer.Write('\n');
+  writer.Flush();
+
+  return EXIT_SUCCESS;
+}
@@ -22,6 +22,7 @@ Copyright_License {
 */
 
 #include "Airspace/AirspaceParser.hpp"
+#include "Airspace/AirspaceCache.hpp"
 #include "Engine/Airspace/AbstractAirspace.hpp"
 #include "Engine/Airspace/AirspaceCircle.hpp"
 #include "Engine/Airspace/AirspacePolygon.hpp"
@@ -29,9 +30,12 @@ Copyright_License {
 #include "Units/System.hpp"
 #include "Util/Macros.hpp"
 #include "Util/StringAPI.hxx"
+#include "Util/StringCompare.hxx"
+#include "Util/StaticString.hxx"
 #include "Util/PrintException.hxx"
 #include "IO/FileLineReader.hpp"
 #include "Operation/Operation.hpp"
+#include "Thread/ThreadPool.hpp"
 #include "TestUtil.hpp"
 
 #include <tchar.h>
@@ -273,12 +277,221 @@ TestTNP()
   }
 }
 
+gcc_pure
+static bool
+Equals(const AirspaceAltitude &a, const AirspaceAltitude &b)
+{
+  return a.reference == b.reference && a.altitude == b.altitude &&
+    a.flight_level == b.flight_level &&
+    a.altitude_above_terrain == b.altitude_above_terrain;
+}
+
+gcc_pure
+static bool
+Equals(const AbstractAirspace &a, const AbstractAirspace &b)
+{
+  if (a.GetShape() != b.GetShape() || a.GetType() != b.GetType() ||
+      !StringIsEqual(a.GetName(), b.GetName()) ||
+      a.GetRadioText() != b.GetRadioText() ||
+      !a.GetDays().equals(b.GetDays()) ||
+      !Equals(a.GetBase(), b.GetBase()) || !Equals(a.GetTop(), b.GetTop()))
+    return false;
+
+  const SearchPointVector &pa = a.GetPoints(), &pb = b.GetPoints();
+  if (pa.size() != pb.size())
+    return false;
+
+  for (unsigned i = 0; i < pa.size(); ++i)
+    if (pa[i].GetLocation() != pb[i].GetLocation())
+      return false;
+
+  return true;
+}
+
+static void
+TestCache()
+{
+  const Path path(_T("test/data/airspace/openair.txt"));
+
+  Airspaces airspaces;
+  {
+    FileLineReader reader(path, Charset::AUTO);
+    AirspaceParser parser(airspaces);
+    NullOperationEnvironment operation;
+    parser.Parse(reader, operation);
+  }
+
+  const auto &parsed = airspaces.GetPending();
+
+  FILE *file = tmpfile();
+  if (file == nullptr) {
+    skip(6, 0, "Failed to create temporary file");
+    return;
+  }
+
+  ok1(SaveAirspaceCache(file, path,
+                        std::vector<const AbstractAirspace *>(parsed.begin(),
+                                                              parsed.end())));
+  const long size = ftell(file);
+
+  /* the cache must not be used for a different source file */
+  Airspaces other;
+  rewind(file);
+  ok1(!LoadAirspaceCache(file, Path(_T("test/data/airspace/tnp.sua")),
+                         other));
+
+  Airspaces loaded;
+  rewind(file);
+  ok1(LoadAirspaceCache(file, path, loaded));
+
+  const auto &restored = loaded.GetPending();
+  bool equal = restored.size() == parsed.size();
+  for (unsigned i = 0; equal && i < parsed.size(); ++i)
+    equal = Equals(*parsed[i], *restored[i]);
+  ok1(equal);
+
+  /* a truncated file adds nothing */
+  std::vector<char> buffer(size / 2);
+  rewind(file);
+  FILE *truncated_file = tmpfile();
+  if (truncated_file != nullptr &&
+      fread(buffer.data(), 1, buffer.size(), file) == buffer.size() &&
+      fwrite(buffer.data(), 1, buffer.size(), truncated_file) == buffer.size()) {
+    Airspaces truncated;
+    rewind(truncated_file);
+    ok1(!LoadAirspaceCache(truncated_file, path, truncated));
+    ok1(truncated.GetPending().empty());
+  } else
+    skip(2, 0, "Failed to create temporary file");
+
+  if (truncated_file != nullptr)
+    fclose(truncated_file);
+
+  fclose(file);
+}
+
+static void
+TestParallel(Path path, unsigned n_workers)
+{
+  Airspaces serial, parallel;
+
+  {
+    FileLineReader reader(path, Charset::AUTO);
+    AirspaceParser parser(serial);
+    NullOperationEnvironment operation;
+    parser.Parse(reader, operation);
+  }
+
+  {
+    /* with zero worker threads, the chunks are parsed by the calling
+       thread, but the input is still split */
+    ThreadPool pool("TestAirspaceParser", n_workers);
+    FileLineReader reader(path, Charset::AUTO);
+    AirspaceParser parser(parallel, &pool);
+    NullOperationEnvironment operation;
+    ok1(parser.Parse(reader, operation));
+  }
+
+  const auto &a = serial.GetPending(), &b = parallel.GetPending();
+  bool equal = a.size() == b.size();
+  for (unsigned i = 0; equal && i < a.size(); ++i)
+    equal = Equals(*a[i], *b[i]);
+  ok1(equal);
+}
+
+/**
+ * Each chunk begins with an airspace which inherits the name of the
+ * previous record (from another chunk).
+ */
+static void
+TestParallelInheritedName()
+{
+  const Path path(_T("test/data/airspace/openair_inherited_name.txt"));
+  TestParallel(path, 3);
+
+  Airspaces airspaces;
+  ThreadPool pool("TestAirspaceParser", 3);
+  FileLineReader reader(path, Charset::AUTO);
+  AirspaceParser parser(airspaces, &pool);
+  NullOperationEnvironment operation;
+  parser.Parse(reader, operation);
+
+  const auto &parsed = airspaces.GetPending();
+  bool names = parsed.size() == 64 && StringIsEmpty(parsed[0]->GetName());
+  for (unsigned i = 1; names && i < parsed.size(); ++i) {
+    StaticString<32> expected;
+    expected.Format(_T("Inherited-%u"), i);
+    names = expected == parsed[i]->GetName();
+  }
+
+  ok1(names);
+}
+
+/**
+ * An #OperationEnvironment which remembers the error message.
+ */
+class ErrorOperationEnvironment : public NullOperationEnvironment {
+public:
+  StaticString<256> error;
+
+  ErrorOperationEnvironment() {
+    error.clear();
+  }
+
+  void SetErrorMessage(const TCHAR *text) override {
+    error = text;
+  }
+};
+
+/**
+ * A line fails to parse: the parallel parser must report it with the
+ * same line number as the serial parser, and drop the airspaces of
+ * the following chunks.
+ */
+static void
+TestParallelParseError()
+{
+  const Path path(_T("test/data/airspace/openair_parse_error.txt"));
+
+  Airspaces serial, parallel;
+  ErrorOperationEnvironment serial_operation, parallel_operation;
+
+  {
+    FileLineReader reader(path, Charset::AUTO);
+    AirspaceParser parser(serial);
+    ok1(!parser.Parse(reader, serial_operation));
+  }
+
+  {
+    ThreadPool pool("TestAirspaceParser", 3);
+    FileLineReader reader(path, Charset::AUTO);
+    AirspaceParser parser(parallel, &pool);
+    ok1(!parser.Parse(reader, parallel_operation));
+  }
+
+  ok1(StringFind(serial_operation.error.c_str(), _T(": 244\r\n")) != nullptr);
+  ok1(serial_operation.error == parallel_operation.error.c_str());
+
+  /* only the circles before the broken one */
+  const auto &a = serial.GetPending(), &b = parallel.GetPending();
+  bool equal = a.size() == 19 && b.size() == a.size();
+  for (unsigned i = 0; equal && i < a.size(); ++i)
+    equal = Equals(*a[i], *b[i]);
+  ok1(equal);
+}
+
 int main(int argc, char **argv)
 try {
-  plan_tests(102);
+  plan_tests(122);
 
   TestOpenAir();
   TestTNP();
+  TestCache();
+  TestParallel(Path(_T("test/data/airspace/openair.txt")), 0);
+  TestParallel(Path(_T("test/data/airspace/openair.txt")), 3);
+  TestParallel(Path(_T("test/data/airspace/tnp.sua")), 3);
+  TestParallelInheritedName();
+  TestParallelParseError();
 
   return exit_status();
 } catch (const std::runtime_error &e) {
@@ -0,0 +1,163 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Engine/Contest/Solvers/CandidateQueue.hpp"
+#include "TestUtil.hpp"
+
+#include <map>
+#include <random>
+
+typedef CandidateQueue<unsigned> Queue;
+typedef std::multimap<unsigned, unsigned> Reference;
+
+/**
+ * Does the entry at the given position match the std::multimap
+ * iterator, i.e. is the #CandidateQueue ordered exactly like a
+ * std::multimap?
+ */
+static bool
+Equals(const Queue &queue, Queue::Position p, Reference::const_iterator i)
+{
+  return queue.GetKey(p) == i->first && queue.Get(p) == i->second;
+}
+
+static bool
+Equals(const Queue &queue, const Reference &reference)
+{
+  if (queue.size() != reference.size())
+    return false;
+
+  if (queue.empty())
+    return true;
+
+  if (!Equals(queue, queue.Last(), std::prev(reference.end())))
+    return false;
+
+  const unsigned middle = reference.rbegin()->first / 2;
+  auto i = reference.upper_bound(middle);
+  if (i == reference.end())
+    --i;
+
+  return Equals(queue, queue.UpperBound(middle), i);
+}
+
+/**
+ * Drain both containers, verifying that they contain the same
+ * entries in the same order.
+ */
+static bool
+Drain(Queue &queue, Reference &reference)
+{
+  while (!reference.empty()) {
+    if (queue.empty() ||
+        !Equals(queue, queue.Last(), std::prev(reference.end())))
+      return false;
+
+    queue.Erase(queue.Last());
+    reference.erase(std::prev(reference.end()));
+  }
+
+  return queue.empty();
+}
+
+/**
+ * Apply the same random sequence of operations (resembling the one
+ * of TriangleContest's branch and bound algorithm) to both
+ * containers.
+ */
+static bool
+RandomOperations(Queue &queue, Reference &reference,
+                 unsigned n, unsigned max_key)
+{
+  std::minstd_rand random;
+  unsigned value = 0;
+
+  for (unsigned i = 0; i < n; ++i) {
+    const unsigned op = random() % 16;
+
+    if (op < 10 || reference.empty()) {
+      const unsigned key = random() % max_key;
+      queue.Insert(key, value);
+      reference.emplace(key, value);
+      ++value;
+    } else if (op < 13) {
+      queue.Erase(queue.Last());
+      reference.erase(std::prev(reference.end()));
+    } else if (op < 15) {
+      const unsigned middle = reference.rbegin()->first / 2;
+      auto j = reference.upper_bound(middle);
+      if (j == reference.end())
+        --j;
+
+      queue.Erase(queue.UpperBound(middle));
+      reference.erase(j);
+    } else {
+      const unsigned key = random() % (max_key / 8);
+      queue.EraseBelow(key);
+      reference.erase(reference.begin(), reference.lower_bound(key));
+    }
+
+    if (!Equals(queue, reference))
+      return false;
+  }
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(10);
+
+  Queue queue;
+  ok1(queue.empty());
+
+  queue.Insert(3, 30);
+  queue.Insert(1, 10);
+  queue.Insert(3, 31);
+  queue.Insert(2, 20);
+  ok1(queue.size() == 4);
+
+  /* the last one of several equal keys comes last */
+  ok1(queue.GetKey(queue.Last()) == 3 && queue.Get(queue.Last()) == 31);
+
+  /* the first one of several equal keys comes first */
+  ok1(queue.Get(queue.UpperBound(2)) == 30);
+
+  /* no larger key: returns the last entry */
+  ok1(queue.Get(queue.UpperBound(3)) == 31);
+
+  queue.EraseBelow(3);
+  ok1(queue.size() == 2);
+
+  queue.clear();
+  ok1(queue.empty());
+
+  Reference reference;
+
+  /* many duplicate keys */
+  ok1(RandomOperations(queue, reference, 20000, 100));
+  ok1(RandomOperations(queue, reference, 20000, 1000000));
+  ok1(Drain(queue, reference));
+
+  return exit_status();
+}
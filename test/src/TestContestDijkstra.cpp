@@ -0,0 +1,122 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Engine/Contest/Solvers/OLCClassic.hpp"
+#include "Engine/Trace/Trace.hpp"
+#include "IGC/IGCParser.hpp"
+#include "IGC/IGCFix.hpp"
+#include "IGC/IGCExtensions.hpp"
+#include "IO/FileLineReader.hpp"
+#include "OS/Path.hpp"
+#include "TestUtil.hpp"
+#include "Util/PrintException.hxx"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <math.h>
+
+/**
+ * Solve the trace from scratch, without the incremental solver.
+ */
+static double
+SolveFull(const Trace &trace)
+{
+  OLCClassic olc(trace);
+  olc.Reset();
+  olc.Solve(true, nullptr);
+  return olc.GetBestResult().score;
+}
+
+/**
+ * Replay the IGC file into a small #Trace, which gets thinned often,
+ * and run the incremental solver after every fix.  After each
+ * thinning step, which makes the solver patch its Dijkstra edge map,
+ * compare its result with a full solve of the same trace.
+ */
+static void
+TestPatchEdges(Path path, unsigned max_points)
+{
+  Trace trace(0, Trace::null_time, max_points);
+
+  OLCClassic olc(trace);
+  olc.Reset();
+  olc.SetIncremental(true);
+
+  FileLineReaderA reader(path);
+  IGCExtensions extensions;
+  extensions.clear();
+
+  unsigned n_thinned = 0;
+  double max_error = 0;
+
+  char *line;
+  while ((line = reader.ReadLine()) != nullptr) {
+    IGCFix fix;
+    if (!IGCParseFix(line, extensions, fix) || !fix.gps_valid)
+      continue;
+
+    const Serial modify_serial = trace.GetModifySerial();
+    trace.push_back(TracePoint(fix.location,
+                               unsigned(fix.time.GetSecondOfDay()),
+                               fix.gps_altitude, 0, 0));
+    const bool thinned = trace.GetModifySerial() != modify_serial;
+
+    while (olc.Solve(false, nullptr) == SolverResult::INCOMPLETE) {}
+
+    if (!thinned)
+      continue;
+
+    ++n_thinned;
+
+    /* the incremental solver is a heuristic, and it remembers the
+       best result even if some of its points have been thinned out,
+       so only a small deviation is expected */
+    const double full = SolveFull(trace);
+    if (full > 0)
+      max_error = std::max(max_error,
+                           fabs(olc.GetBestResult().score - full) / full);
+  }
+
+  ok1(n_thinned > 0);
+  ok(max_error < 0.03, "incremental vs. full after thinning", 0);
+
+  /* after the last fix, the incremental solver must not be worse
+     than a full solve */
+  olc.Solve(true, nullptr);
+  ok(olc.GetBestResult().score >= SolveFull(trace), "final score", 0);
+}
+
+int main(int argc, char **argv)
+try {
+  plan_tests(9);
+
+  TestPatchEdges(Path(_T("test/data/0asljd01.igc")), 128);
+  TestPatchEdges(Path(_T("test/data/01lz1hq1.igc")), 128);
+  TestPatchEdges(Path(_T("test/data/9crx3101.igc")), 128);
+
+  return exit_status();
+} catch (const std::runtime_error &e) {
+  PrintException(e);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,161 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Geo/EdgeBandIndex.hpp"
+#include "Geo/ConvexHull/PolygonInterior.hpp"
+#include "Geo/SearchPointVector.hpp"
+#include "TestUtil.hpp"
+
+#include <random>
+#include <vector>
+
+/**
+ * Generate a closed, star-shaped (and often self-touching) random
+ * polygon around the given centre.
+ */
+static SearchPointVector
+RandomPolygon(std::minstd_rand &random, unsigned n)
+{
+  std::uniform_real_distribution<double> radius(0.1, 1);
+
+  SearchPointVector polygon;
+  for (unsigned i = 0; i < n; ++i) {
+    const Angle angle = Angle::FullCircle() * i / n;
+    const double r = radius(random);
+    polygon.emplace_back(GeoPoint(Angle::Degrees(7 + r * angle.cos()),
+                                  Angle::Degrees(51 + r * angle.sin())));
+  }
+
+  polygon.emplace_back(polygon.front().GetLocation());
+  return polygon;
+}
+
+/**
+ * Verify that Visit() visits each edge overlapping the query range
+ * exactly once.
+ */
+static bool
+CheckVisit(const std::vector<int> &ys, const EdgeBandIndex<int> &index,
+           int y1, int y2)
+{
+  const unsigned n_edges = ys.size() - 1;
+  std::vector<unsigned> visited(n_edges, 0);
+  index.Visit(y1, y2, [&visited](unsigned i){
+      ++visited[i];
+    });
+
+  for (unsigned i = 0; i < n_edges; ++i) {
+    if (visited[i] > 1)
+      return false;
+
+    const int lo = std::min(ys[i], ys[i + 1]);
+    const int hi = std::max(ys[i], ys[i + 1]);
+    if (lo <= std::max(y1, y2) && hi >= std::min(y1, y2) && visited[i] == 0)
+      return false;
+  }
+
+  return true;
+}
+
+static bool
+TestIntegerIndex(unsigned n, unsigned n_bands)
+{
+  std::minstd_rand random;
+  std::uniform_int_distribution<int> y(-1000, 1000);
+
+  std::vector<int> ys;
+  for (unsigned i = 0; i < n; ++i)
+    ys.push_back(y(random));
+  ys.push_back(ys.front());
+
+  EdgeBandIndex<int> index;
+  index.Build(n, n_bands, [&ys](unsigned i){ return ys[i]; });
+
+  for (unsigned i = 0; i < 1000; ++i)
+    if (!CheckVisit(ys, index, y(random), y(random)))
+      return false;
+
+  /* ranges outside of the polygon */
+  return CheckVisit(ys, index, -2000, -1500) &&
+    CheckVisit(ys, index, 1500, 2000) &&
+    CheckVisit(ys, index, -2000, 2000);
+}
+
+/**
+ * Compare a winding number test on the indexed edges with
+ * PolygonInterior().
+ */
+static bool
+TestInterior(unsigned n)
+{
+  std::minstd_rand random;
+  const SearchPointVector polygon = RandomPolygon(random, n);
+
+  EdgeBandIndex<double> index;
+  index.Build(n, n / 4, [&polygon](unsigned i){
+      return polygon[i].GetLocation().latitude.Native();
+    });
+
+  std::uniform_real_distribution<double> offset(-1.2, 1.2);
+  for (unsigned i = 0; i < 10000; ++i) {
+    /* include the vertices, which are corner cases */
+    const GeoPoint p = i < n
+      ? polygon[i].GetLocation()
+      : GeoPoint(Angle::Degrees(7 + offset(random)),
+                 Angle::Degrees(51 + offset(random)));
+
+    int winding = 0;
+    const double latitude = p.latitude.Native();
+    index.Visit(latitude, latitude, [&](unsigned j){
+        winding += PolygonEdgeWinding(p, polygon[j].GetLocation(),
+                                      polygon[j + 1].GetLocation());
+      });
+
+    if ((winding != 0) != PolygonInterior(p, polygon.begin(), polygon.end()))
+      return false;
+  }
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(7);
+
+  EdgeBandIndex<int> index;
+  ok1(!index.IsDefined());
+
+  /* a horizontal polygon collapses into one band */
+  const std::vector<int> flat{5, 5, 5, 5, 5};
+  index.Build(4, 2, [&flat](unsigned i){ return flat[i]; });
+  ok1(index.IsDefined());
+  ok1(CheckVisit(flat, index, 5, 5));
+
+  ok1(TestIntegerIndex(100, 25));
+  ok1(TestIntegerIndex(1000, 5000));
+
+  ok1(TestInterior(64));
+  ok1(TestInterior(1000));
+
+  return exit_status();
+}
@@ -0,0 +1,114 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Util/FlatHashMap.hpp"
+#include "TestUtil.hpp"
+
+#include <random>
+#include <unordered_map>
+
+typedef FlatHashMap<unsigned, unsigned> Map;
+typedef std::unordered_map<unsigned, unsigned> Reference;
+
+static bool
+Equals(const Map &map, const Reference &reference)
+{
+  if (map.size() != reference.size())
+    return false;
+
+  for (const auto &i : reference) {
+    auto j = map.find(i.first);
+    if (j == map.end() || j->first != i.first || j->second != i.second)
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * Insert random keys into both containers, and modify existing
+ * values through an iterator obtained before the container has grown.
+ */
+static bool
+RandomOperations(Map &map, Reference &reference,
+                 unsigned n, unsigned max_key)
+{
+  std::minstd_rand random;
+
+  for (unsigned i = 0; i < n; ++i) {
+    /* keys which differ only in the upper bits, like ScanTaskPoint */
+    const unsigned key = (random() % max_key) << 16 | random() % 4;
+
+    const auto result = map.insert(std::make_pair(key, i));
+    const bool inserted = reference.insert(std::make_pair(key, i)).second;
+    if (result.second != inserted || result.first->first != key)
+      return false;
+
+    if (!inserted && random() % 2 == 0) {
+      result.first->second = i;
+      reference[key] = i;
+    }
+  }
+
+  return Equals(map, reference) && map.find(~0u) == map.end();
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(11);
+
+  Map map;
+  ok1(map.empty());
+  ok1(map.find(1) == map.end());
+
+  auto a = map.insert(std::make_pair(1u, 10u));
+  ok1(a.second);
+  ok1(!map.insert(std::make_pair(1u, 11u)).second);
+  ok1(map.find(1)->second == 10);
+
+  /* iterators survive growing the container */
+  for (unsigned i = 2; i < 1000; ++i)
+    map.insert(std::make_pair(i, i * 10));
+  ok1(a.first->first == 1 && a.first->second == 10);
+
+  /* iteration in insertion order */
+  unsigned expected = 1;
+  bool ordered = true;
+  for (const auto &i : map)
+    ordered &= i.first == expected++;
+  ok1(ordered && expected == 1000);
+
+  map.clear();
+  ok1(map.empty());
+  ok1(map.find(1) == map.end());
+
+  Reference reference;
+  ok1(RandomOperations(map, reference, 20000, 100));
+
+  /* reuse after clear() */
+  map.clear();
+  reference.clear();
+  ok1(RandomOperations(map, reference, 50000, 1000000));
+
+  return exit_status();
+}
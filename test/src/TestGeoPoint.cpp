@@ -29,7 +29,7 @@
 
 int main(int argc, char **argv)
 {
-  plan_tests(92);
+  plan_tests(95);
 
   // test constructor
   GeoPoint p1(Angle::Degrees(345.32), Angle::Degrees(-6.332));
@@ -118,6 +118,11 @@ int main(int argc, char **argv)
   ok1(equals(p1.Distance(p11), 1.561761));
   ok1(equals(p1.Distance(p12), 18599361.600));
 
+  // test the precalculated variant
+  ok1(Distance(PreparedGeoPoint(p2), PreparedGeoPoint(p6)) == p2.Distance(p6));
+  ok1(Distance(PreparedGeoPoint(p1), PreparedGeoPoint(p3)) == p1.Distance(p3));
+  ok1(Distance(PreparedGeoPoint(p1), PreparedGeoPoint(p11)) == p1.Distance(p11));
+
   ok1(equals(p2.DistanceS(p6), 869326.653160));
   ok1(equals(p6.DistanceS(p2), 869326.653160));
   ok1(equals(p1.DistanceS(p5), 309562.219016));
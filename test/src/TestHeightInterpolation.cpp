@@ -0,0 +1,112 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Terrain/RasterBuffer.hpp"
+#include "Terrain/RasterLocation.hpp"
+
+extern "C" {
+#include "tap.h"
+}
+
+#include <stdlib.h>
+
+static constexpr unsigned WIDTH = 67, HEIGHT = 43;
+static constexpr unsigned N = 1001;
+
+/**
+ * Fill the buffer with random heights, including negative and
+ * "special" values.
+ */
+static void
+FillRandom(RasterBuffer &buffer)
+{
+  TerrainHeight *p = buffer.GetData();
+  for (unsigned i = 0; i < WIDTH * HEIGHT; ++i) {
+    const int r = rand();
+    if (r % 97 == 0)
+      p[i] = TerrainHeight::Invalid();
+    else if (r % 89 == 0)
+      p[i] = TerrainHeight(-31000);
+    else if (r % 5 == 0)
+      p[i] = TerrainHeight(int16_t(r % 65536 - 32768));
+    else
+      p[i] = TerrainHeight(int16_t(r % 9000 - 400));
+  }
+}
+
+/**
+ * Verify that the batched (SIMD) interpolation returns exactly the
+ * same values as the scalar implementation.
+ */
+static bool
+CompareBatch(const RasterBuffer &buffer)
+{
+  RasterLocation locations[N];
+  for (auto &l : locations) {
+    l.x = rand() % buffer.GetFineWidth();
+    l.y = rand() % buffer.GetFineHeight();
+  }
+
+  /* include the right and bottom edges */
+  locations[0] = RasterLocation(buffer.GetFineWidth() - 1, 0);
+  locations[1] = RasterLocation(0, buffer.GetFineHeight() - 1);
+  locations[2] = RasterLocation(buffer.GetFineWidth() - 1,
+                                buffer.GetFineHeight() - 1);
+
+  TerrainHeight result[N];
+  buffer.GetInterpolated(locations, result, N);
+
+  for (unsigned i = 0; i < N; ++i)
+    if (result[i].GetValue() !=
+        buffer.GetInterpolated(locations[i].x, locations[i].y).GetValue())
+      return false;
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(8);
+
+  RasterBuffer buffer(WIDTH, HEIGHT);
+
+  for (unsigned i = 0; i < 4; ++i) {
+    FillRandom(buffer);
+    ok1(CompareBatch(buffer));
+  }
+
+  /* a horizontal and a diagonal interpolated scan */
+  TerrainHeight line[N];
+  buffer.ScanLine(0, 77, buffer.GetFineWidth() - 1, 77, line, N, true);
+  ok1(line[0].GetValue() == buffer.GetInterpolated(0, 77).GetValue());
+  ok1(line[N - 1].GetValue() ==
+      buffer.GetInterpolated(buffer.GetFineWidth() - 1, 77).GetValue());
+
+  buffer.ScanLine(0, 0, buffer.GetFineWidth() - 1,
+                  buffer.GetFineHeight() - 1, line, N, true);
+  ok1(line[0].GetValue() == buffer.GetInterpolated(0, 0).GetValue());
+  ok1(line[N / 2].GetValue() ==
+      buffer.GetInterpolated((buffer.GetFineWidth() - 1) / 2,
+                             (buffer.GetFineHeight() - 1) / 2).GetValue());
+
+  return exit_status();
+}
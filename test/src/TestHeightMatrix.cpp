@@ -0,0 +1,191 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "TestUtil.hpp"
+
+#ifdef ENABLE_OPENGL
+
+int
+main(int argc, char **argv)
+{
+  /* HeightMatrix::Shift() is only used by the software renderer */
+  plan_skip_all((char *)"no HeightMatrix::Shift() with OpenGL");
+  return exit_status();
+}
+
+#else
+
+#include "Terrain/RasterMap.hpp"
+#include "Terrain/HeightMatrix.hpp"
+#include "Terrain/Loader.hpp"
+#include "Projection/WindowProjection.hpp"
+#include "Operation/Operation.hpp"
+#include "Thread/ThreadPool.hpp"
+#include "Util/Macros.hpp"
+#include "Util/Compiler.h"
+
+#include <zzip/zzip.h>
+
+#include <cassert>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr unsigned q = 2;
+
+/**
+ * The largest height difference between the two matrices.
+ */
+gcc_pure
+static unsigned
+MaxDifference(const HeightMatrix &a, const HeightMatrix &b)
+{
+  assert(a.GetWidth() == b.GetWidth());
+  assert(a.GetHeight() == b.GetHeight());
+
+  unsigned result = 0;
+  for (auto i = a.GetData(), j = b.GetData(); i != a.GetDataEnd(); ++i, ++j) {
+    const unsigned d = abs(i->GetValue() - j->GetValue());
+    if (d > result)
+      result = d;
+  }
+
+  return result;
+}
+
+/**
+ * The largest allowed difference between a shifted matrix and a
+ * fresh scan.  Rows are sampled along the same line, so a vertical
+ * shift must be exact.  After a horizontal shift, the kept cells
+ * were sampled along a longer or shorter line, and ScanLine()
+ * rounds the sub-pixel positions differently.
+ */
+static constexpr unsigned
+GetTolerance(int dx)
+{
+  return dx == 0 ? 0 : 4;
+}
+
+/**
+ * Shift the matrix within the same projection, i.e. move the origin
+ * by whole cells, and compare it with a fresh scan at the new origin.
+ */
+static void
+TestShiftOrigin(const RasterMap &map, const WindowProjection &projection,
+                int dx, int dy, ThreadPool *pool)
+{
+  HeightMatrix shifted;
+  shifted.Fill(map, projection, q, true, pool);
+
+  const PixelPoint origin(dx * int(q), dy * int(q));
+  shifted.Shift(map, projection, origin, q, dx, dy, true, pool);
+
+  HeightMatrix expected;
+  expected.Fill(map, projection, q, true);
+  expected.FillRect(map, projection, origin, q,
+                    0, expected.GetWidth(), 0, expected.GetHeight(), true);
+
+  ok(MaxDifference(shifted, expected) <= GetTolerance(dx),
+     "shift origin dx=%d dy=%d", dx, dy);
+}
+
+/**
+ * Move the projection by whole cells, and compare the shifted matrix
+ * with a fresh Fill() for the new projection.  The projection is not
+ * exactly linear, therefore the error grows with the distance (see
+ * RasterRenderer::ShiftMap()).
+ */
+static void
+TestShiftProjection(const RasterMap &map, const WindowProjection &projection,
+                    int dx, int dy, ThreadPool *pool)
+{
+  HeightMatrix shifted;
+  shifted.Fill(map, projection, q, true, pool);
+
+  const PixelPoint screen_origin = projection.GetScreenOrigin();
+  WindowProjection moved = projection;
+  moved.SetGeoLocation(projection.ScreenToGeo(screen_origin.x + dx * int(q),
+                                              screen_origin.y + dy * int(q)));
+  moved.UpdateScreenBounds();
+
+  shifted.Shift(map, moved, PixelPoint(0, 0), q, dx, dy, true, pool);
+
+  HeightMatrix expected;
+  expected.Fill(map, moved, q, true);
+
+  ok(MaxDifference(shifted, expected) <= GetTolerance(dx) + abs(dx) / 4,
+     "shift projection dx=%d dy=%d", dx, dy);
+}
+
+int
+main(int argc, char **argv)
+{
+  static const char map_path[] = "tmp/map.xcm";
+
+  ZZIP_DIR *dir = zzip_dir_open(map_path, nullptr);
+  if (dir == nullptr) {
+    fprintf(stderr, "Failed to open %s\n", map_path);
+    return EXIT_FAILURE;
+  }
+
+  RasterMap map;
+
+  NullOperationEnvironment operation;
+  if (!LoadTerrainOverview(dir, map.GetTileCache(), operation)) {
+    fprintf(stderr, "failed to load map\n");
+    zzip_dir_close(dir);
+    return EXIT_FAILURE;
+  }
+
+  map.UpdateProjection();
+
+  do {
+    UpdateTerrainTiles(dir, map.GetTileCache(),
+                       map.GetProjection(),
+                       map.GetMapCenter(), 50000);
+  } while (map.IsDirty());
+  zzip_dir_close(dir);
+
+  WindowProjection projection;
+  projection.SetScreenSize({640, 480});
+  projection.SetScaleFromRadius(50000);
+  projection.SetGeoLocation(map.GetMapCenter());
+  projection.SetScreenOrigin(320, 240);
+  projection.UpdateScreenBounds();
+
+  ThreadPool pool("TestHeightMatrix", 3);
+
+  static constexpr int deltas[][2] = {
+    { 0, 7 }, { 0, -60 }, { 1, 0 }, { -4, 0 }, { 30, -8 }, { -50, 20 },
+  };
+
+  plan_tests(2 * ARRAY_SIZE(deltas));
+
+  for (const auto &d : deltas) {
+    TestShiftOrigin(map, projection, d[0], d[1], &pool);
+    TestShiftProjection(map, projection, d[0], d[1], &pool);
+  }
+
+  return exit_status();
+}
+
+#endif
@@ -0,0 +1,156 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Util/IndexedHeap.hpp"
+#include "TestUtil.hpp"
+
+#include <random>
+#include <set>
+#include <vector>
+
+struct Item : IndexedHeapHook {
+  unsigned key;
+
+  /**
+   * Disambiguates equal keys, so the top is well-defined.
+   */
+  unsigned id;
+
+  bool operator<(const Item &other) const {
+    return key < other.key || (key == other.key && id < other.id);
+  }
+};
+
+struct ItemCompare {
+  bool operator()(const Item &a, const Item &b) const {
+    return a < b;
+  }
+};
+
+typedef IndexedHeap<Item, ItemCompare> Heap;
+typedef IndexedHeap<Item, ItemCompare, 2> BinaryHeap;
+
+struct ItemPointerCompare {
+  bool operator()(const Item *a, const Item *b) const {
+    return *a < *b;
+  }
+};
+
+typedef std::set<Item *, ItemPointerCompare> Reference;
+
+/**
+ * Apply the same random sequence of push/pop/erase/update operations
+ * to the heap and a std::set, and verify that both always agree on
+ * the smallest item.
+ */
+template<typename H>
+static bool
+RandomOperations(unsigned n, unsigned max_key)
+{
+  std::minstd_rand random;
+
+  std::vector<Item> items(n);
+  for (unsigned i = 0; i < n; ++i)
+    items[i].id = i;
+
+  H heap;
+  heap.reserve(n);
+  Reference reference;
+
+  for (unsigned i = 0; i < 8 * n; ++i) {
+    Item &item = items[random() % n];
+    const unsigned op = random() % 8;
+
+    if (!item.IsLinked()) {
+      item.key = random() % max_key;
+      heap.push(item);
+      reference.insert(&item);
+    } else if (op < 2) {
+      heap.erase(item);
+      reference.erase(&item);
+    } else if (op < 3) {
+      Item &top = heap.top();
+      heap.pop();
+      if (reference.empty() || *reference.begin() != &top)
+        return false;
+      reference.erase(reference.begin());
+    } else {
+      reference.erase(&item);
+      item.key = random() % max_key;
+      heap.update(item);
+      reference.insert(&item);
+    }
+
+    if (heap.size() != reference.size() ||
+        (!heap.empty() && &heap.top() != *reference.begin()))
+      return false;
+  }
+
+  /* drain */
+  while (!heap.empty()) {
+    if (&heap.top() != *reference.begin())
+      return false;
+
+    heap.pop();
+    reference.erase(reference.begin());
+  }
+
+  return reference.empty();
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(9);
+
+  Item a, b, c;
+  a.key = 3; a.id = 0;
+  b.key = 1; b.id = 1;
+  c.key = 2; c.id = 2;
+
+  Heap heap;
+  ok1(heap.empty());
+
+  heap.push(a);
+  heap.push(b);
+  heap.push(c);
+  ok1(heap.size() == 3);
+  ok1(&heap.top() == &b);
+
+  /* re-ranking an item moves it */
+  a.key = 0;
+  heap.update(a);
+  ok1(&heap.top() == &a);
+
+  heap.erase(a);
+  ok1(!a.IsLinked());
+  ok1(&heap.top() == &b);
+
+  /* a copy of a linked item is not linked */
+  Item d(b);
+  ok1(b.IsLinked() && !d.IsLinked());
+
+  ok1(RandomOperations<Heap>(1000, 100));
+  ok1(RandomOperations<BinaryHeap>(1000, 1000000));
+
+  return exit_status();
+}
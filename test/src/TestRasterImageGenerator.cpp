@@ -0,0 +1,168 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Terrain/RasterImageGenerator.hpp"
+#include "Terrain/RasterMap.hpp"
+#include "Terrain/HeightMatrix.hpp"
+#include "Terrain/Loader.hpp"
+#include "Projection/WindowProjection.hpp"
+#include "Operation/Operation.hpp"
+#include "Thread/ThreadPool.hpp"
+#include "Screen/Ramp.hpp"
+#include "Screen/RawBitmap.hpp"
+#include "Math/Angle.hpp"
+#include "Util/Macros.hpp"
+#include "TestUtil.hpp"
+
+#include <zzip/zzip.h>
+
+#include <memory>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr ColorRamp test_colors[NUM_COLOR_RAMP_LEVELS] = {
+  {0, { 0x70, 0xc0, 0xa7 }},
+  {250, { 0xca, 0xe7, 0xb9 }},
+  {500, { 0xf4, 0xea, 0xaf }},
+  {750, { 0xdc, 0xb2, 0x82 }},
+  {1000, { 0xca, 0x8e, 0x72 }},
+  {1250, { 0xde, 0xc8, 0xbd }},
+  {1500, { 0xe3, 0xe4, 0xe9 }},
+  {1750, { 0xdb, 0xd9, 0xef }},
+  {2000, { 0xce, 0xcd, 0xf5 }},
+  {2250, { 0xc2, 0xc1, 0xfa }},
+  {2500, { 0xb7, 0xb9, 0xff }},
+  {5000, { 0xb7, 0xb9, 0xff }},
+  {6000, { 0xb7, 0xb9, 0xff }}
+};
+
+/**
+ * The terrain in the test map is rather flat; a small height scale
+ * gives contour lines every 4 m.
+ */
+static constexpr unsigned height_scale = 1;
+
+static void
+Fill(HeightMatrix &matrix, const RasterMap &map,
+     const WindowProjection &projection)
+{
+#ifdef ENABLE_OPENGL
+  matrix.Fill(map, projection.GetScreenBounds(),
+              projection.GetScreenWidth() / 2,
+              projection.GetScreenHeight() / 2,
+              true);
+#else
+  matrix.Fill(map, projection, 2, true);
+#endif
+}
+
+static std::unique_ptr<RawColor[]>
+Generate(RasterImageGenerator &generator, const HeightMatrix &matrix,
+         ThreadPool &pool, unsigned n_bands, bool do_shading)
+{
+  const unsigned n = matrix.GetWidth() * matrix.GetHeight();
+  std::unique_ptr<RawColor[]> image(new RawColor[n]);
+  memset(image.get(), 0, n * sizeof(image[0]));
+
+  generator.Generate(matrix, image.get(), matrix.GetWidth(),
+                     pool, n_bands, 1, 500,
+                     do_shading, height_scale, 64, 32,
+                     Angle::Degrees(45), true);
+  return image;
+}
+
+/**
+ * Generate the image with the given number of bands, and compare it
+ * with the one generated in a single band.
+ */
+static void
+TestBands(RasterImageGenerator &generator, const HeightMatrix &matrix,
+          ThreadPool &pool, bool do_shading)
+{
+  const unsigned n = matrix.GetWidth() * matrix.GetHeight();
+  const auto expected = Generate(generator, matrix, pool, 1, do_shading);
+
+  const unsigned band_counts[] = { 2, 3, 7, matrix.GetHeight() };
+  for (unsigned n_bands : band_counts) {
+    const auto image = Generate(generator, matrix, pool, n_bands,
+                                do_shading);
+    ok(memcmp(image.get(), expected.get(), n * sizeof(image[0])) == 0,
+       "shading=%d bands=%u", do_shading, n_bands);
+  }
+}
+
+int
+main(int argc, char **argv)
+{
+  static const char map_path[] = "tmp/map.xcm";
+
+  ZZIP_DIR *dir = zzip_dir_open(map_path, nullptr);
+  if (dir == nullptr) {
+    fprintf(stderr, "Failed to open %s\n", map_path);
+    return EXIT_FAILURE;
+  }
+
+  RasterMap map;
+
+  NullOperationEnvironment operation;
+  if (!LoadTerrainOverview(dir, map.GetTileCache(), operation)) {
+    fprintf(stderr, "failed to load map\n");
+    zzip_dir_close(dir);
+    return EXIT_FAILURE;
+  }
+
+  map.UpdateProjection();
+
+  do {
+    UpdateTerrainTiles(dir, map.GetTileCache(),
+                       map.GetProjection(),
+                       map.GetMapCenter(), 50000);
+  } while (map.IsDirty());
+  zzip_dir_close(dir);
+
+  /* centered on the north-west corner of the map, so the image
+     contains cells outside of the map */
+  WindowProjection projection;
+  projection.SetScreenSize({640, 480});
+  projection.SetScaleFromRadius(50000);
+  projection.SetGeoLocation(map.GetBounds().GetNorthWest());
+  projection.SetScreenOrigin(320, 240);
+  projection.UpdateScreenBounds();
+
+  HeightMatrix matrix;
+  Fill(matrix, map, projection);
+
+  RasterImageGenerator generator;
+  generator.PrepareColorTable(test_colors, true, height_scale, 2);
+
+  ThreadPool pool("TestRasterImageGenerator", 3);
+
+  plan_tests(8);
+
+  TestBands(generator, matrix, pool, false);
+  TestBands(generator, matrix, pool, true);
+
+  return exit_status();
+}
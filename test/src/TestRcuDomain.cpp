@@ -0,0 +1,135 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Thread/RcuDomain.hpp"
+#include "TestUtil.hpp"
+
+#include <memory>
+#include <vector>
+
+struct Object {
+  bool &freed;
+
+  explicit Object(bool &_freed):freed(_freed) {
+    freed = false;
+  }
+
+  ~Object() {
+    freed = true;
+  }
+};
+
+/**
+ * A writer which retires and reclaims objects the way
+ * RasterTileCache does.
+ */
+struct Writer {
+  RcuDomain rcu;
+
+  /** retired since the last successful TryFlip() */
+  std::vector<std::unique_ptr<Object>> retired;
+
+  /** retired before the last successful TryFlip() */
+  std::vector<std::unique_ptr<Object>> expired;
+
+  void Retire(Object *object) {
+    retired.emplace_back(object);
+  }
+
+  bool Reclaim() {
+    if (!rcu.TryFlip())
+      return false;
+
+    expired.clear();
+    expired.swap(retired);
+    return true;
+  }
+};
+
+static void
+TestRetire()
+{
+  Writer writer;
+  bool freed;
+
+  {
+    const RcuDomain::ReadLease lease(writer.rcu);
+
+    /* the reader may have seen this object */
+    writer.Retire(new Object(freed));
+
+    /* the first flip succeeds, but the object is only moved to the
+       "expired" list */
+    ok1(writer.Reclaim());
+    ok1(!freed);
+
+    /* the reader is still active, so the object must survive */
+    ok1(!writer.Reclaim());
+    ok1(!writer.Reclaim());
+    ok1(!freed);
+  }
+
+  /* the reader has left */
+  ok1(writer.Reclaim());
+  ok1(freed);
+}
+
+static void
+TestNoProgress()
+{
+  RcuDomain rcu;
+
+  /* no readers: every flip succeeds */
+  ok1(rcu.TryFlip());
+  ok1(rcu.TryFlip());
+
+  std::unique_ptr<RcuDomain::ReadLease>
+    old_reader(new RcuDomain::ReadLease(rcu));
+  ok1(rcu.TryFlip());
+
+  /* the old epoch still has a reader; new readers entering the
+     current epoch do not change that */
+  bool progress = false;
+  for (unsigned i = 0; i < 16; ++i) {
+    const RcuDomain::ReadLease new_reader(rcu);
+    progress |= rcu.TryFlip();
+  }
+
+  ok1(!progress);
+
+  old_reader.reset();
+  ok1(rcu.TryFlip());
+
+  /* the readers which entered after the first flip have left, too */
+  ok1(rcu.TryFlip());
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(13);
+
+  TestRetire();
+  TestNoProgress();
+
+  return exit_status();
+}
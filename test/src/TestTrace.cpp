@@ -27,6 +27,7 @@
 #include "OS/ConvertPathName.hpp"
 #include "Engine/Trace/Trace.hpp"
 #include "Engine/Trace/Vector.hpp"
+#include "Engine/Trace/Snapshot.hpp"
 #include "Printing.hpp"
 #include "TestUtil.hpp"
 #include "Util/PrintException.hxx"
@@ -50,6 +51,59 @@ OnAdvance(Trace &trace, const GeoPoint &loc, const double alt, const double t)
   }
 }
 
+/**
+ * Are both traces made of the same points?
+ */
+static bool
+Equals(const Trace &a, const Trace &b)
+{
+  if (a.size() != b.size())
+    return false;
+
+  auto i = b.begin();
+  for (const TracePoint &point : a) {
+    if (point.GetTime() != i->GetTime() ||
+        point.GetLocation() != i->GetLocation() ||
+        !(point.GetFlatLocation() == i->GetFlatLocation()))
+      return false;
+    ++i;
+  }
+
+  return true;
+}
+
+/**
+ * Does the snapshot contain the same points as the trace, and does
+ * TraceSnapshot::CalcFlatDistances() agree with
+ * TracePoint::FlatDistanceTo()?
+ */
+static bool
+Equals(const Trace &trace, const TraceSnapshot &snapshot)
+{
+  if (trace.size() != snapshot.size())
+    return false;
+
+  if (trace.empty())
+    return true;
+
+  std::vector<unsigned> distances(snapshot.size());
+  snapshot.CalcFlatDistances(snapshot.GetFlatLocation(0), 0, snapshot.size(),
+                             distances.data());
+
+  const TracePoint &front = trace.front();
+  unsigned i = 0;
+  for (const TracePoint &point : trace) {
+    if (point.GetTime() != snapshot.GetTime(i) ||
+        !(point.GetFlatLocation() == snapshot.GetFlatLocation(i)) ||
+        point.GetIntegerAltitude() != snapshot.GetIntegerAltitude(i) ||
+        point.FlatDistanceTo(front) != distances[i])
+      return false;
+    ++i;
+  }
+
+  return true;
+}
+
 static bool
 TestTrace(Path filename, unsigned ntrace, bool output=false)
 {
@@ -58,6 +112,12 @@ TestTrace(Path filename, unsigned ntrace, bool output=false)
   printf("# %d", ntrace);  
   Trace trace(1000, ntrace);
 
+  /* a thinned trace, and a copy of it, just like the one of
+     #ContestComputer */
+  Trace thinned(0, Trace::null_time, ntrace);
+  Trace replica(0, Trace::null_time, ntrace);
+  TraceSnapshot snapshot;
+
   IGCExtensions extensions;
   extensions.clear();
 
@@ -77,10 +137,25 @@ TestTrace(Path filename, unsigned ntrace, bool output=false)
                fix.location,
                fix.gps_altitude,
                fix.time.GetSecondOfDay());
+
+    thinned.push_back(TracePoint(fix.location,
+                                 unsigned(fix.time.GetSecondOfDay()),
+                                 fix.gps_altitude, 0, 0));
+    /* update the copy only every few fixes, so it misses some
+       points before they are thinned out of the source */
+    if (i % 16 == 0)
+      replica.Replicate(thinned);
+
+    /* same for the snapshot, but at a different pace */
+    if (i % 7 == 0)
+      snapshot.Update(thinned);
   }
   putchar('\n');
   printf("# samples %d\n", i);
-  return true;
+
+  replica.Replicate(thinned);
+  snapshot.Update(thinned);
+  return Equals(thinned, replica) && Equals(thinned, snapshot);
 }
 
 
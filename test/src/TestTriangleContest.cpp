@@ -0,0 +1,120 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Engine/Contest/Solvers/OLCFAI.hpp"
+#include "Engine/Contest/Solvers/XContestTriangle.hpp"
+#include "Engine/Trace/Trace.hpp"
+#include "IGC/IGCParser.hpp"
+#include "IGC/IGCFix.hpp"
+#include "IGC/IGCExtensions.hpp"
+#include "IO/FileLineReader.hpp"
+#include "OS/Path.hpp"
+#include "Thread/ThreadPool.hpp"
+#include "TestUtil.hpp"
+#include "Util/PrintException.hxx"
+
+#include <stdexcept>
+
+static void
+ReplayIGC(Path path, Trace &trace)
+{
+  FileLineReaderA reader(path);
+  IGCExtensions extensions;
+  extensions.clear();
+
+  char *line;
+  while ((line = reader.ReadLine()) != nullptr) {
+    IGCFix fix;
+    if (IGCParseFix(line, extensions, fix) && fix.gps_valid)
+      trace.push_back(TracePoint(fix.location,
+                                 unsigned(fix.time.GetSecondOfDay()),
+                                 fix.gps_altitude, 0, 0));
+  }
+}
+
+static bool
+Equals(const ContestTraceVector &a, const ContestTraceVector &b)
+{
+  if (a.size() != b.size())
+    return false;
+
+  for (unsigned i = 0; i < a.size(); ++i)
+    if (a[i].GetTime() != b[i].GetTime() ||
+        a[i].GetLocation() != b[i].GetLocation())
+      return false;
+
+  return true;
+}
+
+/**
+ * Solve the contest exhaustively, once serially and once on a
+ * #ThreadPool, and compare the results.
+ */
+static void
+TestParallel(TriangleContest &serial, TriangleContest &parallel,
+             ThreadPool &pool)
+{
+  serial.Reset();
+  serial.Solve(true, nullptr);
+
+  parallel.SetThreadPool(&pool);
+  parallel.Reset();
+  parallel.Solve(true, nullptr);
+
+  ok1(serial.GetBestResult().score == parallel.GetBestResult().score);
+  ok1(Equals(serial.GetBestSolution(), parallel.GetBestSolution()));
+}
+
+static void
+TestTriangleContest(Path path, ThreadPool &pool)
+{
+  Trace trace(0, Trace::null_time, 512);
+  ReplayIGC(path, trace);
+
+  {
+    OLCFAI serial(trace, false), parallel(trace, false);
+    TestParallel(serial, parallel, pool);
+  }
+
+  {
+    XContestTriangle serial(trace, false, false),
+      parallel(trace, false, false);
+    TestParallel(serial, parallel, pool);
+  }
+}
+
+int main(int argc, char **argv)
+try {
+  plan_tests(12);
+
+  ThreadPool pool("TestTriangleContest", 3);
+
+  TestTriangleContest(Path(_T("test/data/0asljd01.igc")), pool);
+  TestTriangleContest(Path(_T("test/data/01lz1hq1.igc")), pool);
+  TestTriangleContest(Path(_T("test/data/9crx3101.igc")), pool);
+
+  return exit_status();
+} catch (const std::runtime_error &e) {
+  PrintException(e);
+  return EXIT_FAILURE;
+}
@@ -127,9 +127,8 @@ int main(int argc, char** argv) {
 
   map.UpdateProjection();
 
-  SharedMutex mutex;
   do {
-    UpdateTerrainTiles(dir, map.GetTileCache(), mutex,
+    UpdateTerrainTiles(dir, map.GetTileCache(),
                        map.GetProjection(),
                        map.GetMapCenter(), 50000);
   } while (map.IsDirty());
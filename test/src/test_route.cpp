@@ -148,6 +148,7 @@ test_route(const unsigned n_airspaces, const RasterMap& map)
     GlideSettings settings;
     settings.SetDefaults();
     RoutePlannerConfig config;
+    config.SetDefaults();
     config.mode = RoutePlannerConfig::Mode::BOTH;
 
     AirspaceRoute route;
@@ -203,9 +204,8 @@ main(int argc, char** argv)
 
   map.UpdateProjection();
 
-  SharedMutex mutex;
   do {
-    UpdateTerrainTiles(dir, map.GetTileCache(), mutex,
+    UpdateTerrainTiles(dir, map.GetTileCache(),
                        map.GetProjection(),
                        map.GetMapCenter(), 100000);
   } while (map.IsDirty());
@@ -46,6 +46,7 @@ test_troute(const RasterMap &map, double mwind, double mc, int ceiling)
   GlideSettings settings;
   settings.SetDefaults();
   RoutePlannerConfig config;
+  config.SetDefaults();
   config.mode = RoutePlannerConfig::Mode::BOTH;
 
   GlidePolar polar(mc);
@@ -133,9 +134,8 @@ int main(int argc, char** argv) {
 
   map.UpdateProjection();
 
-  SharedMutex mutex;
   do {
-    UpdateTerrainTiles(dir, map.GetTileCache(), mutex,
+    UpdateTerrainTiles(dir, map.GetTileCache(),
                        map.GetProjection(),
                        map.GetMapCenter(), 100000);
   } while (map.IsDirty());